@@ -8,6 +8,9 @@
 #include "ns3/assert.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/ipv6-routing-protocol.h"
+#include "ns3/uinteger.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/traffic-control-helper.h"
 
 #include "ipv6-ospf-routing-helper.h"
 
@@ -66,5 +69,29 @@ Ipv6OspfRoutingHelper::GetOspfRouting (Ptr<Ipv6> ipv6) const
   return 0;
 }
 
+// PfifoFastIpv6PacketFilterはDSCPのCS6をバンド0に振り分けるので、
+// データで混雑していてもHelloやLSUが後ろで捨てられない
+// フィルタと3つの内部キューがないとPfifoFastは分類できないので、ここでまとめて設定する
+QueueDiscContainer
+Ipv6OspfRoutingHelper::InstallControlPriorityQueueDisc (NetDeviceContainer devices) const
+{
+  NS_LOG_FUNCTION (this);
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<TrafficControlLayer> tc = (*i)->GetNode ()->GetObject<TrafficControlLayer> ();
+      NS_ASSERT_MSG (tc, "Internet stack is not installed on the node");
+      // Ipv6AddressHelperが既定のキューディスクを入れていることがある
+      if (tc->GetRootQueueDiscOnDevice (*i))
+        {
+          tc->DeleteRootQueueDiscOnDevice (*i);
+        }
+    }
+  TrafficControlHelper tch;
+  uint16_t handle = tch.SetRootQueueDisc ("ns3::PfifoFastQueueDisc");
+  tch.AddPacketFilter (handle, "ns3::PfifoFastIpv6PacketFilter");
+  tch.AddInternalQueues (handle, 3, "ns3::DropTailQueue", "MaxPackets", UintegerValue (1000));
+  return tch.Install (devices);
+}
+
 }
 }
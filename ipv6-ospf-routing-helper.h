@@ -9,6 +9,7 @@
 
 #include "ns3/node-container.h"
 #include "ns3/net-device-container.h"
+#include "ns3/queue-disc.h"
 #include "ns3/ipv6-routing-helper.h"
 #include "ipv6-ospf-routing.h"
 
@@ -27,6 +28,10 @@ public:
   virtual Ptr<Ipv6RoutingProtocol> Create (Ptr<Node> node) const;
 
   Ptr<Ipv6OspfRouting> GetOspfRouting (Ptr<Ipv6> ipv6) const;
+
+  // OSPFパケット(Traffic Class CS6)をデータより先に送り出すPfifoFastQueueDiscを設定する
+  // インターネットスタックを入れた後に呼ぶ。既にルートのキューディスクがあれば置き換える
+  QueueDiscContainer InstallControlPriorityQueueDisc (NetDeviceContainer devices) const;
 };
 
 }
@@ -12,21 +12,26 @@
 #include "ns3/ipv6-route.h"
 #include "ns3/ipv6-l3-protocol.h"
 #include "ns3/net-device.h"
-#include "ns3/point-to-point-net-device.h"
 #include "ns3/names.h"
 #include "ns3/ipv6-raw-socket-factory.h"
 #include "ns3/ipv6-routing-table-entry.h"
 #include "ns3/inet6-socket-address.h"
+#include "ns3/ipv6-packet-info-tag.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
 #include "ns3/data-rate.h"
 
 #include "ipv6-ospf-routing.h"
 
 #include "ospf-hello.h"
+#include "ospf-liveness-probe.h"
 #include "ospf-database-description.h"
 #include "ospf-link-state-request.h"
 #include "ospf-link-state-update.h"
 #include "ospf-link-state-ack.h"
+#include "ospf-constants.h"
+#include "ospf-maxflow.h"
 
 namespace ns3 {
 namespace ospf {
@@ -38,18 +43,125 @@ NS_OBJECT_ENSURE_REGISTERED (Ipv6OspfRouting);
 const Ipv6Address Ipv6OspfRouting::AllSPFRouters = Ipv6Address("ff02::5");
 const Ipv6Address Ipv6OspfRouting::AllDRRouters = Ipv6Address("ff02::6");
 uint32_t Ipv6OspfRouting::ROUTER_ID_SEED = 1;
+const Ipv6OspfRouting::PacketHandler Ipv6OspfRouting::s_packetHandlers[OSPF_TYPE_LIVENESS_PROBE + 1] = {
+    0,
+    &Ipv6OspfRouting::ReceiveHelloPacket,               // OSPF_TYPE_HELLO
+    &Ipv6OspfRouting::ReceiveDatabaseDescriptionPacket, // OSPF_TYPE_DATABASE_DESCRIPTION
+    &Ipv6OspfRouting::ReceiveLinkStateRequestPacket,    // OSPF_TYPE_LINK_STATE_REQUEST
+    &Ipv6OspfRouting::ReceiveLinkStateUpdatePacket,     // OSPF_TYPE_LINK_STATE_UPDATE
+    &Ipv6OspfRouting::ReceiveLinkStateAckPacket,        // OSPF_TYPE_LINK_STATE_ACK
+    &Ipv6OspfRouting::ReceiveLivenessProbePacket,       // OSPF_TYPE_LIVENESS_PROBE
+};
 
 TypeId Ipv6OspfRouting::GetTypeId ()
 {
     static TypeId tid = TypeId ("ns3::ospf::Ipv6OspfRouting")
                         .SetParent<Ipv6RoutingProtocol> ()
                         .SetGroupName ("Internet")
-                        .AddConstructor<Ipv6OspfRouting> ();
+                        .AddConstructor<Ipv6OspfRouting> ()
+                        .AddAttribute ("FastLivenessInterval",
+                                       "Interval of the per-interface liveness probes. Zero disables fast failure detection.",
+                                       TimeValue (Seconds (0)),
+                                       MakeTimeAccessor (&Ipv6OspfRouting::m_livenessInterval),
+                                       MakeTimeChecker ())
+                        .AddAttribute ("FastLivenessMultiplier",
+                                       "Number of consecutive missed liveness probes before the neighbor is killed.",
+                                       UintegerValue (3),
+                                       MakeUintegerAccessor (&Ipv6OspfRouting::m_livenessMultiplier),
+                                       MakeUintegerChecker<uint32_t> (1))
+                        .AddAttribute ("DdWindowSize",
+                                       "Maximum number of unacknowledged Database Description packets per adjacency. 1 keeps the standard lock-step exchange.",
+                                       UintegerValue (1),
+                                       MakeUintegerAccessor (&Ipv6OspfRouting::m_ddWindowSize),
+                                       MakeUintegerChecker<uint32_t> (1))
+                        .AddAttribute ("TrafficClass",
+                                       "IPv6 Traffic Class of sent OSPF packets. The default is CS6 (Internetwork Control).",
+                                       UintegerValue (g_trafficClassCS6),
+                                       MakeUintegerAccessor (&Ipv6OspfRouting::m_trafficClass),
+                                       MakeUintegerChecker<uint8_t> ())
+                        .AddAttribute ("MaxConcurrentAdjacencies",
+                                       "Maximum number of adjacencies in Exchange or Loading at once. Others wait in ExStart. 0 means unlimited.",
+                                       UintegerValue (0),
+                                       MakeUintegerAccessor (&Ipv6OspfRouting::m_maxConcurrentAdjacencies),
+                                       MakeUintegerChecker<uint32_t> ())
+                        .AddAttribute ("MaxLsaSize",
+                                       "Size budget in bytes for router-LSA and intra-area-prefix-LSA fragments. 0 uses the IPv6 minimum MTU (1280) minus headers.",
+                                       UintegerValue (0),
+                                       MakeUintegerAccessor (&Ipv6OspfRouting::m_maxLsaSize),
+                                       MakeUintegerChecker<uint32_t> ())
+                        .AddAttribute ("FloodWindow",
+                                       "Initial per-neighbor window of unacknowledged LSAs. It grows on LSAck and shrinks on retransmission timeout. 0 sends one LSU per retransmission interval.",
+                                       UintegerValue (0),
+                                       MakeUintegerAccessor (&Ipv6OspfRouting::m_floodWindow),
+                                       MakeUintegerChecker<uint32_t> ())
+                        .AddAttribute ("ProcessingBatchSize",
+                                       "Number of non-urgent received packets processed per batch. Hello, LSAck and liveness probes go first and SPF runs once per batch. 0 processes packets on arrival.",
+                                       UintegerValue (0),
+                                       MakeUintegerAccessor (&Ipv6OspfRouting::m_processingBatchSize),
+                                       MakeUintegerChecker<uint32_t> ())
+                        .AddAttribute ("RouterPriority",
+                                       "Router Priority advertised on broadcast interfaces. Zero makes the router ineligible to become DR or BDR.",
+                                       UintegerValue (1),
+                                       MakeUintegerAccessor (&Ipv6OspfRouting::m_routerPriority),
+                                       MakeUintegerChecker<uint8_t> ())
+                        .AddAttribute ("ReferenceBandwidth",
+                                       "Bandwidth that maps to metric 1. Interface metrics are this divided by the link data rate.",
+                                       DataRateValue (DataRate ("100Mbps")),
+                                       MakeDataRateAccessor (&Ipv6OspfRouting::SetReferenceBandwidth,
+                                                             &Ipv6OspfRouting::GetReferenceBandwidth),
+                                       MakeDataRateChecker ())
+                        .AddAttribute ("LoopFreeAlternate",
+                                       "Precompute RFC 5286 loop-free alternates and switch to them as soon as the primary interface goes down.",
+                                       BooleanValue (false),
+                                       MakeBooleanAccessor (&Ipv6OspfRouting::m_loopFreeAlternate),
+                                       MakeBooleanChecker ())
+                        .AddAttribute ("LoopFreeAlternateHoldTime",
+                                       "After switching to loop-free alternates, hold the routing table recalculation for this long so that the repaired routes are not overwritten by the immediate SPF. 0 recalculates at once.",
+                                       TimeValue (MilliSeconds (200)),
+                                       MakeTimeAccessor (&Ipv6OspfRouting::m_lfaHoldTime),
+                                       MakeTimeChecker ())
+                        .AddAttribute ("RouteEngine",
+                                       "Route computation: shortest path, or weighted multipath from the max flow towards each destination router.",
+                                       EnumValue (RouteEngine::SHORTEST_PATH),
+                                       MakeEnumAccessor (&Ipv6OspfRouting::m_routeEngine),
+                                       MakeEnumChecker (RouteEngine::SHORTEST_PATH, "ShortestPath",
+                                                        RouteEngine::MAX_FLOW, "MaxFlow"))
+                        .AddAttribute ("FloodingReduction",
+                                       "Flood only along a sparse flooding topology computed from the LSDB, falling back to full flooding on partition.",
+                                       BooleanValue (false),
+                                       MakeBooleanAccessor (&Ipv6OspfRouting::m_floodingReduction),
+                                       MakeBooleanChecker ())
+                        .AddAttribute ("LsdbDigest",
+                                       "Exchange bucketed LSDB digests during ExStart; skip to Full when they match, otherwise describe only differing buckets.",
+                                       BooleanValue (false),
+                                       MakeBooleanAccessor (&Ipv6OspfRouting::m_lsdbDigest),
+                                       MakeBooleanChecker ())
+                        .AddAttribute ("GracePeriod",
+                                       "Grace period advertised in Grace-LSAs by StartGracefulRestart.",
+                                       TimeValue (Seconds (120)),
+                                       MakeTimeAccessor (&Ipv6OspfRouting::m_gracePeriod),
+                                       MakeTimeChecker ())
+                        .AddAttribute ("GracefulRestartHelper",
+                                       "Keep advertising a neighbor that sent a Grace-LSA as fully adjacent until it resyncs or the grace period expires.",
+                                       BooleanValue (true),
+                                       MakeBooleanAccessor (&Ipv6OspfRouting::m_gracefulRestartHelper),
+                                       MakeBooleanChecker ())
+                        .AddAttribute ("StubRouterOnStartup",
+                                       "Advertise max metric on all router-LSA links for this period after start. 0 disables it.",
+                                       TimeValue (Seconds (0)),
+                                       MakeTimeAccessor (&Ipv6OspfRouting::m_stubRouterOnStartup),
+                                       MakeTimeChecker ());
     return tid;
 }
 
 Ipv6OspfRouting::Ipv6OspfRouting ()
-    : m_ipv6 (0)
+    : m_inProcessingBatch (false),
+      m_deferredCalc (false),
+      m_deferredCalcAll (false),
+      m_restarting (false),
+      m_stubRouter (false),
+      m_adjacenciesInProgress (0),
+      m_ipv6 (0)
 {
     NS_LOG_FUNCTION (m_routerId);
     // m_routingTable.SetRouterId(m_routerId);
@@ -62,6 +174,11 @@ Ipv6OspfRouting::~Ipv6OspfRouting ()
 
 void Ipv6OspfRouting::Start() {
     m_interfaces.resize(m_ipv6->GetNInterfaces ());
+    // 経路表ができあがるまでトランジットに使われないようにする
+    if (!m_stubRouterOnStartup.IsZero()) {
+        m_stubRouter = true;
+        m_stubRouterTimer = Simulator::Schedule(m_stubRouterOnStartup, &Ipv6OspfRouting::SetStubRouter, this, false);
+    }
     for (int i = 0, l = m_ipv6->GetNInterfaces (); i < l; i++)
     {
         if (m_ipv6->IsUp (i))
@@ -88,6 +205,156 @@ void Ipv6OspfRouting::SetIpv6 (Ptr<Ipv6> ipv6)
     Simulator::ScheduleNow(&Ipv6OspfRouting::Start, this);
 }
 
+void Ipv6OspfRouting::SetInterfaceArea (uint32_t ifaceIdx, uint32_t areaId) {
+    NS_LOG_FUNCTION (m_routerId << ifaceIdx << areaId);
+    m_interfaceAreas[ifaceIdx] = areaId;
+}
+
+void Ipv6OspfRouting::SetInterfacePrefixSuppression (uint32_t ifaceIdx, bool suppress) {
+    NS_LOG_FUNCTION (m_routerId << ifaceIdx << suppress);
+    if (suppress) {
+        m_prefixSuppressedIfaces.insert(ifaceIdx);
+    } else {
+        m_prefixSuppressedIfaces.erase(ifaceIdx);
+    }
+    // 起動後に変更された場合は広告し直す
+    if (ifaceIdx < m_interfaces.size() && !m_interfaces[ifaceIdx].IsState(InterfaceState::DOWN)) {
+        OriginateIntraAreaPrefixLSA(m_interfaces[ifaceIdx].GetAreaId());
+    }
+}
+
+// 隣接(FULL)のないP2Pリンクはユーザネットワークへのスタブとみなし、抑制しない
+bool Ipv6OspfRouting::IsPrefixSuppressed (uint32_t ifaceIdx) {
+    if (!m_prefixSuppressedIfaces.count(ifaceIdx)) return false;
+    InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+    return ifaceData.IsType(InterfaceType::P2P) && ifaceData.CountFullNeighbors() > 0;
+}
+
+void Ipv6OspfRouting::SetInterfaceMetric (uint32_t ifaceIdx, uint16_t metric) {
+    NS_LOG_FUNCTION (m_routerId << ifaceIdx << metric);
+    if (metric == 0) {
+        m_interfaceMetrics.erase(ifaceIdx);
+    } else {
+        m_interfaceMetrics[ifaceIdx] = metric;
+    }
+    RefreshInterfaceMetrics();
+}
+
+void Ipv6OspfRouting::SetReferenceBandwidth (DataRate referenceBandwidth) {
+    NS_LOG_FUNCTION (m_routerId << referenceBandwidth.GetBitRate());
+    m_referenceBandwidth = referenceBandwidth;
+    RefreshInterfaceMetrics();
+}
+
+DataRate Ipv6OspfRouting::GetReferenceBandwidth () const {
+    return m_referenceBandwidth;
+}
+
+void Ipv6OspfRouting::RefreshInterfaceMetrics () {
+    NS_LOG_FUNCTION (m_routerId);
+    for (uint32_t ifaceIdx = 1; ifaceIdx < m_interfaces.size(); ++ifaceIdx) {
+        InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+        uint32_t before = ifaceData.GetOutputCost();
+        ifaceData.InvalidateOutputCost();
+        if (ifaceData.IsState(InterfaceState::DOWN)) continue;
+        if (before != 0 && CalcMetricForInterface(ifaceIdx) != before) {
+            OriginateRouterSpecificLSAs(ifaceIdx);
+        }
+    }
+}
+
+void Ipv6OspfRouting::AddAreaRange (uint32_t areaId, Ipv6Address prefix, uint8_t prefixLength, bool advertise) {
+    NS_LOG_FUNCTION (m_routerId << areaId << prefix << (uint16_t)prefixLength << advertise);
+    GetArea(areaId).AddRange(prefix, prefixLength, advertise);
+}
+
+void Ipv6OspfRouting::SetStubArea (uint32_t areaId, bool noSummary, uint32_t defaultCost) {
+    NS_LOG_FUNCTION (m_routerId << areaId << noSummary << defaultCost);
+    if (areaId == g_backboneAreaId) {
+        NS_LOG_ERROR("backbone area cannot be configured as stub");
+        return;
+    }
+    GetArea(areaId).SetStub(noSummary, defaultCost);
+    // Optionsが変わるのでHelloを作り直す
+    for (uint32_t i = 0; i < m_interfaces.size(); ++i) {
+        if (m_interfaces[i].GetAreaId() == areaId) {
+            m_interfaces[i].InvalidateHelloCache();
+        }
+    }
+}
+
+AreaData& Ipv6OspfRouting::GetArea (uint32_t areaId) {
+    auto it = m_areas.find(areaId);
+    if (it == m_areas.end()) {
+        it = m_areas.insert(std::make_pair(areaId, AreaData(areaId))).first;
+    }
+    return it->second;
+}
+
+// 有効なインターフェイスが2つ以上のエリアにまたがっていればABR
+bool Ipv6OspfRouting::IsAreaBorderRouter () {
+    std::set<uint32_t> areas;
+    for (auto ifaceIdx : m_rtrIfaceId_set) {
+        if (!m_interfaces[ifaceIdx].IsActive()) continue;
+        areas.insert(m_interfaces[ifaceIdx].GetAreaId());
+    }
+    return areas.size() > 1;
+}
+
+// スタブエリアのインターフェイスではE-bitを落とす
+uint32_t Ipv6OspfRouting::GetOptionsForInterface (uint32_t ifaceIdx) {
+    uint32_t options = OSPF_OPTION_V6 | OSPF_OPTION_R;
+    if (!GetArea(m_interfaces[ifaceIdx].GetAreaId()).IsStub()) {
+        options |= OSPF_OPTION_E;
+    }
+    return options;
+}
+
+// RFC 3623 2 計画的な再起動の前に呼ぶ
+// 全インターフェイスにGrace-LSAを即座に送り、以後は経路表を保ったまま隣接を張り直す
+// インターフェイスを落とすのはこの呼び出しの後にすること
+void Ipv6OspfRouting::StartGracefulRestart () {
+    NS_LOG_FUNCTION(m_routerId);
+    if (m_restarting) {
+        return;
+    }
+    m_restarting = true;
+    m_restartNeighbors.clear();
+    for (auto ifaceIdx : m_rtrIfaceId_set) {
+        InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+        if (!ifaceData.IsActive()) continue;
+        for (auto& kv : ifaceData.GetNeighbors()) {
+            if (kv.second.IsState(NeighborState::FULL)) {
+                m_restartNeighbors.insert(std::make_pair(ifaceIdx, kv.first));
+            }
+        }
+        OriginateGraceLSA(ifaceIdx, false);
+    }
+    m_restartTimer = Simulator::Schedule(m_gracePeriod, &Ipv6OspfRouting::ExitGracefulRestart, this);
+}
+
+bool Ipv6OspfRouting::IsRestarting () const {
+    return m_restarting;
+}
+
+// 保守の前にtrueにし、迂回経路へ移ってから止める。戻すときはfalse
+// 明示的に呼んだら起動時のタイマーは取り消す
+void Ipv6OspfRouting::SetStubRouter (bool stub) {
+    NS_LOG_FUNCTION(m_routerId << stub);
+    m_stubRouterTimer.Cancel();
+    if (m_stubRouter == stub) {
+        return;
+    }
+    m_stubRouter = stub;
+    for (auto& kv : m_areas) {
+        OriginateRouterLSA(kv.first);
+    }
+}
+
+bool Ipv6OspfRouting::IsStubRouter () const {
+    return m_stubRouter;
+}
+
 // Formatted like output of "route -n" command
 void Ipv6OspfRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 {
@@ -291,7 +558,17 @@ void Ipv6OspfRouting::NotifyInterfaceUp (uint32_t ifaceIdx) {
     ifaceData.SetInterfaceId(ifaceIdx);
     m_rtrIfaceId_set.insert(ifaceIdx);
 
-    ifaceData.SetType(InterfaceType::P2P); // FIXME: 決め打ちしている
+    auto area = m_interfaceAreas.find(ifaceIdx);
+    ifaceData.SetAreaId(area != m_interfaceAreas.end() ? area->second : 1);
+    GetArea(ifaceData.GetAreaId());
+
+    // PointToPointNetDevice以外(CsmaNetDeviceなど)は共有セグメントとみなし、DR/BDRを選ぶ
+    if (m_ipv6->GetNetDevice(ifaceIdx)->IsPointToPoint()) {
+        ifaceData.SetType(InterfaceType::P2P);
+    } else {
+        ifaceData.SetType(InterfaceType::BROADCAST);
+        ifaceData.SetRouterPriority(m_routerPriority);
+    }
 
     Timer& waitTimer = ifaceData.GetWaitTimer();
     waitTimer.SetFunction(&Ipv6OspfRouting::NotifyInterfaceEvent, this);
@@ -302,44 +579,43 @@ void Ipv6OspfRouting::NotifyInterfaceUp (uint32_t ifaceIdx) {
     helloTimer.SetArguments(ifaceIdx);
     Simulator::ScheduleNow(&Ipv6OspfRouting::SendHelloPacket, this, ifaceIdx);
 
+    if (!m_livenessInterval.IsZero()) {
+        Timer& livenessTimer = ifaceData.GetLivenessTimer();
+        livenessTimer.SetFunction(&Ipv6OspfRouting::SendLivenessProbe, this);
+        livenessTimer.SetArguments(ifaceIdx);
+        livenessTimer.SetDelay(m_livenessInterval);
+        livenessTimer.Schedule();
+    }
+
     Ptr<Ipv6L3Protocol> l3 = m_ipv6->GetObject<Ipv6L3Protocol>();
     Ipv6InterfaceAddress ifaceAddr = l3->GetAddress(ifaceIdx, 0); // Link Local
 
     ifaceData.SetAddress(ifaceAddr.GetAddress());
     ifaceData.SetPrefix(ifaceAddr.GetPrefix());
 
-    // プロトコル送信用socket生成
-    Ptr<Socket> socket = Socket::CreateSocket(
-        m_ipv6->GetObject<Node>(),
-        Ipv6RawSocketFactory::GetTypeId()
-    );
-    NS_ASSERT(socket);
-
-    socket->SetRecvCallback(MakeCallback(&Ipv6OspfRouting::HandleProtocolMessage, this));
-    Inet6SocketAddress localAddr = Inet6SocketAddress(ifaceAddr.GetAddress(), PROTO_PORT);
-    NS_LOG_INFO(ifaceAddr);
-    socket->Bind(localAddr);
-    socket->SetAttribute("Protocol", UintegerValue(89)); // OSPFv3
-    socket->SetAllowBroadcast(true);
-    m_socketToIfaceIdx[socket] = ifaceIdx;
-    m_ifaceIdxToSocket[ifaceIdx] = socket;
-
-    // プロトコル受信用socket生成
-    Ptr<Socket> rcv_socket = Socket::CreateSocket(
-        m_ipv6->GetObject<Node>(),
-        Ipv6RawSocketFactory::GetTypeId()
-    );
-    NS_ASSERT(rcv_socket);
-
-    rcv_socket->SetRecvCallback(MakeCallback(&Ipv6OspfRouting::HandleProtocolMessage, this));
-    Inet6SocketAddress llmAddr = Inet6SocketAddress(Ipv6OspfRouting::AllSPFRouters, PROTO_PORT);
-    NS_LOG_INFO(ifaceAddr);
-    rcv_socket->Bind(llmAddr);
-    rcv_socket->BindToNetDevice(l3->GetNetDevice(ifaceIdx));
-    rcv_socket->SetAllowBroadcast(true);
-    rcv_socket->SetAttribute("Protocol", UintegerValue(89)); // OSPFv3
-    m_llmSocketToIfaceIdx[rcv_socket] = ifaceIdx;
-    m_ifaceIdxToLlmSocket[ifaceIdx] = rcv_socket;
+    // 送信先NetDeviceと、受信パケットのRecvIfからifaceIdxへの逆引きを登録
+    Ptr<NetDevice> device = l3->GetNetDevice(ifaceIdx);
+    if (m_ifaceIdxToDevice.size() <= ifaceIdx) {
+        m_ifaceIdxToDevice.resize(ifaceIdx + 1);
+    }
+    m_ifaceIdxToDevice[ifaceIdx] = device;
+    m_deviceToIfaceIdx[device->GetIfIndex()] = ifaceIdx;
+
+    // プロトコル送受信用socket生成（ルータに1つ）
+    if (!m_socket) {
+        m_socket = Socket::CreateSocket(
+            m_ipv6->GetObject<Node>(),
+            Ipv6RawSocketFactory::GetTypeId()
+        );
+        NS_ASSERT(m_socket);
+
+        m_socket->SetRecvCallback(MakeCallback(&Ipv6OspfRouting::HandleProtocolMessage, this));
+        m_socket->SetAttribute("Protocol", UintegerValue(89)); // OSPFv3
+        m_socket->SetAllowBroadcast(true);
+        m_socket->SetRecvPktInfo(true); // 受信インターフェイスの判別に使う
+        m_socket->SetIpv6Tclass(m_trafficClass);
+        m_socket->Bind();
+    }
 
     NotifyInterfaceEvent(ifaceIdx, InterfaceEvent::IF_UP);
 }
@@ -347,17 +623,28 @@ void Ipv6OspfRouting::NotifyInterfaceUp (uint32_t ifaceIdx) {
 void Ipv6OspfRouting::NotifyInterfaceDown (uint32_t ifaceIdx) {
     NS_LOG_FUNCTION (m_routerId << ifaceIdx);
 
+    // Graceful Restart中はフォワーディングを保つので、経路表に手を付けない
+    if (!m_restarting) {
+        ActivateLoopFreeAlternates(ifaceIdx);
+    }
     NotifyInterfaceEvent(ifaceIdx, InterfaceEvent::IF_DOWN);
 }
 
 void Ipv6OspfRouting::NotifyAddAddress (uint32_t ifaceIdx, Ipv6InterfaceAddress address) {
     NS_LOG_FUNCTION (m_routerId << ifaceIdx << address);
-    NS_LOG_ERROR (this << " - unimplemented");
+    if (ifaceIdx < m_interfaces.size()) {
+        // チェックサムの送信元アドレスが変わりうる
+        m_interfaces[ifaceIdx].InvalidateHelloCache();
+        m_interfaces[ifaceIdx].SetLivenessProbeCache(0);
+    }
 }
 
 void Ipv6OspfRouting::NotifyRemoveAddress (uint32_t ifaceIdx, Ipv6InterfaceAddress address) {
     NS_LOG_FUNCTION (m_routerId << ifaceIdx << address);
-    NS_LOG_ERROR (this << " - unimplemented");
+    if (ifaceIdx < m_interfaces.size()) {
+        m_interfaces[ifaceIdx].InvalidateHelloCache();
+        m_interfaces[ifaceIdx].SetLivenessProbeCache(0);
+    }
 }
 
 void Ipv6OspfRouting::NotifyAddRoute (
@@ -399,6 +686,25 @@ void Ipv6OspfRouting::DoDispose ()
     // }
     // m_multicastRoutes.clear ();
 
+    for (auto& kv : m_deferredOrigination) {
+        kv.second.Cancel();
+    }
+    m_deferredOrigination.clear();
+    m_deferredForceRefresh.clear();
+    m_lastOriginationTime.clear();
+    m_areas.clear();
+
+    if (m_socket) {
+        m_socket->Close();
+        m_socket = 0;
+    }
+    m_ifaceIdxToDevice.clear();
+    m_deviceToIfaceIdx.clear();
+    m_processingEvent.Cancel();
+    m_lfaHoldEvent.Cancel();
+    m_urgentPackets.clear();
+    m_bulkPackets.clear();
+
     m_ipv6 = 0;
     Ipv6RoutingProtocol::DoDispose ();
 }
@@ -411,70 +717,179 @@ void Ipv6OspfRouting::HandleProtocolMessage(Ptr<Socket> socket) {
     // 3. IP Protocolが89になっているか
     // 4. 自分が送信したパケットでないか
 
-    // - AreaIdが正しいか(ignore)
+    // - AreaIdが正しいか
     // - AllDRouters宛のとき、受け取ったIfaceがDRまたはBDRか
     // - AuTypeはそのエリアで有効なものか(ignore)
     // - パケットが認証されているか(ignore)
 
     // 各パケットごとの受け取り実装に移譲する
 
-    uint32_t ifaceIdx = m_socketToIfaceIdx.count(socket) ? m_socketToIfaceIdx[socket] : m_llmSocketToIfaceIdx[socket];
     NS_LOG_FUNCTION (m_routerId);
-    NS_LOG_INFO("routerID: " << m_routerId << ", ifaceIdx: " << ifaceIdx);
 
     Address pctSrcAddr;
     Ptr<Packet> packet = socket->RecvFrom(pctSrcAddr);
 
+    Ipv6PacketInfoTag pktInfo;
+    if (!packet->RemovePacketTag(pktInfo)) {
+        NS_LOG_WARN("packet without Ipv6PacketInfoTag is dropped");
+        return;
+    }
+    uint32_t recvIf = pktInfo.GetRecvIf();
+    auto deviceIt = m_deviceToIfaceIdx.find(recvIf);
+    if (deviceIt == m_deviceToIfaceIdx.end()) {
+        NS_LOG_LOGIC("packet from non-OSPF device " << recvIf << " is dropped");
+        return;
+    }
+    uint32_t ifaceIdx = deviceIt->second;
+    NS_LOG_INFO("routerID: " << m_routerId << ", ifaceIdx: " << ifaceIdx);
+
     Ipv6Header ipv6Header;
     packet->RemoveHeader(ipv6Header);
 
     Inet6SocketAddress inet6SrcAddr = Inet6SocketAddress::ConvertFrom(pctSrcAddr);
     Ipv6Address srcAddr = inet6SrcAddr.GetIpv6();
 
-    OSPFHeader ospfHeader;
-    packet->PeekHeader(ospfHeader);
+    // 連続領域へのコピーはここで1回だけ行い、以降はビュー越しに読む
+    uint32_t size = packet->GetSize();
+    if (m_rxBuffer.size() < size) {
+        m_rxBuffer.resize(size);
+    }
+    packet->CopyData(m_rxBuffer.data(), size);
+
+    OSPFPacketView view;
+    if (!view.Parse(m_rxBuffer.data(), size)) {
+        NS_LOG_WARN("malformed ospf packet is dropped: size " << size);
+        return;
+    }
+    if (!view.VerifyChecksum(srcAddr, ipv6Header.GetDestinationAddress())) {
+        NS_LOG_WARN("ospf packet with bad checksum is dropped: " << view.GetChecksum());
+        return;
+    }
 
     NS_LOG_LOGIC("header: received ifaceIdx " << ifaceIdx << ", srcAddr: " << srcAddr);
 
-    uint8_t ospfPacketType = ospfHeader.GetType();
-    switch (ospfPacketType) {
-        case OSPF_TYPE_HELLO: 
-            NS_LOG_LOGIC("received OSPF Header type: Hello");
-            return ReceiveHelloPacket(ifaceIdx, srcAddr, packet);
-        case OSPF_TYPE_DATABASE_DESCRIPTION: 
-            NS_LOG_LOGIC("received OSPF Header type: DatabaseDescription");
-            return ReceiveDatabaseDescriptionPacket(ifaceIdx, packet);
-        case OSPF_TYPE_LINK_STATE_REQUEST:
-            NS_LOG_LOGIC("received OSPF Header type: LinkStateRequest");
-            return ReceiveLinkStateRequestPacket(ifaceIdx, packet);
-        case OSPF_TYPE_LINK_STATE_UPDATE:
-            NS_LOG_LOGIC("received OSPF Header type: LinkStateUpdate");
-            return ReceiveLinkStateUpdatePacket(ifaceIdx, packet);
-        case OSPF_TYPE_LINK_STATE_ACK:
-            NS_LOG_LOGIC("received OSPF Header type: LinkStateAck");
-            return ReceiveLinkStateAckPacket(ifaceIdx, packet);
-        default:
-            NS_LOG_WARN("unknown ospf packet type: " << ospfPacketType);
+    // 受け取ったインターフェイスと別のエリアのパケットは捨てる(仮想リンクは未実装)
+    if (view.GetAreaId() != m_interfaces[ifaceIdx].GetAreaId()) {
+        NS_LOG_WARN("ospf packet for area " << view.GetAreaId() << " is dropped on area " << m_interfaces[ifaceIdx].GetAreaId());
+        return;
+    }
+
+    uint8_t ospfPacketType = view.GetType();
+    if (ospfPacketType == 0 || ospfPacketType > OSPF_TYPE_LIVENESS_PROBE) {
+        NS_LOG_WARN("unknown ospf packet type: " << (int)ospfPacketType);
+        return;
+    }
+    NS_LOG_LOGIC("received OSPF Header type: " << (int)ospfPacketType);
+    if (m_processingBatchSize == 0) {
+        (this->*s_packetHandlers[ospfPacketType])(ifaceIdx, srcAddr, view);
+        return;
+    }
+
+    // m_rxBufferは次の受信で上書きされるので、キューには複製を入れる
+    QueuedPacket queued;
+    queued.m_ifaceIdx = ifaceIdx;
+    queued.m_srcAddr = srcAddr;
+    queued.m_data.assign(m_rxBuffer.begin(), m_rxBuffer.begin() + size);
+    bool isUrgent = (
+        ospfPacketType == OSPF_TYPE_HELLO ||
+        ospfPacketType == OSPF_TYPE_LINK_STATE_ACK ||
+        ospfPacketType == OSPF_TYPE_LIVENESS_PROBE
+    );
+    (isUrgent ? m_urgentPackets : m_bulkPackets).push_back(std::move(queued));
+    // 同時刻に届いたパケットが全てキューに入ってから処理が始まる
+    if (!m_processingEvent.IsRunning()) {
+        m_processingEvent = Simulator::ScheduleNow(&Ipv6OspfRouting::ProcessQueuedPackets, this);
+    }
+}
+
+// 1バッチ: 緊急のパケットを全て処理してから、残りをm_processingBatchSize個まで処理する
+// バッチ中の経路表の再計算はCalcRoutingTableで保留し、最後に1回だけ行う
+void Ipv6OspfRouting::ProcessQueuedPackets () {
+    NS_LOG_FUNCTION(m_routerId << m_urgentPackets.size() << m_bulkPackets.size());
+    m_inProcessingBatch = true;
+    while (!m_urgentPackets.empty()) {
+        QueuedPacket queued = std::move(m_urgentPackets.front());
+        m_urgentPackets.pop_front();
+        DispatchQueuedPacket(queued);
+    }
+    for (uint32_t i = 0; i < m_processingBatchSize && !m_bulkPackets.empty(); ++i) {
+        QueuedPacket queued = std::move(m_bulkPackets.front());
+        m_bulkPackets.pop_front();
+        DispatchQueuedPacket(queued);
+    }
+    m_inProcessingBatch = false;
+
+    if (m_deferredCalc) {
+        bool recalcAll = m_deferredCalcAll;
+        m_deferredCalc = false;
+        m_deferredCalcAll = false;
+        CalcRoutingTable(recalcAll);
+    }
+    // 残りは次のバッチに回し、その間に届いたHelloを先に処理できるようにする
+    if (!m_urgentPackets.empty() || !m_bulkPackets.empty()) {
+        m_processingEvent = Simulator::ScheduleNow(&Ipv6OspfRouting::ProcessQueuedPackets, this);
     }
+}
+
+// キューに入れる前に検証は済んでいるので、ビューを作り直して振り分けるだけ
+void Ipv6OspfRouting::DispatchQueuedPacket (const QueuedPacket& queued) {
+    OSPFPacketView view;
+    view.Parse(queued.m_data.data(), queued.m_data.size());
+    (this->*s_packetHandlers[view.GetType()])(queued.m_ifaceIdx, queued.m_srcAddr, view);
+}
+
+// ヘッダを1度だけシリアライズし、IPv6疑似ヘッダ込みのチェックサムを埋めたパケットを作る
+Ptr<Packet> Ipv6OspfRouting::BuildPacket(uint32_t ifaceIdx, const OSPFHeader& header, Ipv6Address dstAddr) {
+    uint32_t size = header.GetSerializedSize();
+    Buffer buffer;
+    buffer.AddAtStart(size);
+    header.Serialize(buffer.Begin());
+
+    Ipv6Address srcAddr = m_ipv6->SourceAddressSelection(ifaceIdx, dstAddr);
+    uint16_t checksum = OSPFPacketView::CalcChecksum(buffer.PeekData(), size - header.GetTrailerSize(), srcAddr, dstAddr);
+    Buffer::Iterator itr = buffer.Begin();
+    itr.Next(12);
+    itr.WriteHtonU16(checksum);
+
+    return Create<Packet>(buffer.PeekData(), size);
+}
+
+void Ipv6OspfRouting::SendToInterface(uint32_t ifaceIdx, const OSPFHeader& header, Ipv6Address dstAddr) {
+    SendToInterface(ifaceIdx, BuildPacket(ifaceIdx, header, dstAddr), dstAddr);
+}
 
+// 単一のsocketを一時的に送信インターフェイスのNetDeviceへ束縛して送る
+// 送信は同期的に完了するので、受信側の束縛なし状態にはすぐ戻る
+void Ipv6OspfRouting::SendToInterface(uint32_t ifaceIdx, Ptr<Packet> packet, Ipv6Address dstAddr) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << dstAddr);
+    if (!m_socket || ifaceIdx >= m_ifaceIdxToDevice.size() || !m_ifaceIdxToDevice[ifaceIdx]) {
+        NS_LOG_WARN("no device for ifaceIdx " << ifaceIdx << " on router " << m_routerId);
+        return;
+    }
+    m_socket->BindToNetDevice(m_ifaceIdxToDevice[ifaceIdx]);
+    m_socket->SendTo(packet, 0, Inet6SocketAddress(dstAddr, PROTO_PORT));
+    m_socket->BindToNetDevice(0);
 }
 
-void Ipv6OspfRouting::RegisterToLSDB(Ptr<OSPFLSA> lsa) {
-    NS_LOG_FUNCTION(m_routerId << *lsa);
-    UpdateLSACaches(lsa);
-    m_lsdb.Add(lsa);
+void Ipv6OspfRouting::RegisterToLSDB(uint32_t areaId, Ptr<OSPFLSA> lsa) {
+    NS_LOG_FUNCTION(m_routerId << areaId << *lsa);
+    UpdateLSACaches(areaId, lsa);
+    GetArea(areaId).GetLSDB().Add(lsa);
 }
 
-void Ipv6OspfRouting::UpdateLSACaches(Ptr<OSPFLSA> lsa) {
-    RouterId advRtr = lsa->GetHeader()->GetAdvertisingRouter();
+void Ipv6OspfRouting::UpdateLSACaches(uint32_t areaId, Ptr<OSPFLSA> lsa) {
+    AreaData& area = GetArea(areaId);
+    RouterId advRtr = lsa->GetHeader().GetAdvertisingRouter();
     if (m_knownMaxRouterId < advRtr) {
         NS_LOG_INFO("m_knownMaxRouterId for " << m_routerId << " is updated: " << m_knownMaxRouterId << " -> " << advRtr);
         m_knownMaxRouterId = advRtr;
     }
+    // 格納済みのLSAをその場で再生成した場合に備える。新規の登録ならこの後のAddで反映される
+    area.GetLSDB().UpdateDigest(lsa->GetIdentifier());
 
-    switch (lsa->GetHeader()->GetType()) {
+    switch (lsa->GetHeader().GetType()) {
         case OSPF_LSA_TYPE_LINK: {
-            int32_t idx = GetInterfaceForNeighbor(advRtr);
+            int32_t idx = GetInterfaceForNeighbor(areaId, advRtr);
             if (idx != -1 && idx < m_interfaces.size()) {
                 m_interfaces[idx].AddLinkLocalLSA(advRtr, lsa);
                 break;
@@ -487,8 +902,22 @@ void Ipv6OspfRouting::UpdateLSACaches(Ptr<OSPFLSA> lsa) {
             }
             NS_LOG_ERROR("### failed to register Link-LSA ### router: " << m_routerId << ", advRtr: " << advRtr);
         } break;
+        case OSPF_LSA_TYPE_GRACE: {
+            // ネイバーのGrace-LSAなら、そのネイバーのhelperになるか、MaxAgeでやめる
+            if (advRtr == m_routerId) break;
+            int32_t idx = GetInterfaceForNeighbor(areaId, advRtr);
+            if (idx < 0) break;
+            uint16_t age = lsa->GetHeader().GetAge();
+            if (age >= g_maxAge) {
+                ExitHelperMode(idx, advRtr);
+            } else {
+                uint32_t gracePeriod = lsa->GetBody<OSPFGraceLSABody>()->GetGracePeriod();
+                EnterHelperMode(idx, advRtr, Seconds(gracePeriod > age ? gracePeriod - age : 0));
+            }
+        } break;
         case OSPF_LSA_TYPE_ROUTER: {
-            m_routerLSA_set.insert(lsa->GetIdentifier());
+            area.m_routerLSA_set.insert(lsa->GetIdentifier());
+            area.InvalidateFloodingTopology();
             auto& body = *lsa->GetBody<OSPFRouterLSABody>();
             for (int i = 0, l = body.CountNeighbors(); i < l; ++i) {
                 RouterId neighborId = body.GetNeighborRouterId(i);
@@ -499,8 +928,22 @@ void Ipv6OspfRouting::UpdateLSACaches(Ptr<OSPFLSA> lsa) {
             }
 
         } break;
+        case OSPF_LSA_TYPE_NETWORK: {
+            area.m_networkLSA_set.insert(lsa->GetIdentifier());
+            auto& body = *lsa->GetBody<OSPFNetworkLSABody>();
+            for (int i = 0, l = body.CountAttachedRouters(); i < l; ++i) {
+                RouterId attachedId = body.GetAttachedRouter(i);
+                if (m_knownMaxRouterId < attachedId) {
+                    NS_LOG_INFO("m_knownMaxRouterId for " << m_routerId << " is updated: " << m_knownMaxRouterId << " -> " << attachedId);
+                    m_knownMaxRouterId = attachedId;
+                }
+            }
+        } break;
         case OSPF_LSA_TYPE_INTRA_AREA_PREFIX: {
-            m_intraAreaPrefixLSA_set.insert(lsa->GetIdentifier());
+            area.m_intraAreaPrefixLSA_set.insert(lsa->GetIdentifier());
+        } break;
+        case OSPF_LSA_TYPE_INTER_AREA_PREFIX: {
+            area.m_interAreaPrefixLSA_set.insert(lsa->GetIdentifier());
         } break;
     }
 }
@@ -508,11 +951,16 @@ void Ipv6OspfRouting::UpdateLSACaches(Ptr<OSPFLSA> lsa) {
 void Ipv6OspfRouting::OriginateLinkLSA(uint32_t ifaceIdx, bool forceRefresh) {
     NS_LOG_FUNCTION (m_routerId << ifaceIdx);
     InterfaceData &ifaceData = m_interfaces[ifaceIdx];
+    uint32_t areaId = ifaceData.GetAreaId();
+    OSPFLSDB& lsdb = GetArea(areaId).GetLSDB();
 
     OSPFLinkStateIdentifier id(OSPF_LSA_TYPE_LINK, ifaceData.GetInterfaceId(), m_routerId);
-    // if (m_lsdb.Has(id) && !forceRefresh) {
+    if (DeferOriginationIfThrottled(areaId, id, forceRefresh)) {
+        return;
+    }
+    // if (lsdb.Has(id) && !forceRefresh) {
     //     NS_LOG_LOGIC("インスタンス再生成のみ");
-    //     OSPFLSA& lsa = m_lsdb.Get(id);
+    //     OSPFLSA& lsa = lsdb.Get(id);
     //     lsa.GetHeader()->SetAge(0);
     //     lsa.GetHeader()->IncrementSequenceNumber();
 
@@ -521,17 +969,17 @@ void Ipv6OspfRouting::OriginateLinkLSA(uint32_t ifaceIdx, bool forceRefresh) {
     // }
 
     Ptr<OSPFLSA> lsa;
-    if (m_lsdb.Has(id)) {
+    if (lsdb.Has(id)) {
         NS_LOG_LOGIC("インスタンス更新 - Link-LSA for " << m_routerId);
-        lsa = m_lsdb.Get(id);
-        OSPFLSAHeader& hdr = *lsa->GetHeader();
+        lsa = lsdb.Get(id);
+        OSPFLSAHeader& hdr = lsa->GetHeader();
         hdr.SetAge(0);
         hdr.IncrementSequenceNumber();
     } else {
         NS_LOG_LOGIC("新規インスタンス作成 - Link-LSA for " << m_routerId);
         lsa = Ptr<OSPFLSA>(new OSPFLSA());
         lsa->Initialize(OSPF_LSA_TYPE_LINK);
-        OSPFLSAHeader& hdr = *lsa->GetHeader();
+        OSPFLSAHeader& hdr = lsa->GetHeader();
         hdr.SetAge(0);
         hdr.InitializeSequenceNumber();
         hdr.SetId(ifaceData.GetInterfaceId());
@@ -541,8 +989,8 @@ void Ipv6OspfRouting::OriginateLinkLSA(uint32_t ifaceIdx, bool forceRefresh) {
     }
 
     OSPFLinkLSABody& body = *lsa->GetBody<OSPFLinkLSABody>();
-    body.SetRtrPriority(1);
-    body.SetOptions(0x13); // V6, E, R
+    body.SetRtrPriority(ifaceData.GetRouterPriority());
+    body.SetOptions(GetOptionsForInterface(ifaceIdx));
     body.SetLinkLocalAddress(ifaceData.GetAddress());
     body.ClearPrefixes();
 
@@ -563,14 +1011,15 @@ void Ipv6OspfRouting::OriginateLinkLSA(uint32_t ifaceIdx, bool forceRefresh) {
     NS_LOG_INFO("Link-LSA for #" << m_routerId << " result: " << *lsa);
 
     bool updateFlag = true;
-    if (m_lsdb.Has(id)) {
-        updateFlag = !(*m_lsdb.Get(id)->GetBody() == *lsa->GetBody());
+    if (lsdb.Has(id)) {
+        updateFlag = !(lsdb.Get(id)->GetBody() == lsa->GetBody());
     } else {
-        RegisterToLSDB(lsa);
+        RegisterToLSDB(areaId, lsa);
     }
-    UpdateLSACaches(lsa);
-    RemoveFromAllRxmtList(id);
-    AppendToRxmtList(lsa, 0/* FIXME: DR, BDRで壊れるはず */, m_routerId);
+    UpdateLSACaches(areaId, lsa);
+    m_lastOriginationTime[std::make_pair(areaId, id)] = Simulator::Now();
+    RemoveFromAllRxmtList(areaId, id);
+    AppendToRxmtList(lsa, areaId, 0/* FIXME: DR, BDRで壊れるはず */, m_routerId);
     if (updateFlag) {
         if (m_tableUpdateReducible) {
             m_tableUpdateRequired = true;
@@ -579,149 +1028,119 @@ void Ipv6OspfRouting::OriginateLinkLSA(uint32_t ifaceIdx, bool forceRefresh) {
         }
     }
 }
-void Ipv6OspfRouting::OriginateRouterLSA(bool forceRefresh) {
-    NS_LOG_FUNCTION (m_routerId);
-    OSPFLinkStateIdentifier id(OSPF_LSA_TYPE_ROUTER, m_routerId, m_routerId);
-    // if (m_lsdb.Has(id) && !forceRefresh) {
-    //     NS_LOG_LOGIC("インスタンス再生成のみ");
-    //     OSPFLSA& lsa = m_lsdb.Get(id);
-    //     lsa.GetHeader()->SetAge(0);
-    //     lsa.GetHeader()->IncrementSequenceNumber();
-
-    //     AppendToRxmtList(lsa, 0/* FIXME: DR, BDRで壊れるはず */, m_routerId);
-    //     return;
-    // }
-
-    Ptr<OSPFLSA> lsa;
-    if (m_lsdb.Has(id)) {
-        NS_LOG_LOGIC("インスタンス更新 - Router-LSA for " << m_routerId);
-        lsa = m_lsdb.Get(id);
-        OSPFLSAHeader& hdr = *lsa->GetHeader();
-        hdr.SetAge(0);
-        hdr.IncrementSequenceNumber();
-    } else {
-        NS_LOG_LOGIC("新規インスタンス作成 - Router-LSA for " << m_routerId);
-        lsa = Ptr<OSPFLSA>(new OSPFLSA());
-        lsa->Initialize(OSPF_LSA_TYPE_ROUTER);
-        OSPFLSAHeader& hdr = *lsa->GetHeader();
-        hdr.SetAge(0);
-        hdr.InitializeSequenceNumber();
-        hdr.SetId(m_routerId);
-        hdr.SetAdvertisingRouter(m_routerId);
-        // hdr.SetChecksum(uint16_t);
-        // hdr.SetLength(uint16_t);
-    }
-
-    OSPFRouterLSABody& body = *lsa->GetBody<OSPFRouterLSABody>();
-
-    body.SetOptions(0);
-    body.ClearNeighbors();
+// Link State IDはフラグメントの番号。インターフェイスをifaceIdx順にCalcInterfacesPerFragmentずつまとめる
+// 0番はリンクがなくても生成する
+void Ipv6OspfRouting::OriginateRouterLSA(uint32_t areaId, bool forceRefresh) {
+    NS_LOG_FUNCTION (m_routerId << areaId);
+    uint32_t perFragment = CalcInterfacesPerFragment(areaId, OSPF_LSA_TYPE_ROUTER);
+    // ABRならBビットを立てる。全フラグメントで揃える
+    uint16_t options = IsAreaBorderRouter() ? OSPF_ROUTER_LSA_BIT_B : 0;
+
+    std::map<uint32_t, Ptr<OSPFLSA> > fragments;
+    auto getFragment = [this, &fragments, options](uint32_t fragment) -> OSPFRouterLSABody& {
+        Ptr<OSPFLSA>& lsa = fragments[fragment];
+        if (!lsa) {
+            lsa = Ptr<OSPFLSA>(new OSPFLSA());
+            lsa->Initialize(OSPF_LSA_TYPE_ROUTER);
+            lsa->GetHeader().SetId(fragment);
+            lsa->GetHeader().SetAdvertisingRouter(m_routerId);
+            lsa->GetBody<OSPFRouterLSABody>()->SetOptions(options);
+        }
+        return *lsa->GetBody<OSPFRouterLSABody>();
+    };
+    getFragment(0);
 
     uint8_t type;
     uint32_t neighIfaceId, neighRouterId;
-    for (InterfaceData& ifaceData : m_interfaces) {
+    for (uint32_t ifaceIdx = 0, l = m_interfaces.size(); ifaceIdx < l; ++ifaceIdx) {
+        InterfaceData& ifaceData = m_interfaces[ifaceIdx];
         if (!ifaceData.IsActive()) continue;
+        if (ifaceData.GetAreaId() != areaId) continue;
 
-        uint16_t metric = CalcMetricForInterface(ifaceData.GetInterfaceId());
+        // Router-LSAのリンクはすべてトランジット用(スタブネットワークはIntra-Area-Prefix-LSA)
+        uint16_t metric = m_stubRouter ? g_maxLinkMetric : CalcMetricForInterface(ifaceData.GetInterfaceId());
         switch (ifaceData.GetType()) {
             case InterfaceType::P2P: type = 1; break;
             case InterfaceType::VIRTUAL: type = 4; break;
             default: type = 2;
         }
         if (type == 2) {
-            if (ifaceData.GetDesignatedRouter() == m_routerId) {
+            // トランジットネットワークへのリンク
+            // 自身がDRならFULLのネイバーがいるとき、そうでなければDRとFULLのときだけ載せる
+            RouterId drId = ifaceData.GetDesignatedRouter();
+            if (drId == 0) continue;
+            if (drId == m_routerId) {
+                if (!ifaceData.CountFullNeighbors()) continue;
                 neighIfaceId = ifaceData.GetInterfaceId();
                 neighRouterId = m_routerId;
             } else {
-                NeighborData& neighData = ifaceData.GetNeighbor(ifaceData.GetDesignatedRouter());
+                if (!ifaceData.HasNeighbor(drId)) continue;
+                NeighborData& neighData = ifaceData.GetNeighbor(drId);
+                if (!neighData.IsAdvertisedFull()) continue;
                 neighIfaceId = neighData.GetInterfaceId();
                 neighRouterId = neighData.GetRouterId();
             }
+            getFragment(ifaceIdx / perFragment).AddNeighbor(type, metric, ifaceData.GetInterfaceId(), neighIfaceId, neighRouterId);
         } else {
             for (auto& kv : ifaceData.GetNeighbors()) {
                 // type == 2でない場合、ネイバーは多くてもひとつしかないはず
                 NeighborData& neighData = kv.second;
+                if (!neighData.IsAdvertisedFull()) continue;
                 neighIfaceId = neighData.GetInterfaceId();
                 neighRouterId = neighData.GetRouterId();
-                body.AddNeighbor(type, metric, ifaceData.GetInterfaceId(), neighIfaceId, neighRouterId);
+                getFragment(ifaceIdx / perFragment).AddNeighbor(type, metric, ifaceData.GetInterfaceId(), neighIfaceId, neighRouterId);
                 break;
             }
         }
     }
 
-    NS_LOG_INFO("Router-LSA for #" << m_routerId << " result: " << *lsa);
-
-    bool updateFlag = true;
-    if (m_lsdb.Has(id)) {
-        updateFlag = !(*m_lsdb.Get(id)->GetBody() == *lsa->GetBody());
-    } else {
-        RegisterToLSDB(lsa);
-    }
-    UpdateLSACaches(lsa);
-    RemoveFromAllRxmtList(id);
-    AppendToRxmtList(lsa, 0/* FIXME: DR, BDRで壊れるはず */, m_routerId);
-    if (updateFlag) {
-        if (m_tableUpdateReducible) {
-            m_tableUpdateRequired = true;
-        } else {
-            CalcRoutingTable();
-        }
+    // 分割されうるときは、中身の変わらないフラグメントを作り直さない
+    bool onlyIfChanged = !forceRefresh && m_interfaces.size() > perFragment;
+    std::set<uint32_t> ids;
+    for (auto& kv : fragments) {
+        NS_LOG_INFO("Router-LSA for #" << m_routerId << " result: " << *kv.second);
+        OriginateFragment(areaId, kv.second, onlyIfChanged);
+        ids.insert(kv.first);
     }
+    FlushStaleFragments(areaId, OSPF_LSA_TYPE_ROUTER, ids);
 }
 
-void Ipv6OspfRouting::OriginateIntraAreaPrefixLSA(bool forceRefresh) {
-    NS_LOG_FUNCTION (m_routerId);
-    // 各エリアごとに実行すべきだが今の所単一エリア
+// Router-LSAと同じく、インターフェイスをifaceIdx順にまとめてフラグメントにする
+void Ipv6OspfRouting::OriginateIntraAreaPrefixLSA(uint32_t areaId, bool forceRefresh) {
+    NS_LOG_FUNCTION (m_routerId << areaId);
     // FIXME: DR用の挙動は別の関数を書いてください
+    uint32_t perFragment = CalcInterfacesPerFragment(areaId, OSPF_LSA_TYPE_INTRA_AREA_PREFIX);
+
+    std::map<uint32_t, Ptr<OSPFLSA> > fragments;
+    auto getFragment = [this, &fragments](uint32_t fragment) -> OSPFIntraAreaPrefixLSABody& {
+        Ptr<OSPFLSA>& lsa = fragments[fragment];
+        if (!lsa) {
+            lsa = Ptr<OSPFLSA>(new OSPFLSA());
+            lsa->Initialize(OSPF_LSA_TYPE_INTRA_AREA_PREFIX);
+            lsa->GetHeader().SetId(fragment);
+            lsa->GetHeader().SetAdvertisingRouter(m_routerId);
+            OSPFIntraAreaPrefixLSABody& body = *lsa->GetBody<OSPFIntraAreaPrefixLSABody>();
+            body.SetReferenceType(OSPF_LSA_TYPE_ROUTER);
+            body.SetReferenceLinkStateId(0); // 0 indicates the LSA is associated with this router
+            body.SetReferenceAdvertisedRouter (m_routerId);
+        }
+        return *lsa->GetBody<OSPFIntraAreaPrefixLSABody>();
+    };
+    getFragment(0);
 
-    OSPFLinkStateIdentifier id(OSPF_LSA_TYPE_INTRA_AREA_PREFIX, m_routerId, m_routerId);
-    // if (m_lsdb.Has(id) && !forceRefresh) {
-    //     NS_LOG_LOGIC("インスタンス再生成のみ");
-    //     OSPFLSA& lsa = m_lsdb.Get(id);
-    //     lsa.GetHeader()->SetAge(0);
-    //     lsa.GetHeader()->IncrementSequenceNumber();
-
-    //     AppendToRxmtList(lsa, 0/* FIXME: DR, BDRで壊れるはず */, m_routerId);
-    //     return;
-    // }
-
-    Ptr<OSPFLSA> lsa;
-    if (m_lsdb.Has(id)) {
-        NS_LOG_LOGIC("インスタンス更新 - Intra-Area-Prefix-LSA for " << m_routerId);
-        lsa = m_lsdb.Get(id);
-        OSPFLSAHeader& hdr = *lsa->GetHeader();
-        hdr.SetAge(0);
-        hdr.IncrementSequenceNumber();
-    } else {
-        NS_LOG_LOGIC("新規インスタンス作成 Intra-Area-Prefix-LSA for " << m_routerId);
-        lsa = Ptr<OSPFLSA>(new OSPFLSA());
-        lsa->Initialize(OSPF_LSA_TYPE_INTRA_AREA_PREFIX);
-        OSPFLSAHeader& hdr = *lsa->GetHeader();
-        hdr.SetAge(0);
-        hdr.InitializeSequenceNumber();
-        hdr.SetId(m_routerId); // FIXME: 
-        hdr.SetAdvertisingRouter(m_routerId);
-        // hdr.SetChecksum(uint16_t);
-        // hdr.SetLength(uint16_t);
-    }
-
-    OSPFIntraAreaPrefixLSABody& body = dynamic_cast<OSPFIntraAreaPrefixLSABody&>(*lsa->GetBody());
-
-    body.SetReferenceType(OSPF_LSA_TYPE_ROUTER);
-    body.SetReferenceLinkStateId(0); // 0 indicates the LSA is associated with this router
-    body.SetReferenceAdvertisedRouter (m_routerId);
-
-    body.ClearPrefixes();
-
-    // FIXME: 本来はエリアごと
     for (uint32_t ifaceIdx = 1, l = m_ipv6->GetNInterfaces (); ifaceIdx < l; ifaceIdx++) {
         InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+        if (ifaceData.GetAreaId() != areaId) continue;
         NS_LOG_INFO("ifaceIdx: " << ifaceIdx << ", addr: " << ifaceData.GetAddress() << ", ifaceState: " << ToString(ifaceData.GetState()));
         for (uint32_t i = 0, l = m_ipv6->GetNAddresses (ifaceIdx); i < l; ++i) {
             Ipv6InterfaceAddress addr = m_ipv6->GetAddress (ifaceIdx, i);
             NS_LOG_INFO("addr[" << i << "]: " << addr.GetAddress() << addr.GetPrefix());
         }
         if (ifaceData.IsState(InterfaceState::DOWN)) continue;
+        if (IsPrefixSuppressed(ifaceIdx)) {
+            NS_LOG_INFO("prefixes on interface " << ifaceIdx << " are suppressed");
+            continue;
+        }
 
         // Link Typeが2の場合、LA-bitが立ったプレフィクスだけを追加する
         // bool onlyLocal = !(
@@ -738,6 +1157,7 @@ void Ipv6OspfRouting::OriginateIntraAreaPrefixLSA(bool forceRefresh) {
         // それ以外では、グローバルなプレフィクスを全て追加する。メトリックはインターフェイスに従う。
         uint16_t metric = CalcMetricForInterface(ifaceIdx);
         uint8_t prefixLength, options;
+        uint32_t prefixes = 0;
         for (uint32_t i = 0, l = m_ipv6->GetNAddresses (ifaceIdx); i < l; ++i) {
             Ipv6InterfaceAddress addr = m_ipv6->GetAddress (ifaceIdx, i);
             if (
@@ -748,25 +1168,92 @@ void Ipv6OspfRouting::OriginateIntraAreaPrefixLSA(bool forceRefresh) {
                 NS_LOG_INFO("add prefix: " << addr.GetAddress() << addr.GetPrefix());
                 prefixLength = addr.GetPrefix().GetPrefixLength();
                 options = 0x0; // リンクに存在する唯一のルータの場合は0x2(LA-bit)とし、プレフィクス長も128bitにする（ホストアドレス扱い）
-                body.AddPrefix(addr.GetAddress(), prefixLength, metric, options);
+                getFragment(ifaceIdx / perFragment).AddPrefix(addr.GetAddress(), prefixLength, metric, options);
+                ++prefixes;
             }
         }
+        // 経路を失わないよう枠を超えても載せるが、このフラグメントはLSAの大きさの上限を超えうる
+        if (prefixes > g_prefixesPerInterfaceSlot) {
+            NS_LOG_WARN("interface " << ifaceIdx << " has " << prefixes << " global prefixes, fragment " << ifaceIdx / perFragment << " may exceed the LSA size budget");
+        }
 
         // エリアをまたいで設定された仮想リンクが存在するなら、その相手方のアドレスを128ビット、距離0で追加する
         // FIXME: 書く
     }
 
-    NS_LOG_INFO("Intra-Area-Prefix-LSA for #" << m_routerId << " result: " << *lsa);
+    bool onlyIfChanged = !forceRefresh && m_interfaces.size() > perFragment;
+    std::set<uint32_t> ids;
+    for (auto& kv : fragments) {
+        NS_LOG_INFO("Intra-Area-Prefix-LSA for #" << m_routerId << " result: " << *kv.second);
+        OriginateFragment(areaId, kv.second, onlyIfChanged);
+        ids.insert(kv.first);
+    }
+    FlushStaleFragments(areaId, OSPF_LSA_TYPE_INTRA_AREA_PREFIX, ids);
+}
+
+// LSAの大きさの上限。MaxLsaSizeが0なら、IPv6の最小MTU(1280)から
+// IPv6ヘッダ(40)、OSPFヘッダ(16)、LSUのLSA数(4)を引いたもの
+// インターフェイスのMTUには依存させない。MTUの小さいリンクが1つ増えただけで全フラグメントが組み直されるため
+uint32_t Ipv6OspfRouting::CalcLsaSizeBudget () {
+    if (m_maxLsaSize > 0) {
+        return m_maxLsaSize;
+    }
+    return 1280 - 60;
+}
+
+// 1つのフラグメントにまとめるインターフェイスの数
+// Router-LSAはインターフェイスごとに多くても1リンク(16バイト)、
+// Intra-Area-Prefix-LSAはインターフェイスごとにg_prefixesPerInterfaceSlot個分のプレフィクス(1つ最大20バイト)の枠を取る
+// アドレスやインターフェイスの状態で変わらないので、リンクやアドレスが増減しても他のフラグメントの中身はずれない
+uint32_t Ipv6OspfRouting::CalcInterfacesPerFragment (uint32_t areaId, uint16_t type) {
+    uint32_t budget = CalcLsaSizeBudget();
+    uint32_t fixedSize, entrySize;
+    if (type == OSPF_LSA_TYPE_ROUTER) {
+        fixedSize = 20 + 4;
+        entrySize = 16;
+    } else {
+        fixedSize = 20 + 12;
+        entrySize = 20 * g_prefixesPerInterfaceSlot;
+    }
+    return budget >= fixedSize + entrySize ? (budget - fixedSize) / entrySize : 1;
+}
+
+// フラグメントを1つ生成する。LSDBにあればシーケンス番号を進めて中身を差し替える
+// onlyIfChangedなら、中身が同じときは何もしない
+void Ipv6OspfRouting::OriginateFragment (uint32_t areaId, Ptr<OSPFLSA> fresh, bool onlyIfChanged) {
+    OSPFLSDB& lsdb = GetArea(areaId).GetLSDB();
+    OSPFLinkStateIdentifier id = fresh->GetIdentifier();
+    // 分割されていなければ常に作り直すので、遅延後も同じく作り直させる
+    if (DeferOriginationIfThrottled(areaId, id, !onlyIfChanged)) {
+        return;
+    }
 
+    Ptr<OSPFLSA> lsa;
     bool updateFlag = true;
-    if (m_lsdb.Has(id)) {
-        updateFlag = !(*m_lsdb.Get(id)->GetBody() == *lsa->GetBody());
+    if (lsdb.Has(id)) {
+        lsa = lsdb.Get(id);
+        updateFlag = lsdb.DetectMaxAge(id) || !(lsa->GetBody() == fresh->GetBody());
+        if (onlyIfChanged && !updateFlag) {
+            NS_LOG_LOGIC("unchanged fragment is kept: " << id);
+            return;
+        }
+        NS_LOG_LOGIC("インスタンス更新 - " << id);
+        OSPFLSAHeader& hdr = lsa->GetHeader();
+        hdr.SetAge(0);
+        hdr.IncrementSequenceNumber();
+        lsa->GetBody() = fresh->GetBody();
     } else {
-        RegisterToLSDB(lsa);
+        NS_LOG_LOGIC("新規インスタンス作成 - " << id);
+        lsa = fresh;
+        OSPFLSAHeader& hdr = lsa->GetHeader();
+        hdr.SetAge(0);
+        hdr.InitializeSequenceNumber();
+        RegisterToLSDB(areaId, lsa);
     }
-    UpdateLSACaches(lsa);
-    RemoveFromAllRxmtList(id);
-    AppendToRxmtList(lsa, 0/* FIXME: DR, BDRで壊れるはず */, m_routerId);
+    UpdateLSACaches(areaId, lsa);
+    m_lastOriginationTime[std::make_pair(areaId, id)] = Simulator::Now();
+    RemoveFromAllRxmtList(areaId, id);
+    AppendToRxmtList(lsa, areaId, 0/* FIXME: DR, BDRで壊れるはず */, m_routerId);
     if (updateFlag) {
         if (m_tableUpdateReducible) {
             m_tableUpdateRequired = true;
@@ -776,48 +1263,404 @@ void Ipv6OspfRouting::OriginateIntraAreaPrefixLSA(bool forceRefresh) {
     }
 }
 
-void Ipv6OspfRouting::OriginateRouterSpecificLSAs (uint32_t ifaceIdx, bool forceRefresh) {
-    NS_LOG_FUNCTION(m_routerId << ifaceIdx);
-    m_tableUpdateReducible = true;
-    m_tableUpdateRequired = false;
-    OriginateRouterLSA(forceRefresh);
-    OriginateLinkLSA(ifaceIdx, forceRefresh);
-    OriginateIntraAreaPrefixLSA(forceRefresh);
-    if (m_tableUpdateRequired) {
-        CalcRoutingTable();
+// 前回生成して今回生成しなかったフラグメントをMaxAgeにして流す
+void Ipv6OspfRouting::FlushStaleFragments (uint32_t areaId, uint16_t type, const std::set<uint32_t>& fragments) {
+    OSPFLSDB& lsdb = GetArea(areaId).GetLSDB();
+    std::set<uint32_t>& originated = m_lsaFragments[std::make_pair(areaId, type)];
+    for (uint32_t fragment : originated) {
+        if (fragments.count(fragment)) continue;
+        OSPFLinkStateIdentifier id(type, fragment, m_routerId);
+        auto pending = m_deferredOrigination.find(std::make_pair(areaId, id));
+        if (pending != m_deferredOrigination.end()) {
+            pending->second.Cancel();
+            m_deferredOrigination.erase(pending);
+        }
+        if (!lsdb.Has(id) || lsdb.DetectMaxAge(id)) continue;
+
+        NS_LOG_LOGIC("フラッシュ - " << id);
+        Ptr<OSPFLSA> lsa = lsdb.Get(id);
+        lsa->GetHeader().SetAge(g_maxAge);
+        RegisterToLSDB(areaId, lsa);
+        RemoveFromAllRxmtList(areaId, id);
+        AppendToRxmtList(lsa, areaId, 0, m_routerId);
+        if (m_tableUpdateReducible) {
+            m_tableUpdateRequired = true;
+        } else {
+            CalcRoutingTable();
+        }
     }
-    m_tableUpdateRequired = false;
-    m_tableUpdateReducible = false;
+    originated = fragments;
 }
 
-uint16_t Ipv6OspfRouting::CalcMetricForInterface (uint32_t ifaceIdx) {
-    NS_LOG_FUNCTION(m_routerId << ifaceIdx);
-    Ptr<NetDevice> netDevice = m_ipv6->GetNetDevice(ifaceIdx);
-    if (netDevice->IsPointToPoint()) {
-        Ptr<PointToPointNetDevice> p2pNetDev = DynamicCast<PointToPointNetDevice>(netDevice);
-        DataRateValue dataRateValue;
-        p2pNetDev->GetAttribute("DataRate", dataRateValue);
-        return (uint16_t)(1e8 / dataRateValue.Get().GetBitRate());
-    } else {
-        NS_LOG_ERROR("unknown interface device type:" << netDevice);
-    }
-    return 1;
+// 0番は常に生成している
+bool Ipv6OspfRouting::IsOriginatedFragment (uint32_t areaId, const OSPFLinkStateIdentifier& id) {
+    auto found = m_lsaFragments.find(std::make_pair(areaId, id.m_type));
+    return id.m_id == 0 || (found != m_lsaFragments.end() && found->second.count(id.m_id));
 }
 
-void Ipv6OspfRouting::ReceiveHelloPacket(uint32_t ifaceIdx, Ipv6Address srcAddr, Ptr<Packet> packet) {
-    NS_LOG_FUNCTION(m_routerId << ifaceIdx << srcAddr);
+// OSPFv2 12.4.2 Network-LSAs
+// https://tools.ietf.org/html/rfc2328#page-126
+// DRであり、FULLのネイバーが1つ以上あるときだけ生成する。そうでなければ以前のものをフラッシュする
+void Ipv6OspfRouting::OriginateNetworkLSA(uint32_t ifaceIdx, bool forceRefresh) {
+    NS_LOG_FUNCTION (m_routerId << ifaceIdx);
     InterfaceData &ifaceData = m_interfaces[ifaceIdx];
 
-    OSPFHello helloPacket;
-    packet->RemoveHeader(helloPacket);
-
-    RouterId neighborRouterId = helloPacket.GetRouterId();
+    if (!ifaceData.IsState(InterfaceState::DR) || !ifaceData.CountFullNeighbors()) {
+        FlushNetworkLSA(ifaceIdx);
+        return;
+    }
 
-    NeighborData &neighData = ifaceData.GetNeighbor(neighborRouterId);
+    uint32_t areaId = ifaceData.GetAreaId();
+    OSPFLSDB& lsdb = GetArea(areaId).GetLSDB();
+    OSPFLinkStateIdentifier id(OSPF_LSA_TYPE_NETWORK, ifaceData.GetInterfaceId(), m_routerId);
+    if (DeferOriginationIfThrottled(areaId, id, forceRefresh)) {
+        return;
+    }
 
-    bool isFirstHello = !neighData.IsInitialized();
-    if (isFirstHello) {
-        neighData.MinimalInitialize(srcAddr, helloPacket);
+    Ptr<OSPFLSA> lsa;
+    if (lsdb.Has(id)) {
+        NS_LOG_LOGIC("インスタンス更新 - Network-LSA for " << m_routerId);
+        lsa = lsdb.Get(id);
+        OSPFLSAHeader& hdr = lsa->GetHeader();
+        hdr.SetAge(0);
+        hdr.IncrementSequenceNumber();
+    } else {
+        NS_LOG_LOGIC("新規インスタンス作成 - Network-LSA for " << m_routerId);
+        lsa = Ptr<OSPFLSA>(new OSPFLSA());
+        lsa->Initialize(OSPF_LSA_TYPE_NETWORK);
+        OSPFLSAHeader& hdr = lsa->GetHeader();
+        hdr.SetAge(0);
+        hdr.InitializeSequenceNumber();
+        hdr.SetId(ifaceData.GetInterfaceId());
+        hdr.SetAdvertisingRouter(m_routerId);
+    }
+
+    OSPFNetworkLSABody& body = *lsa->GetBody<OSPFNetworkLSABody>();
+    body.SetOptions(GetOptionsForInterface(ifaceIdx));
+    body.ClearAttachedRouters();
+    body.AddAttachedRouter(m_routerId);
+    for (auto& kv : ifaceData.GetNeighbors()) {
+        if (kv.second.IsAdvertisedFull()) {
+            body.AddAttachedRouter(kv.first);
+        }
+    }
+
+    NS_LOG_INFO("Network-LSA for #" << m_routerId << " iface " << ifaceIdx << " result: " << *lsa);
+
+    bool updateFlag = true;
+    if (lsdb.Has(id)) {
+        updateFlag = !(lsdb.Get(id)->GetBody() == lsa->GetBody());
+    }
+    // フラッシュ済みのものを再生成した場合もあるので、LSDB上の経過時間を0から数え直す
+    RegisterToLSDB(areaId, lsa);
+    m_lastOriginationTime[std::make_pair(areaId, id)] = Simulator::Now();
+    RemoveFromAllRxmtList(areaId, id);
+    AppendToRxmtList(lsa, areaId, ifaceIdx, m_routerId);
+    if (updateFlag) {
+        if (m_tableUpdateReducible) {
+            m_tableUpdateRequired = true;
+        } else {
+            CalcRoutingTable();
+        }
+    }
+}
+
+// 自身のNetwork-LSAをMaxAgeにしてフラッディングする(OSPFv2 14.1 Premature aging of LSAs)
+void Ipv6OspfRouting::FlushNetworkLSA(uint32_t ifaceIdx) {
+    NS_LOG_FUNCTION (m_routerId << ifaceIdx);
+    uint32_t areaId = m_interfaces[ifaceIdx].GetAreaId();
+    OSPFLSDB& lsdb = GetArea(areaId).GetLSDB();
+    OSPFLinkStateIdentifier id(OSPF_LSA_TYPE_NETWORK, m_interfaces[ifaceIdx].GetInterfaceId(), m_routerId);
+
+    auto pending = m_deferredOrigination.find(std::make_pair(areaId, id));
+    if (pending != m_deferredOrigination.end()) {
+        pending->second.Cancel();
+        m_deferredOrigination.erase(pending);
+    }
+    if (!lsdb.Has(id) || lsdb.DetectMaxAge(id)) {
+        return;
+    }
+
+    NS_LOG_LOGIC("フラッシュ - Network-LSA for " << m_routerId << " iface " << ifaceIdx);
+    Ptr<OSPFLSA> lsa = lsdb.Get(id);
+    lsa->GetHeader().SetAge(g_maxAge);
+    RegisterToLSDB(areaId, lsa);
+    RemoveFromAllRxmtList(areaId, id);
+    AppendToRxmtList(lsa, areaId, ifaceIdx, m_routerId);
+    if (m_tableUpdateReducible) {
+        m_tableUpdateRequired = true;
+    } else {
+        CalcRoutingTable();
+    }
+}
+
+// RFC 5187 Grace-LSAはリンクローカルなので、インターフェイスごとに生成する
+// Link State IDはInterface ID。flushならMaxAgeにして流す
+// 再起動の直前に送る必要があるので、MinLSIntervalの制限を受けずにすぐ送る
+void Ipv6OspfRouting::OriginateGraceLSA(uint32_t ifaceIdx, bool flush) {
+    NS_LOG_FUNCTION (m_routerId << ifaceIdx << flush);
+    InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+    uint32_t areaId = ifaceData.GetAreaId();
+    OSPFLSDB& lsdb = GetArea(areaId).GetLSDB();
+    OSPFLinkStateIdentifier id(OSPF_LSA_TYPE_GRACE, ifaceData.GetInterfaceId(), m_routerId);
+
+    Ptr<OSPFLSA> lsa;
+    if (lsdb.Has(id)) {
+        if (flush && lsdb.DetectMaxAge(id)) {
+            return;
+        }
+        lsa = lsdb.Get(id);
+        if (!flush) {
+            lsa->GetHeader().IncrementSequenceNumber();
+        }
+    } else {
+        if (flush) {
+            return;
+        }
+        lsa = Ptr<OSPFLSA>(new OSPFLSA());
+        lsa->Initialize(OSPF_LSA_TYPE_GRACE);
+        OSPFLSAHeader& hdr = lsa->GetHeader();
+        hdr.InitializeSequenceNumber();
+        hdr.SetId(ifaceData.GetInterfaceId());
+        hdr.SetAdvertisingRouter(m_routerId);
+    }
+    lsa->GetHeader().SetAge(flush ? g_maxAge : 0);
+
+    OSPFGraceLSABody& body = *lsa->GetBody<OSPFGraceLSABody>();
+    body.SetGracePeriod(m_gracePeriod.ToInteger(Time::S));
+    body.SetRestartReason(OSPF_GRACE_REASON_SOFTWARE_RESTART);
+
+    NS_LOG_INFO("Grace-LSA for #" << m_routerId << " iface " << ifaceIdx << " result: " << *lsa);
+
+    RegisterToLSDB(areaId, lsa);
+    RemoveFromAllRxmtList(areaId, id);
+    AppendToRxmtList(lsa, areaId, ifaceIdx, m_routerId, true);
+}
+
+// RFC 3623 2.3 再起動の終了
+// Grace-LSAをフラッシュし、保留していたLSAの生成と経路表の計算をまとめて行う
+void Ipv6OspfRouting::ExitGracefulRestart() {
+    NS_LOG_FUNCTION (m_routerId);
+    if (!m_restarting) {
+        return;
+    }
+    NS_LOG_INFO("graceful restart is finished: router " << m_routerId << ", remaining adjacencies " << m_restartNeighbors.size());
+    m_restarting = false;
+    m_restartTimer.Cancel();
+    m_restartNeighbors.clear();
+    for (auto ifaceIdx : m_rtrIfaceId_set) {
+        OriginateGraceLSA(ifaceIdx, true);
+    }
+    for (auto ifaceIdx : m_rtrIfaceId_set) {
+        if (m_interfaces[ifaceIdx].IsActive()) {
+            OriginateRouterSpecificLSAs(ifaceIdx);
+        }
+    }
+    CalcRoutingTable();
+}
+
+// RFC 3623 3.1 FULLの隣接で、再送待ちに内容の変わったLSAがないときだけhelperになる
+// 既にhelperなら猶予期間を延長する
+void Ipv6OspfRouting::EnterHelperMode(uint32_t ifaceIdx, RouterId neighborRouterId, Time gracePeriod) {
+    NS_LOG_FUNCTION (m_routerId << ifaceIdx << neighborRouterId << gracePeriod);
+    NeighborData& neighData = m_interfaces[ifaceIdx].GetNeighbor(neighborRouterId);
+    if (!m_gracefulRestartHelper || m_restarting || gracePeriod.IsZero()) {
+        return;
+    }
+    if (!neighData.IsHelpingRestart() && (
+        !neighData.IsState(NeighborState::FULL) ||
+        neighData.HasChangedLSAInRxmtList(GetArea(m_interfaces[ifaceIdx].GetAreaId()).GetLSDB())
+    )) {
+        NS_LOG_LOGIC("helper mode is refused: router " << m_routerId << ", neighbor " << neighborRouterId);
+        return;
+    }
+    NS_LOG_INFO("helper mode: router " << m_routerId << ", neighbor " << neighborRouterId << ", grace period " << gracePeriod.GetSeconds() << "s");
+    neighData.SetHelpingRestart(
+        Simulator::Schedule(gracePeriod, &Ipv6OspfRouting::ExitHelperMode, this, ifaceIdx, neighborRouterId)
+    );
+}
+
+// RFC 3623 3.2 Grace-LSAのフラッシュか猶予期間の満了でhelperをやめ、LSAを作り直す
+// 猶予期間中に一度もHelloが届かなかったネイバーはここで落とす
+void Ipv6OspfRouting::ExitHelperMode(uint32_t ifaceIdx, RouterId neighborRouterId) {
+    NS_LOG_FUNCTION (m_routerId << ifaceIdx << neighborRouterId);
+    NeighborData& neighData = m_interfaces[ifaceIdx].GetNeighbor(neighborRouterId);
+    if (!neighData.IsHelpingRestart()) {
+        return;
+    }
+    NS_LOG_INFO("helper mode is finished: router " << m_routerId << ", neighbor " << neighborRouterId << ", state " << ToString(neighData.GetState()));
+    neighData.ClearHelpingRestart();
+    if (neighData.GetState() > NeighborState::DOWN && !neighData.GetInactivityTimer().IsRunning()) {
+        NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::KILL_NBR);
+    }
+    OriginateRouterSpecificLSAs(ifaceIdx);
+}
+
+// 同一LSAの生成はMinLSIntervalにつき1回まで
+// 間隔内の要求は1つの遅延イベントにまとめ、期限到来時に最新の状態で1度だけ生成する
+// まとめた要求のどれかがforceRefreshなら、遅延後の生成もforceRefreshにする
+bool Ipv6OspfRouting::DeferOriginationIfThrottled(uint32_t areaId, const OSPFLinkStateIdentifier& id, bool forceRefresh) {
+    AreaLinkStateIdentifier key = std::make_pair(areaId, id);
+    auto pending = m_deferredOrigination.find(key);
+    if (pending != m_deferredOrigination.end() && pending->second.IsRunning()) {
+        NS_LOG_LOGIC("origination of " << id << " is already deferred for " << m_routerId);
+        if (forceRefresh) {
+            m_deferredForceRefresh.insert(key);
+        }
+        return true;
+    }
+
+    auto last = m_lastOriginationTime.find(key);
+    if (last == m_lastOriginationTime.end()) {
+        return false;
+    }
+
+    Time elapsed = Simulator::Now() - last->second;
+    if (elapsed >= g_minLsInterval) {
+        return false;
+    }
+
+    NS_LOG_LOGIC("origination of " << id << " is deferred for " << m_routerId << " by " << (g_minLsInterval - elapsed).GetSeconds() << "s");
+    m_deferredOrigination[key] = Simulator::Schedule(g_minLsInterval - elapsed, &Ipv6OspfRouting::OriginateDeferredLSA, this, areaId, id);
+    if (forceRefresh) {
+        m_deferredForceRefresh.insert(key);
+    } else {
+        m_deferredForceRefresh.erase(key);
+    }
+    return true;
+}
+
+void Ipv6OspfRouting::OriginateDeferredLSA(uint32_t areaId, OSPFLinkStateIdentifier id) {
+    NS_LOG_FUNCTION(m_routerId << areaId << id);
+    AreaLinkStateIdentifier key = std::make_pair(areaId, id);
+    m_deferredOrigination.erase(key);
+    bool forceRefresh = m_deferredForceRefresh.erase(key) > 0;
+    if (m_restarting) {
+        return;
+    }
+    switch (id.m_type) {
+        case OSPF_LSA_TYPE_ROUTER:
+            OriginateRouterLSA(areaId, forceRefresh);
+            break;
+        case OSPF_LSA_TYPE_LINK:
+            // Link-LSAのLink State IDはインターフェイスIDであり、ifaceIdxと一致する
+            if (id.m_id < m_interfaces.size() && !m_interfaces[id.m_id].IsState(InterfaceState::DOWN)) {
+                OriginateLinkLSA(id.m_id, forceRefresh);
+            }
+            break;
+        case OSPF_LSA_TYPE_INTRA_AREA_PREFIX:
+            OriginateIntraAreaPrefixLSA(areaId, forceRefresh);
+            break;
+        case OSPF_LSA_TYPE_NETWORK:
+            // Network-LSAのLink State IDもDRのInterface ID
+            if (id.m_id < m_interfaces.size()) {
+                OriginateNetworkLSA(id.m_id, forceRefresh);
+            }
+            break;
+        case OSPF_LSA_TYPE_INTER_AREA_PREFIX:
+            // 経路表から広告すべきものを作り直す
+            CalcRoutingTable();
+            break;
+        default:
+            NS_LOG_WARN("deferred origination for unsupported LSA type: " << id);
+    }
+}
+
+void Ipv6OspfRouting::OriginateRouterSpecificLSAs (uint32_t ifaceIdx, bool forceRefresh) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx);
+    // RFC 3623 2.2 restarterは再起動が終わるまで自分のLSAを生成しない
+    if (m_restarting) {
+        return;
+    }
+    uint32_t areaId = m_interfaces[ifaceIdx].GetAreaId();
+    m_tableUpdateReducible = true;
+    m_tableUpdateRequired = false;
+    OriginateRouterLSA(areaId, forceRefresh);
+    OriginateLinkLSA(ifaceIdx, forceRefresh);
+    OriginateIntraAreaPrefixLSA(areaId, forceRefresh);
+    if (
+        m_interfaces[ifaceIdx].IsType(InterfaceType::BROADCAST) ||
+        m_interfaces[ifaceIdx].IsType(InterfaceType::NBMA)
+    ) {
+        OriginateNetworkLSA(ifaceIdx, forceRefresh);
+    }
+    // ABRになった、またはABRでなくなったので、他のエリアのRouter-LSAのBビットも更新する
+    bool isAreaBorderRouter = IsAreaBorderRouter();
+    if (isAreaBorderRouter != m_isAreaBorderRouter) {
+        m_isAreaBorderRouter = isAreaBorderRouter;
+        for (auto& kv : m_areas) {
+            if (kv.first != areaId) {
+                OriginateRouterLSA(kv.first, forceRefresh);
+            }
+        }
+        m_tableUpdateRequired = true;
+    }
+    if (m_tableUpdateRequired) {
+        CalcRoutingTable();
+    }
+    m_tableUpdateRequired = false;
+    m_tableUpdateReducible = false;
+}
+
+uint16_t Ipv6OspfRouting::CalcMetricForInterface (uint32_t ifaceIdx) {
+    InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+    if (ifaceData.GetOutputCost() != 0) {
+        return ifaceData.GetOutputCost();
+    }
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx);
+
+    uint64_t metric = 1;
+    auto manual = m_interfaceMetrics.find(ifaceIdx);
+    if (manual != m_interfaceMetrics.end()) {
+        metric = manual->second;
+    } else if (uint64_t bitRate = GetInterfaceBitRate(ifaceIdx)) {
+        metric = m_referenceBandwidth.GetBitRate() / bitRate;
+        metric = std::min<uint64_t>(std::max<uint64_t>(metric, 1), 0xffff);
+    }
+    NS_LOG_LOGIC("metric for interface " << ifaceIdx << ": " << metric);
+    ifaceData.SetOutputCost(metric);
+    return metric;
+}
+
+// デバイスの型によらず"DataRate"属性を探す。PointToPointNetDeviceはデバイス側、CsmaNetDeviceはチャネル側に持つ
+// 見つからなければ0
+uint64_t Ipv6OspfRouting::GetInterfaceBitRate (uint32_t ifaceIdx) {
+    Ptr<NetDevice> netDevice = m_ipv6->GetNetDevice(ifaceIdx);
+    DataRateValue dataRateValue;
+    if (netDevice->GetAttributeFailSafe("DataRate", dataRateValue)) {
+        return dataRateValue.Get().GetBitRate();
+    }
+    Ptr<Channel> channel = netDevice->GetChannel();
+    if (channel && channel->GetAttributeFailSafe("DataRate", dataRateValue)) {
+        return dataRateValue.Get().GetBitRate();
+    }
+    NS_LOG_WARN("data rate of interface " << ifaceIdx << " is unknown");
+    return 0;
+}
+
+void Ipv6OspfRouting::ReceiveHelloPacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << srcAddr);
+    InterfaceData &ifaceData = m_interfaces[ifaceIdx];
+
+    OSPFHelloView helloPacket;
+    if (!helloPacket.Parse(packet)) {
+        NS_LOG_WARN("malformed Hello is dropped");
+        return;
+    }
+
+    // OSPFv2 10.5 E-bitがエリアの設定(スタブかどうか)と一致しなければ捨てる
+    if ((helloPacket.GetOptions() & OSPF_OPTION_E) != (GetOptionsForInterface(ifaceIdx) & OSPF_OPTION_E)) {
+        NS_LOG_WARN("Hello with mismatched E-bit is dropped on area " << ifaceData.GetAreaId());
+        return;
+    }
+
+    RouterId neighborRouterId = packet.GetRouterId();
+
+    NeighborData &neighData = ifaceData.GetNeighbor(neighborRouterId);
+
+    bool isFirstHello = !neighData.IsInitialized();
+    if (isFirstHello) {
+        neighData.MinimalInitialize(srcAddr, neighborRouterId, helloPacket);
     }
 
     Timer& inactivityTimer = neighData.GetInactivityTimer();
@@ -834,7 +1677,7 @@ void Ipv6OspfRouting::ReceiveHelloPacket(uint32_t ifaceIdx, Ipv6Address srcAddr,
     if (ifaceData.IsKnownNeighbor(neighborRouterId)) {
         NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::TWOWAY_RECEIVED);
     } else {
-        neighData.Initialize(srcAddr, helloPacket);
+        neighData.Initialize(srcAddr, neighborRouterId, helloPacket);
         NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::ONEWAY_RECEIVED);
         return;
     }
@@ -842,8 +1685,9 @@ void Ipv6OspfRouting::ReceiveHelloPacket(uint32_t ifaceIdx, Ipv6Address srcAddr,
     bool flagNeighChange = false, flagBackupSeen = false;
 
     // router priority値が過去のものと異なればインターフェースステートマシンにNeighborChange発行
+    // 選出は新しいPriorityで行うので、ネイバー情報の更新後に発行する
     if (!isFirstHello && helloPacket.GetRouterPriority() != neighData.GetRouterPriority()) {
-        NotifyInterfaceEvent(ifaceIdx, InterfaceEvent::NEIGH_CHANGE);
+        flagNeighChange = true;
     }
 
     // HelloパケットのDRフィールドにネイバー自身が、BDRが0.0.0.0で、かつ受け取ったインターフェースがWaitingのとき
@@ -862,6 +1706,9 @@ void Ipv6OspfRouting::ReceiveHelloPacket(uint32_t ifaceIdx, Ipv6Address srcAddr,
         ) {
             flagNeighChange = true;
         }
+    } else if (neighData.GetDesignatedRouter() == neighborRouterId) {
+        // それまで自身をDRに指定していたネイバーが指定をやめた
+        flagNeighChange = true;
     }
 
     // HelloパケットのBDRフィールドにネイバー自身が指定されていて、かつ受け取ったインターフェースがWaitingのとき
@@ -877,41 +1724,58 @@ void Ipv6OspfRouting::ReceiveHelloPacket(uint32_t ifaceIdx, Ipv6Address srcAddr,
         ) {
             flagNeighChange = true;
         }
+    } else if (neighData.GetBackupDesignatedRouter() == neighborRouterId) {
+        // それまで自身をBDRに指定していたネイバーが指定をやめた
+        flagNeighChange = true;
     }
 
     uint32_t ifaceIdCache = neighData.GetInterfaceId();
-    neighData.Initialize(srcAddr, helloPacket);
+    neighData.Initialize(srcAddr, neighborRouterId, helloPacket);
     Simulator::ScheduleNow(&Ipv6OspfRouting::SendLinkStateUpdatePacketEntryPoint, this);
 
     if (ifaceIdCache != neighData.GetInterfaceId()) {
-        OriginateRouterLSA();
+        OriginateRouterLSA(ifaceData.GetAreaId());
     }
 
-    // TODO: ちゃんと非同期実行にする
-    // 結局中身が未実装なので不具合があるかどうかが不明
     if (flagBackupSeen) {
-        NotifyInterfaceEvent(ifaceIdx, InterfaceEvent::BACKUP_SEEN);
+        Simulator::ScheduleNow(&Ipv6OspfRouting::NotifyInterfaceEvent, this, ifaceIdx, InterfaceEvent::BACKUP_SEEN);
     }
     if (flagNeighChange) {
-        NotifyInterfaceEvent(ifaceIdx, InterfaceEvent::NEIGH_CHANGE);
+        Simulator::ScheduleNow(&Ipv6OspfRouting::NotifyInterfaceEvent, this, ifaceIdx, InterfaceEvent::NEIGH_CHANGE);
     }
 }
 
-void Ipv6OspfRouting::ReceiveDatabaseDescriptionPacket(uint32_t ifaceIdx, Ptr<Packet> packet) {
-    NS_LOG_FUNCTION(m_routerId << packet);
+void Ipv6OspfRouting::ReceiveDatabaseDescriptionPacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << srcAddr);
     NS_LOG_INFO("routerID: " << m_routerId << ", ifaceIdx: " << ifaceIdx);
     InterfaceData &ifaceData = m_interfaces[ifaceIdx];
 
-    OSPFDatabaseDescription ddPacket;
-    packet->RemoveHeader(ddPacket);
+    OSPFDatabaseDescriptionView ddPacket;
+    if (!ddPacket.Parse(packet)) {
+        NS_LOG_WARN("malformed Database Description is dropped");
+        return;
+    }
 
-    NS_LOG_INFO("received: " << ddPacket);
+    NS_LOG_INFO("received: seq " << ddPacket.GetSequenceNumber() << ", #LSAHeaders " << ddPacket.CountLSAHeaders());
 
-    RouterId neighborRouterId = ddPacket.GetRouterId();
+    RouterId neighborRouterId = packet.GetRouterId();
     NeighborData &neighData = ifaceData.GetNeighbor(neighborRouterId);
 
-    // lastReceivedDdPacketに保存する。このときLSAHeader部は本来不要
+    // lastReceivedDdPacketに保存する。LSAHeader部は保存しない
     neighData.SetLastReceivedDD(ddPacket);
+    OSPFLLSView lls;
+    const uint8_t* digest;
+    uint16_t digestLength;
+    if (
+        m_lsdbDigest && (ddPacket.GetOptions() & OSPF_OPTION_L) &&
+        lls.Parse(packet) && lls.FindTLV(OSPF_LLS_TYPE_LSDB_DIGEST, digest, digestLength)
+    ) {
+        std::vector<uint32_t> buckets(digestLength / 4);
+        for (uint32_t i = 0; i < buckets.size(); ++i) {
+            buckets[i] = OSPFPacketView::ReadU32(digest + i * 4);
+        }
+        neighData.GetLastPacket().SetLsdbDigest(buckets);
+    }
 
     // InterfaceMTUがこのルータの受け取り可能サイズを超えている場合、断片化しているのでreject
     if (ddPacket.GetMtu() > m_ipv6->GetMtu(ifaceIdx)) {
@@ -936,36 +1800,19 @@ void Ipv6OspfRouting::ReceiveDatabaseDescriptionPacket(uint32_t ifaceIdx, Ptr<Pa
         // fall through
     }
     case NeighborState::EXSTART: {
-        if (ddPacket.IsNegotiation() && m_routerId < neighborRouterId) {
-            neighData.SetAsSlave();
-            neighData.SetSequenceNumber(ddPacket.GetSequenceNumber());
-            NS_LOG_LOGIC("Exchange start: (" << m_routerId << "の視点): master - " << neighborRouterId << ", slave - " << m_routerId);
-            NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::NEGOT_DONE);
-            return;
-        } else if (
-            !(ddPacket.GetInitFlag() || ddPacket.GetMasterFlag()) &&
-            ddPacket.GetSequenceNumber () == neighData.GetSequenceNumber() &&
-            m_routerId > neighborRouterId
-        ) {
-            neighData.SetAsMaster();
-            NS_LOG_LOGIC("Exchange start: (" << m_routerId << "の視点): master - " << m_routerId << ", slave - " << neighborRouterId);
-            NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::NEGOT_DONE);
-            neighData.IncrementSequenceNumber();
-            return;
-        }
-        NS_LOG_LOGIC("EXSTARTだが何も条件を満たしていなかった");
-        NS_LOG_LOGIC("Slave条件: ddPacket.IsNegotiation() -> " << (ddPacket.IsNegotiation() ? "true" : "false") << " && m_routerId < neighborRouterId -> " << (m_routerId < neighborRouterId ? "true" : "false"));
-        NS_LOG_LOGIC("Master条件: !(ddPacket.GetInitFlag() || ddPacket.GetMasterFlag()) -> " << (!(ddPacket.GetInitFlag() || ddPacket.GetMasterFlag()) ? "true" : "false")
-            << " && ddPacket.GetSequenceNumber () == neighData.GetSequenceNumber() -> " << ddPacket.GetSequenceNumber () << " == " << neighData.GetSequenceNumber () << (ddPacket.GetSequenceNumber () == neighData.GetSequenceNumber() ? "true" : "false")
-            << " && m_routerId > neighborRouterId -> " << (m_routerId > neighborRouterId ? "true": "false"));
+        NegotiateExchange(ifaceIdx, neighborRouterId);
         return;
     }
     case NeighborState::EXCHANGE: {
+        if (neighData.IsDdWindowed()) {
+            ReceiveWindowedDatabaseDescription(ifaceIdx, neighborRouterId, ddPacket);
+            return;
+        }
         OSPFDatabaseDescription& lastPacket = neighData.GetLastPacket();
         if (
             ddPacket.GetMasterFlag() != lastPacket.GetMasterFlag() ||
             ddPacket.GetInitFlag() ||
-            ddPacket.GetOptions() != lastPacket.GetOptions() || (
+            (ddPacket.GetOptions() & ~OSPF_OPTION_L) != lastPacket.GetOptions() || (
                 neighData.IsMaster() &&
                 ddPacket.GetSequenceNumber() != neighData.GetSequenceNumber()
             ) || (
@@ -980,8 +1827,17 @@ void Ipv6OspfRouting::ReceiveDatabaseDescriptionPacket(uint32_t ifaceIdx, Ptr<Pa
     }
     case NeighborState::LOADING:
     case NeighborState::FULL: {
+        if (neighData.IsDdWindowed()) {
+            ReceiveWindowedDatabaseDescription(ifaceIdx, neighborRouterId, ddPacket);
+            return;
+        }
         OSPFDatabaseDescription& lastPacket = neighData.GetLastPacket();
-        if (ddPacket.GetOptions() != lastPacket.GetOptions()) {
+        // RFC 3623 3.2 helper中にInit付きDDが届いたら、再起動したネイバーが交換をやり直している
+        if (ddPacket.GetInitFlag() && neighData.IsHelpingRestart()) {
+            NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::SEQ_NUM_MISMATCH);
+            return;
+        }
+        if ((ddPacket.GetOptions() & ~OSPF_OPTION_L) != lastPacket.GetOptions()) {
             NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::SEQ_NUM_MISMATCH);
             return;
         }
@@ -994,18 +1850,9 @@ void Ipv6OspfRouting::ReceiveDatabaseDescriptionPacket(uint32_t ifaceIdx, Ptr<Pa
     /*
     もしlsTypeが未知またはAS-external-LSA(LS type = 5)でかつ相手がstub areaに属するネイバーなら、SeqNumMismatchを発行して処理をやめる。
     */
-    // TODO: LS Typeの確認
-    OSPFLinkStateIdentifier identifier;
-    for (auto lsaHeader : ddPacket.GetLSAHeaders()) {
-        identifier = lsaHeader->CreateIdentifier();
-        if (m_lsdb.Has(identifier)) {
-            Ptr<OSPFLSA> storedLsa = m_lsdb.Get(identifier);
-            if (lsaHeader->IsMoreRecentThan(*storedLsa->GetHeader())) {
-                neighData.AddRequestList(lsaHeader);
-            }
-        } else {
-            neighData.AddRequestList(lsaHeader);
-        }
+    if (!ProcessDatabaseDescriptionHeaders(ifaceData.GetAreaId(), neighData, ddPacket)) {
+        NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::SEQ_NUM_MISMATCH);
+        return;
     }
 
     if (neighData.IsMaster()) {
@@ -1021,21 +1868,129 @@ void Ipv6OspfRouting::ReceiveDatabaseDescriptionPacket(uint32_t ifaceIdx, Ptr<Pa
         if (!ddPacket.GetMoreFlag()) {
             NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::EXCHANGE_DONE);
             Simulator::Schedule(ifaceData.GetRouterDeadInterval(), &NeighborData::ClearLastPacket, &neighData);
-            OriginateRouterLSA(true);
         }
     }
 }
 
-void Ipv6OspfRouting::ReceiveLinkStateRequestPacket(uint32_t ifaceIdx, Ptr<Packet> packet) {
-    NS_LOG_FUNCTION(m_routerId << ifaceIdx);
+// DDに載っていたLSAヘッダのうち、自分が持っていないか古いものをRequest Listに入れる
+// スタブエリアでAS-external-LSAが載っていたらfalse
+bool Ipv6OspfRouting::ProcessDatabaseDescriptionHeaders(uint32_t areaId, NeighborData& neighData, const OSPFDatabaseDescriptionView& ddPacket) {
+    // TODO: 未知のLS Typeの確認
+    AreaData& area = GetArea(areaId);
+    OSPFLSDB& lsdb = area.GetLSDB();
+    OSPFLinkStateIdentifier identifier;
+    // RFC 5243 相手が同じか新しいインスタンスを持っているものは、こちらから記述しなくてよい
+    std::set<OSPFLinkStateIdentifier> described;
+    for (uint32_t i = 0, l = ddPacket.CountLSAHeaders(); i < l; ++i) {
+        OSPFLSAHeader lsaHeader;
+        ddPacket.GetLSAHeader(i, lsaHeader);
+        if (area.IsStub() && lsaHeader.GetType() == OSPF_LSA_TYPE_AS_EXTERNAL) {
+            NS_LOG_WARN("AS-external-LSA is advertised in stub area " << areaId);
+            return false;
+        }
+        identifier = lsaHeader.CreateIdentifier();
+        if (lsdb.Has(identifier)) {
+            Ptr<OSPFLSA> storedLsa = lsdb.Get(identifier);
+            if (lsaHeader.IsMoreRecentThan(storedLsa->GetHeader())) {
+                neighData.AddRequestList(lsaHeader);
+            }
+            if (!storedLsa->GetHeader().IsMoreRecentThan(lsaHeader)) {
+                described.insert(identifier);
+            }
+        } else {
+            neighData.AddRequestList(lsaHeader);
+        }
+    }
+    neighData.RemoveFromSummaryList(described);
+    return true;
+}
+
+// 窓付きDD交換の受信処理(EXCHANGE以降)
+// masterは応答を受けたseqを窓から外して次を送る。重複した応答は捨てる
+// slaveは新しいseqごとに応答を作って保存し、重複を受け取ったら保存した応答を再送する
+// 交換の完了はseqの取りこぼしがなく、双方のMビットが落ちたとき
+void Ipv6OspfRouting::ReceiveWindowedDatabaseDescription(uint32_t ifaceIdx, RouterId neighborRouterId, const OSPFDatabaseDescriptionView& ddPacket) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << neighborRouterId << ddPacket.GetSequenceNumber());
+    InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+    NeighborData& neighData = ifaceData.GetNeighbor(neighborRouterId);
+    int32_t seqNum = ddPacket.GetSequenceNumber();
+    bool isExchanging = neighData.IsState(NeighborState::EXCHANGE);
+
+    // 相手もmaster/slaveのどちらかを名乗っている、または交換をやり直そうとしている
+    if (ddPacket.GetInitFlag() || ddPacket.GetMasterFlag() == neighData.IsMaster()) {
+        NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::SEQ_NUM_MISMATCH);
+        return;
+    }
+
+    if (neighData.IsMaster()) {
+        if (!isExchanging || !neighData.RemoveDdWindowPacket(seqNum)) {
+            NS_LOG_LOGIC("duplicated DD response is discarded: seq " << seqNum);
+            return;
+        }
+        if (!ProcessDatabaseDescriptionHeaders(ifaceData.GetAreaId(), neighData, ddPacket)) {
+            NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::SEQ_NUM_MISMATCH);
+            return;
+        }
+        neighData.SetDdPeerMore(seqNum, ddPacket.GetMoreFlag());
+        if (
+            !neighData.HasMoreSummary() &&
+            !neighData.IsDdPeerMore() &&
+            neighData.CountDdWindowPackets() == 0
+        ) {
+            neighData.ClearDdWindow();
+            NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::EXCHANGE_DONE);
+            return;
+        }
+        SendDatabaseDescriptionWindow(ifaceIdx, neighborRouterId);
+        return;
+    }
+
+    // Slave
+    Ptr<Packet> response = neighData.GetDdWindowPacket(seqNum);
+    if (response) {
+        NS_LOG_LOGIC("retransmit DD response: seq " << seqNum);
+        SendToInterface(ifaceIdx, response->Copy(), neighData.GetAddress());
+        return;
+    }
+    if (seqNum <= neighData.GetSequenceNumber()) {
+        if (isExchanging) {
+            NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::SEQ_NUM_MISMATCH);
+        }
+        return;
+    }
+
+    // LOADING以降に届くのは、masterが完了を知る前に送った空のDD
+    if (isExchanging && !ProcessDatabaseDescriptionHeaders(ifaceData.GetAreaId(), neighData, ddPacket)) {
+        NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::SEQ_NUM_MISMATCH);
+        return;
+    }
+    neighData.SetDdPeerMore(seqNum, ddPacket.GetMoreFlag());
+    response = BuildWindowedDatabaseDescription(ifaceIdx, neighborRouterId, seqNum, false);
+    neighData.AddDdWindowPacket(seqNum, response);
+    neighData.SetSequenceNumber(neighData.GetDdContiguousSequenceNumber(neighData.GetSequenceNumber()));
+    SendToInterface(ifaceIdx, response->Copy(), neighData.GetAddress());
+
+    if (
+        isExchanging &&
+        !neighData.IsDdPeerMore() &&
+        !neighData.HasMoreSummary() &&
+        neighData.GetSequenceNumber() == neighData.GetDdMaxSequenceNumber(neighData.GetSequenceNumber())
+    ) {
+        NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::EXCHANGE_DONE);
+        Simulator::Schedule(ifaceData.GetRouterDeadInterval(), &NeighborData::ReleaseDdWindow, &neighData);
+    }
+}
+
+void Ipv6OspfRouting::ReceiveLinkStateRequestPacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << srcAddr);
     InterfaceData &ifaceData = m_interfaces[ifaceIdx];
 
-    OSPFLinkStateRequest lsrPacket;
-    packet->RemoveHeader(lsrPacket);
+    OSPFLinkStateRequestView lsrPacket;
+    lsrPacket.Parse(packet);
 
-    NS_LOG_INFO("received: " << lsrPacket);
+    NS_LOG_INFO("received: #LinkStateIdentifiers " << lsrPacket.CountLinkStateIdentifiers());
 
-    RouterId neighborRouterId = lsrPacket.GetRouterId();
+    RouterId neighborRouterId = packet.GetRouterId();
     NeighborData &neighData = ifaceData.GetNeighbor(neighborRouterId);
     /*
     ネイバーがExchange, Loading, Fullのときaccepted、それ以外はignored
@@ -1053,10 +2008,12 @@ void Ipv6OspfRouting::ReceiveLinkStateRequestPacket(uint32_t ifaceIdx, Ptr<Packe
         return;
     }
 
+    OSPFLSDB& lsdb = GetArea(ifaceData.GetAreaId()).GetLSDB();
     std::vector<Ptr<OSPFLSA> > lsas;
-    for (const OSPFLinkStateIdentifier& identifier : lsrPacket.GetLinkStateIdentifiers()) {
-        if (m_lsdb.Has(identifier)) {
-            lsas.push_back(m_lsdb.Get(identifier));
+    for (uint32_t i = 0, l = lsrPacket.CountLinkStateIdentifiers(); i < l; ++i) {
+        OSPFLinkStateIdentifier identifier = lsrPacket.GetLinkStateIdentifier(i);
+        if (lsdb.Has(identifier)) {
+            lsas.push_back(lsdb.Get(identifier));
         } else {
             NS_LOG_LOGIC("ReceiveLinkStateRequestPacket - emit BAD_LS_REQ");
             NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::BAD_LS_REQ);
@@ -1067,16 +2024,19 @@ void Ipv6OspfRouting::ReceiveLinkStateRequestPacket(uint32_t ifaceIdx, Ptr<Packe
     Simulator::ScheduleNow(&Ipv6OspfRouting::SendLinkStateUpdatePacketDirect, this, ifaceIdx, lsas, neighborRouterId);
 }
 
-void Ipv6OspfRouting::ReceiveLinkStateUpdatePacket(uint32_t ifaceIdx, Ptr<Packet> packet) {
-    NS_LOG_FUNCTION(m_routerId << ifaceIdx);
+void Ipv6OspfRouting::ReceiveLinkStateUpdatePacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << srcAddr);
     InterfaceData &ifaceData = m_interfaces[ifaceIdx];
 
-    OSPFLinkStateUpdate lsuPacket;
-    packet->RemoveHeader(lsuPacket);
+    OSPFLinkStateUpdateView lsuPacket;
+    if (!lsuPacket.Parse(packet)) {
+        NS_LOG_WARN("malformed Link State Update is dropped");
+        return;
+    }
 
-    NS_LOG_INFO("received: " << lsuPacket);
+    NS_LOG_INFO("received: #LSAs " << lsuPacket.CountLSAs());
 
-    RouterId neighborRouterId = lsuPacket.GetRouterId();
+    RouterId neighborRouterId = packet.GetRouterId();
     NeighborData &neighData = ifaceData.GetNeighbor(neighborRouterId);
 
     // DRやBDRである可能性を考慮していません！
@@ -1086,29 +2046,38 @@ void Ipv6OspfRouting::ReceiveLinkStateUpdatePacket(uint32_t ifaceIdx, Ptr<Packet
         return;
     }
 
-    std::vector<Ptr<OSPFLSAHeader> > lsasForDelayedAck;
+    uint32_t areaId = ifaceData.GetAreaId();
+    OSPFLSDB& lsdb = GetArea(areaId).GetLSDB();
+    std::vector<OSPFLSAHeader> lsasForDelayedAck;
     bool recalcRoutingTableRequired = false;
 
-    for (auto received : lsuPacket.GetLSAs()) {
+    std::vector<Ptr<OSPFLSA> > receivedLsas;
+    lsuPacket.GetLSAs(receivedLsas);
+    for (auto received : receivedLsas) {
         NS_LOG_INFO("iterate for: " << *received);
         OSPFLinkStateIdentifier identifier = received->GetIdentifier();
-        bool hasInLSDB = m_lsdb.Has(identifier);
+        bool hasInLSDB = lsdb.Has(identifier);
         bool isMoreRecent = (
             hasInLSDB &&
-            received->GetHeader()->IsMoreRecentThan(*m_lsdb.Get(identifier)->GetHeader())
+            received->GetHeader().IsMoreRecentThan(lsdb.Get(identifier)->GetHeader())
         );
         bool isSameInstance = (
             hasInLSDB &&
             !isMoreRecent &&
-            received->GetHeader()->IsSameInstance(*m_lsdb.Get(identifier)->GetHeader())
+            received->GetHeader().IsSameInstance(lsdb.Get(identifier)->GetHeader())
         );
         bool isSelfOriginated = identifier.IsOriginatedBy(m_routerId, m_rtrIfaceId_set);
 
-        // 1,2,3無視
+        // 1,2無視
+        // 3 スタブエリアではAS-external-LSAを受け取らない
+        if (identifier.m_type == OSPF_LSA_TYPE_AS_EXTERNAL && GetArea(areaId).IsStub()) {
+            NS_LOG_INFO("AS-external-LSA in stub area is discarded:" << *received);
+            continue;
+        }
         // 4
         if (
-            received->GetHeader()->GetAge() == g_maxAge &&
-            !m_lsdb.Has(identifier) &&
+            received->GetHeader().GetAge() == g_maxAge &&
+            !lsdb.Has(identifier) &&
             !ifaceData.HasExchangingNeighbor()
         ) {
             // 13.5 direct ack
@@ -1130,7 +2099,7 @@ void Ipv6OspfRouting::ReceiveLinkStateUpdatePacket(uint32_t ifaceIdx, Ptr<Packet
             if (
                 hasInLSDB &&
                 !isSelfOriginated &&
-                !m_lsdb.IsElapsedMinLsArrival(identifier)
+                !lsdb.IsElapsedMinLsArrival(identifier)
             ) {
                 NS_LOG_LOGIC("ReceiveLinkStateUpdatePacket(" << m_routerId << ", " << ifaceIdx << ") - 拒否されました: まだMinLSArrival経過していません");
                 NS_LOG_INFO("rejected:" << received);
@@ -1139,43 +2108,58 @@ void Ipv6OspfRouting::ReceiveLinkStateUpdatePacket(uint32_t ifaceIdx, Ptr<Packet
                 // 5.b
                 // 必要なネイバーに送る。DRであるときは個別に送り返す
                 NS_LOG_LOGIC("ReceiveLinkStateUpdatePacket(" << m_routerId << ", " << ifaceIdx << ") - 受け付けました");
-                AppendToRxmtList(received, ifaceIdx, neighborRouterId, true);
+                AppendToRxmtList(received, areaId, ifaceIdx, neighborRouterId, true);
                 isFlooded = true;
             }
 
             if (isSelfOriginated) {
+                // LSAを発信したくない場合は受け取ったLSAのLS AgeをMaxAgeにして再フラッディングする
+                // 1）LSAがsummary-LSAまたはAS-external-LSAであり、ルータは宛先への（広告可能な）ルートを持たない
+                // 2）network-LSAだが、ルータはもうDRでない
+                // 3）Link State IDがルータ自身のInterface IDの1つだが、広告ルータとこのルータのルータIDが等しくない
+                // FIXME: 3)はやって
+                bool toBeFlushed = (
+                    identifier.m_type == OSPF_LSA_TYPE_NETWORK && (
+                        identifier.m_id >= m_interfaces.size() ||
+                        !m_interfaces[identifier.m_id].IsState(InterfaceState::DR)
+                    )
+                ) || (
+                    identifier.m_type == OSPF_LSA_TYPE_INTER_AREA_PREFIX &&
+                    !GetArea(areaId).HasSummaryLsId(identifier.m_id)
+                ) || (
+                    // 分割をやめたか減らしたあとのフラグメント
+                    (identifier.m_type == OSPF_LSA_TYPE_ROUTER || identifier.m_type == OSPF_LSA_TYPE_INTRA_AREA_PREFIX) &&
+                    !IsOriginatedFragment(areaId, identifier)
+                );
+
                 // 13.4を見よ
                 // 受け取ったLSAがより新しい場合、シーケンス番号をそれより進めてインスタンス再生成し、flooding
-                if (isMoreRecent) {
+                if (toBeFlushed) {
+                    NS_LOG_LOGIC("received self originated lsa which is no longer advertised: flush");
+                    received->GetHeader().SetAge(g_maxAge);
+                    // flooding
+                    AppendToRxmtList(received, areaId, ifaceIdx, neighborRouterId, true);
+                    isFlooded = true;
+                } else if (isMoreRecent) {
                     NS_LOG_WARN("received lsa is self originated and more recent than stored");
                     // TODO: タイプごとにちゃんと生成する
-                    Ptr<OSPFLSA> stored = m_lsdb.Get(identifier);
-                    stored->GetHeader()->SetAge(0);
-                    stored->GetHeader()->SetSequenceNumber(
-                        received->GetHeader()->GetSequenceNumber() + 1
+                    Ptr<OSPFLSA> stored = lsdb.Get(identifier);
+                    stored->GetHeader().SetAge(0);
+                    stored->GetHeader().SetSequenceNumber(
+                        received->GetHeader().GetSequenceNumber() + 1
                     );
                     // flooding
-                    AppendToRxmtList(stored, ifaceIdx, neighborRouterId, true);
+                    AppendToRxmtList(stored, areaId, ifaceIdx, neighborRouterId, true);
                     isFlooded = true;
                 }
-
-                // LSAを発信したくない場合は受け取ったLSAのLS AgeをMaxAgeにして再フラッディングする
-                // 1）LSAがsummary-LSAまたはAS-external-LSAであり、ルータは宛先への（広告可能な）ルートを持たない
-                // 2）network-LSAだが、ルータはもうDRでない
-                // 3）Link State IDがルータ自身のInterface IDの1つだが、広告ルータとこのルータのルータIDが等しくない
-                if (false/* FIXME: やって */) {
-                    received->GetHeader()->SetAge(g_maxAge);
-                    // flooding
-                    AppendToRxmtList(received, ifaceIdx, neighborRouterId);
-                }
             }
 
             // 5.c
-            RemoveFromAllRxmtList(identifier);
+            RemoveFromAllRxmtList(areaId, identifier);
 
             // 5.d
             NS_LOG_LOGIC("新しいLSAがインストールされます！ - インストールされるLSA: " << *received);
-            RegisterToLSDB(received);
+            RegisterToLSDB(areaId, received);
             // 13.2を見よ
             recalcRoutingTableRequired = true;
 
@@ -1201,7 +2185,7 @@ void Ipv6OspfRouting::ReceiveLinkStateUpdatePacket(uint32_t ifaceIdx, Ptr<Packet
             }
 
             // 受け取ったLSAがDB内のものより古い場合
-            if (m_lsdb.Get(identifier)->IsDeprecatedInstance()) {
+            if (lsdb.Get(identifier)->IsDeprecatedInstance()) {
                 NS_LOG_INFO("DBにあるものはすでにdeprecatedだった");
                 continue;
             }
@@ -1209,7 +2193,7 @@ void Ipv6OspfRouting::ReceiveLinkStateUpdatePacket(uint32_t ifaceIdx, Ptr<Packet
             if (GetLastLSUSentTime() + g_minLsArrival <= ns3::Now()) {
                 // LSUでDB内のLSAを直接送り返す
                 NS_LOG_INFO("受け取ったものよりDBにあるものが新しいので送り返す");
-                DirectAppendToRxmtList(m_lsdb.Get(identifier), ifaceIdx, neighborRouterId);
+                DirectAppendToRxmtList(lsdb.Get(identifier), ifaceIdx, neighborRouterId);
             }
         }
 
@@ -1251,7 +2235,7 @@ void Ipv6OspfRouting::DirectAppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t ifaceId
     NS_LOG_FUNCTION(m_routerId << ifaceIdx << neighborRouterId << *lsa);
     InterfaceData& ifaceData = m_interfaces[ifaceIdx];
     NeighborData& neighData = ifaceData.GetNeighbor(neighborRouterId);
-    auto lsHdr = lsa->GetHeader();
+    const OSPFLSAHeader& lsHdr = lsa->GetHeader();
     auto identifier = lsa->GetIdentifier();
     // if (sendAsap) {
     //     SendLinkStateUpdatePacketDirectAsap(ifaceIdx, lsa, neighborRouterId);
@@ -1268,8 +2252,8 @@ void Ipv6OspfRouting::DirectAppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t ifaceId
     // 1.b
     if (!neighData.IsState(NeighborState::FULL)) {
         if (neighData.HasInRequestList(identifier)) {
-            Ptr<OSPFLSAHeader> lsHdrInReqList = neighData.GetFromRequestList(identifier);
-            if (lsHdrInReqList->IsMoreRecentThan(*lsHdr)) {
+            OSPFLSAHeader* lsHdrInReqList = neighData.GetFromRequestList(identifier);
+            if (lsHdrInReqList->IsMoreRecentThan(lsHdr)) {
                 NS_LOG_LOGIC("reject interface " << ifaceIdx << ", neighbor " << neighborRouterId << ": ReqListにあるものの方が新しい");
                 // return; // next neighbor
             }
@@ -1281,7 +2265,7 @@ void Ipv6OspfRouting::DirectAppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t ifaceId
                 NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::LOADING_DONE);
             }
 
-            if (lsHdrInReqList->IsSameInstance(*lsHdr)) {
+            if (lsHdrInReqList->IsSameInstance(lsHdr)) {
                 NS_LOG_LOGIC("reject interface " << ifaceIdx << ", neighbor " << neighborRouterId << ": ReqListにあるものと同じ");
                 // return; // next neighbor
             }
@@ -1291,52 +2275,181 @@ void Ipv6OspfRouting::DirectAppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t ifaceId
     }
 
     // 1.c
-    // if (lsHdr->GetAdvertisingRouter() == neighData.GetRouterId()) {
+    // if (lsHdr.GetAdvertisingRouter() == neighData.GetRouterId()) {
     //     NS_LOG_LOGIC("reject interface " << ifaceIdx << ", neighbor " << neighborRouterId << ": 発行ルータがこのネイバーだった");
     //     return; // next neighbor
     // }
 
     // 1.d
-    if (sendAsap) {
+    FloodToNeighbor(ifaceIdx, neighborRouterId, lsa, sendAsap);
+}
+
+// 窓付きフラッディングでは、すぐ送るものもRxmt Listに入れて確認応答を待つ
+// RFC 3623 3.2 helper中のネイバーに内容の変わったLSAを送るなら、LSDBはもう一致しないのでhelperをやめる
+// フラッディングの途中でLSAを作り直さないよう、やめるのは次のイベントで行う
+void Ipv6OspfRouting::FloodToNeighbor (uint32_t ifaceIdx, RouterId neighborRouterId, Ptr<OSPFLSA> lsa, bool sendAsap) {
+    NeighborData& neighData = m_interfaces[ifaceIdx].GetNeighbor(neighborRouterId);
+    if (
+        neighData.IsHelpingRestart() &&
+        !lsa->GetHeader().IsLinkLocalScope() &&
+        GetArea(m_interfaces[ifaceIdx].GetAreaId()).GetLSDB().IsChangedInstance(lsa)
+    ) {
+        NS_LOG_INFO("changed LSA " << lsa->GetIdentifier() << " is flooded to restarting neighbor " << neighborRouterId);
+        Simulator::ScheduleNow(&Ipv6OspfRouting::ExitHelperMode, this, ifaceIdx, neighborRouterId);
+    }
+    if (m_floodWindow > 0) {
+        AddToRxmtList(ifaceIdx, neighborRouterId, lsa);
+        // 同時に入れたLSAはまとめて送る
+        EventId& event = neighData.GetFloodEvent();
+        if (!event.IsRunning()) {
+            event = Simulator::ScheduleNow(&Ipv6OspfRouting::SendLinkStateUpdateWindow, this, ifaceIdx, neighborRouterId);
+        }
+    } else if (sendAsap) {
         SendLinkStateUpdatePacketDirectAsap(ifaceIdx, lsa, neighborRouterId);
     } else {
         AddToRxmtList(ifaceIdx, neighborRouterId, lsa);
     }
 }
 
-void Ipv6OspfRouting::AppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t receivedIfaceIdx, RouterId senderRouterId, bool sendAsap) {
-    NS_LOG_FUNCTION(m_routerId << receivedIfaceIdx << senderRouterId << *lsa << (sendAsap ? "asap" : ""));
-    Ptr<OSPFLSAHeader> lsHdr = lsa->GetHeader();
-    OSPFLinkStateIdentifier identifier = lsa->GetIdentifier();
-    bool isAlreadyAddedToRxmtList = false;
-    uint32_t targetArea = m_interfaces[receivedIfaceIdx].GetAreaId();
-
-    for (auto ifaceIdx : m_rtrIfaceId_set) {
-        InterfaceData& ifaceData = m_interfaces[ifaceIdx];
-        NS_LOG_LOGIC("AppendToRxmtList("<<m_routerId<<", "<<receivedIfaceIdx<<") from "<<senderRouterId<<": iface #" << ifaceIdx << "");
-        if (!ifaceData.IsActive()) {
-            NS_LOG_LOGIC("reject interface " << ifaceIdx << ": inactive");
-            continue;
+// エリア内のP2Pリンク(双方のRouter-LSAに載っているもの)から、疎なフラッディングトポロジを作る
+// 最小のルータIDを根にID昇順でたどる幅優先木と、最大のルータIDを根にID降順でたどる幅優先木の和を取り、
+// さらに次数1のルータにはもう1本足して、1リンクの故障で分断しにくくする
+// 全ルータが同じLSDBから同じ結果を得るので、どのルータのトポロジも一致する
+void Ipv6OspfRouting::CalcFloodingTopology (uint32_t areaId) {
+    NS_LOG_FUNCTION(m_routerId << areaId);
+    AreaData& area = GetArea(areaId);
+    OSPFLSDB& lsdb = area.GetLSDB();
+
+    std::map<RouterId, std::set<RouterId> > advertised;
+    for (auto& id : area.m_routerLSA_set) {
+        if (lsdb.DetectMaxAge(id)) continue;
+        Ptr<OSPFLSA> lsa = lsdb.Get(id);
+        RouterId routerId = lsa->GetHeader().GetAdvertisingRouter();
+        auto body = lsa->GetBody<OSPFRouterLSABody>();
+        std::set<RouterId>& neighbors = advertised[routerId];
+        for (uint32_t idx = 0, l = body->CountNeighbors(); idx < l; ++idx) {
+            if (body->GetType(idx) == 1) {
+                neighbors.insert(body->GetNeighborRouterId(idx));
+            }
         }
-        if (
-            lsHdr->GetType() != OSPF_LSA_TYPE_AS_EXTERNAL &&
-            ifaceData.GetAreaId() != targetArea
+    }
+    std::map<RouterId, std::set<RouterId> > adjacents;
+    for (auto& kv : advertised) {
+        for (RouterId neighborId : kv.second) {
+            auto other = advertised.find(neighborId);
+            if (other != advertised.end() && other->second.count(kv.first)) {
+                adjacents[kv.first].insert(neighborId);
+            }
+        }
+    }
+
+    std::set<std::pair<RouterId, RouterId> > links;
+    std::map<RouterId, uint32_t> degrees;
+    auto addLink = [&links, &degrees](RouterId a, RouterId b) {
+        if (links.insert(a < b ? std::make_pair(a, b) : std::make_pair(b, a)).second) {
+            degrees[a]++;
+            degrees[b]++;
+        }
+    };
+    bool connected = !advertised.empty();
+    for (int pass = 0; pass < 2 && connected; ++pass) {
+        RouterId root = pass == 0 ? advertised.begin()->first : advertised.rbegin()->first;
+        std::set<RouterId> visited;
+        std::queue<RouterId> que;
+        visited.insert(root);
+        que.push(root);
+        while (!que.empty()) {
+            RouterId curr = que.front();
+            que.pop();
+            std::vector<RouterId> nexts(adjacents[curr].begin(), adjacents[curr].end());
+            if (pass == 1) std::reverse(nexts.begin(), nexts.end());
+            for (RouterId next : nexts) {
+                if (visited.insert(next).second) {
+                    addLink(curr, next);
+                    que.push(next);
+                }
+            }
+        }
+        connected = visited.size() == advertised.size();
+    }
+    if (connected) {
+        for (auto& kv : adjacents) {
+            if (degrees[kv.first] != 1) continue;
+            for (RouterId neighborId : kv.second) {
+                if (!links.count(kv.first < neighborId ? std::make_pair(kv.first, neighborId) : std::make_pair(neighborId, kv.first))) {
+                    addLink(kv.first, neighborId);
+                    break;
+                }
+            }
+        }
+    }
+    NS_LOG_INFO("flooding topology for area " << areaId << ": " << links.size() << " links, connected: " << connected);
+    area.SetFloodingTopology(links, connected);
+}
+
+// 自身のトポロジ上の隣接が全てFULLのときだけ、フラッディングを絞る
+bool Ipv6OspfRouting::IsFloodingReduced (uint32_t areaId) {
+    if (!m_floodingReduction) return false;
+    AreaData& area = GetArea(areaId);
+    if (!area.IsFloodingTopologyValid()) {
+        CalcFloodingTopology(areaId);
+    }
+    if (!area.IsFloodingTopologyConnected()) return false;
+    for (auto& link : area.GetFloodingLinks()) {
+        if (link.first != m_routerId && link.second != m_routerId) continue;
+        RouterId neighborId = link.first == m_routerId ? link.second : link.first;
+        int32_t ifaceIdx = GetInterfaceForNeighbor(areaId, neighborId);
+        if (ifaceIdx < 0 || !m_interfaces[ifaceIdx].GetNeighbor(neighborId).IsState(NeighborState::FULL)) {
+            NS_LOG_LOGIC("flooding neighbor " << neighborId << " is not full, fall back to full flooding");
+            return false;
+        }
+    }
+    return true;
+}
+
+// areaIdはLSAを載せるLSDBのエリア。自己生成のものはreceivedIfaceIdxを0にする
+void Ipv6OspfRouting::AppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t targetArea, uint32_t receivedIfaceIdx, RouterId senderRouterId, bool sendAsap) {
+    NS_LOG_FUNCTION(m_routerId << targetArea << receivedIfaceIdx << senderRouterId << *lsa << (sendAsap ? "asap" : ""));
+    const OSPFLSAHeader& lsHdr = lsa->GetHeader();
+    OSPFLinkStateIdentifier identifier = lsa->GetIdentifier();
+    bool isAlreadyAddedToRxmtList = false;
+    bool isReducedOut = false;
+    bool floodingReduced = !lsHdr.IsLinkLocalScope() && IsFloodingReduced(targetArea);
+    AreaData& area = GetArea(targetArea);
+
+    for (auto ifaceIdx : m_rtrIfaceId_set) {
+        InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+        NS_LOG_LOGIC("AppendToRxmtList("<<m_routerId<<", "<<receivedIfaceIdx<<") from "<<senderRouterId<<": iface #" << ifaceIdx << "");
+        if (!ifaceData.IsActive()) {
+            NS_LOG_LOGIC("reject interface " << ifaceIdx << ": inactive");
+            continue;
+        }
+        if (
+            lsHdr.GetType() != OSPF_LSA_TYPE_AS_EXTERNAL &&
+            ifaceData.GetAreaId() != targetArea
         ) {
             NS_LOG_LOGIC("reject interface " << ifaceIdx << ": AS-external && area unmatched");
             continue; // next iface
         }
+        if (
+            lsHdr.GetType() == OSPF_LSA_TYPE_AS_EXTERNAL &&
+            GetArea(ifaceData.GetAreaId()).IsStub()
+        ) {
+            NS_LOG_LOGIC("reject interface " << ifaceIdx << ": AS-external && stub area");
+            continue; // next iface
+        }
 
         // https://tools.ietf.org/html/rfc5340#section-4.5.2
-        if (lsHdr->IsAreaScope()) {
+        if (lsHdr.IsAreaScope()) {
             if (ifaceData.GetAreaId() != targetArea) {
                 NS_LOG_LOGIC("reject interface " << ifaceIdx << ": area unmatched");
                 continue; // next iface
             }
         }
 
-        if (lsHdr->IsLinkLocalScope()) {
-            if (lsa->GetBody<OSPFLinkLSABody>()) {
-                OSPFLinkLSABody& body = *lsa->GetBody<OSPFLinkLSABody>();
+        if (lsHdr.IsLinkLocalScope()) {
+            if (OSPFLinkLSABody* linkBody = lsa->GetBody<OSPFLinkLSABody>()) {
+                OSPFLinkLSABody& body = *linkBody;
                 bool onValidLink = body.GetLinkLocalAddress() == ifaceData.GetAddress();
                 if (!onValidLink) {
                     for (auto& kv : ifaceData.GetNeighbors()) {
@@ -1351,10 +2464,15 @@ void Ipv6OspfRouting::AppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t receivedIface
                     NS_LOG_LOGIC("reject interface " << ifaceIdx << ": link-local");
                     continue; // next iface
                 }
+            } else if (lsa->GetBody<OSPFGraceLSABody>() && !ifaceData.IsIndex(receivedIfaceIdx)) {
+                // Grace-LSAは生成されたリンクにだけ流す
+                NS_LOG_LOGIC("reject interface " << ifaceIdx << ": link-local");
+                continue; // next iface
             }
         }
 
         isAlreadyAddedToRxmtList = false;
+        isReducedOut = false;
         // 1
         NS_LOG_LOGIC("AppendToRxmtList("<<m_routerId<<", "<<receivedIfaceIdx<<") from "<<senderRouterId<<": iface #" << ifaceIdx << " - neighbors " << ifaceData.CountNeighbors());
         for (auto& kv : ifaceData.GetNeighbors()) {
@@ -1368,8 +2486,8 @@ void Ipv6OspfRouting::AppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t receivedIface
             // 1.b
             if (!neighData.IsState(NeighborState::FULL)) {
                 if (neighData.HasInRequestList(identifier)) {
-                    Ptr<OSPFLSAHeader> lsHdrInReqList = neighData.GetFromRequestList(identifier);
-                    if (lsHdrInReqList->IsMoreRecentThan(*lsHdr)) {
+                    OSPFLSAHeader* lsHdrInReqList = neighData.GetFromRequestList(identifier);
+                    if (lsHdrInReqList->IsMoreRecentThan(lsHdr)) {
                         NS_LOG_LOGIC("reject interface " << ifaceIdx << ", neighbor " << kv.first << ": ReqListにあるものの方が新しい");
                         continue; // next neighbor
                     }
@@ -1381,7 +2499,7 @@ void Ipv6OspfRouting::AppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t receivedIface
                         NotifyNeighborEvent(ifaceIdx, kv.first, NeighborEvent::LOADING_DONE);
                     }
 
-                    if (lsHdrInReqList->IsSameInstance(*lsHdr)) {
+                    if (lsHdrInReqList->IsSameInstance(lsHdr)) {
                         NS_LOG_LOGIC("reject interface " << ifaceIdx << ", neighbor " << kv.first << ": ReqListにあるものと同じ");
                         continue; // next neighbor
                     }
@@ -1390,18 +2508,25 @@ void Ipv6OspfRouting::AppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t receivedIface
                 }
             }
             // 1.c
-            if (lsHdr->GetAdvertisingRouter() == neighData.GetRouterId()) {
+            if (lsHdr.GetAdvertisingRouter() == neighData.GetRouterId()) {
                 NS_LOG_LOGIC("reject interface " << ifaceIdx << ", neighbor " << kv.first << ": 発行ルータがこのネイバーだった");
                 continue; // next neighbor
             }
 
-            // 1.d
-            
-            if (sendAsap) {
-                SendLinkStateUpdatePacketDirectAsap(ifaceIdx, lsa, kv.first);
-            } else {
-                AddToRxmtList(ifaceIdx, kv.first, lsa);
+            // フラッディングトポロジに載っていないP2Pの隣接には送らない
+            if (
+                floodingReduced &&
+                ifaceData.IsType(InterfaceType::P2P) &&
+                neighData.IsState(NeighborState::FULL) &&
+                !area.IsOnFloodingTopology(m_routerId, kv.first)
+            ) {
+                NS_LOG_LOGIC("reject interface " << ifaceIdx << ", neighbor " << kv.first << ": フラッディングトポロジ外");
+                isReducedOut = true;
+                continue; // next neighbor
             }
+
+            // 1.d
+            FloodToNeighbor(ifaceIdx, kv.first, lsa, sendAsap);
             isAlreadyAddedToRxmtList = true;
             NS_LOG_LOGIC("accepted on interface " << ifaceIdx << ", neighbor " << kv.first);
         }
@@ -1411,6 +2536,10 @@ void Ipv6OspfRouting::AppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t receivedIface
             NS_LOG_LOGIC("accept interface " << ifaceIdx << ": ネイバーのRxmtListに入れたので終わり");
             continue; // next iface
         }
+        if (isReducedOut) {
+            NS_LOG_LOGIC("reject interface " << ifaceIdx << ": フラッディングトポロジ外");
+            continue; // next iface
+        }
 
         // 3
         if (
@@ -1446,17 +2575,17 @@ Time& Ipv6OspfRouting::GetLastLSUSentTime () {
     return m_lastLsuSendTime;
 }
 
-void Ipv6OspfRouting::ReceiveLinkStateAckPacket(uint32_t ifaceIdx, Ptr<Packet> packet) {
-    NS_LOG_FUNCTION(m_routerId << ifaceIdx);
+void Ipv6OspfRouting::ReceiveLinkStateAckPacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << srcAddr);
     InterfaceData &ifaceData = m_interfaces[ifaceIdx];
     if (!ifaceData.IsActive()) return;
 
-    OSPFLinkStateAck lsaPacket;
-    packet->RemoveHeader(lsaPacket);
+    OSPFLinkStateAckView lsaPacket;
+    lsaPacket.Parse(packet);
 
-    NS_LOG_INFO("received: " << lsaPacket);
+    NS_LOG_INFO("received: #LSAHeaders " << lsaPacket.CountLSAHeaders());
 
-    RouterId neighborRouterId = lsaPacket.GetRouterId();
+    RouterId neighborRouterId = packet.GetRouterId();
     NeighborData &neighData = ifaceData.GetNeighbor(neighborRouterId);
     /*
     細かい送信条件はFlooding Procedureを参照
@@ -1471,19 +2600,23 @@ void Ipv6OspfRouting::ReceiveLinkStateAckPacket(uint32_t ifaceIdx, Ptr<Packet> p
         return;
     }
     
-    std::vector<Ptr<OSPFLSA> >& rxmtList = neighData.GetRxmtList();
     // std::vector<Ptr<OSPFLSAHeader> >& lsaList = lsaPacket.GetLSAHeaders();
-    for (auto ackedLsaHdr : lsaPacket.GetLSAHeaders()) {
-        for (auto iter = rxmtList.begin(); iter != rxmtList.end(); ) {
-            if (ackedLsaHdr->IsSameInstance(*((*iter)->GetHeader()))) {
-                NS_LOG_LOGIC("Remove from rxmt list: " << ackedLsaHdr);
-                iter = rxmtList.erase(iter);
-                break;
-            } else {
-                ++iter;
+    OSPFLSAHeader ackedLsaHdr;
+    bool acked = false;
+    for (uint32_t i = 0, l = lsaPacket.CountLSAHeaders(); i < l; ++i) {
+        lsaPacket.GetLSAHeader(i, ackedLsaHdr);
+        if (neighData.AckRxmtList(ackedLsaHdr)) {
+            NS_LOG_LOGIC("Remove from rxmt list: " << ackedLsaHdr);
+            if (m_floodWindow > 0) {
+                neighData.OnFloodAcked();
             }
+            acked = true;
         }
     }
+    // 確認応答で窓が空いたので続きを送る
+    if (acked && m_floodWindow > 0) {
+        SendLinkStateUpdateWindow(ifaceIdx, neighborRouterId);
+    }
     // for (
     //     auto it = rxmtList.begin();
     //     it != rxmtList.end();
@@ -1504,15 +2637,41 @@ void Ipv6OspfRouting::ReceiveLinkStateAckPacket(uint32_t ifaceIdx, Ptr<Packet> p
     // }
 }
 
-void Ipv6OspfRouting::RemoveFromAllRxmtList(OSPFLinkStateIdentifier &identifier) {
-    NS_LOG_FUNCTION(m_routerId);
-    if(m_lsdb.Has(identifier))
+void Ipv6OspfRouting::ReceiveLivenessProbePacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << srcAddr);
+    if (m_livenessInterval.IsZero()) {
+        return;
+    }
+
+    OSPFLivenessProbeView probe;
+    if (!probe.Parse(packet)) {
+        NS_LOG_WARN("malformed Liveness Probe is dropped");
+        return;
+    }
+
+    // Helloで見つけたネイバーだけを監視する
+    InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+    RouterId neighborRouterId = packet.GetRouterId();
+    if (!ifaceData.IsKnownNeighbor(neighborRouterId)) {
+        return;
+    }
+    NeighborData& neighData = ifaceData.GetNeighbor(neighborRouterId);
+    if (neighData.GetState() < NeighborState::INIT) {
+        return;
+    }
+    neighData.ReceiveLivenessProbe(Simulator::Now());
+}
+
+void Ipv6OspfRouting::RemoveFromAllRxmtList(uint32_t areaId, OSPFLinkStateIdentifier &identifier) {
+    NS_LOG_FUNCTION(m_routerId << areaId);
+    if(GetArea(areaId).GetLSDB().Has(identifier))
         NS_LOG_INFO("RemoveFromAllRxmtList - 持っているLSAです: " << identifier);
     else
         NS_LOG_INFO("RemoveFromAllRxmtList - 持っていないLSAです: " << identifier);
 
     for (InterfaceData& ifaceData : m_interfaces) {
         if (!ifaceData.IsActive()) continue;
+        if (ifaceData.GetAreaId() != areaId) continue;
         for (auto& kv : ifaceData.GetNeighbors()) {
             NS_LOG_INFO("RemoveFromAllRxmtList - router " << m_routerId << " の neighbor " << kv.first << " から削除します: " << identifier);
             // NS_LOG_DEBUG("RemoveFromAllRxmtList - before " << kv.second.GetRxmtList());
@@ -1563,6 +2722,87 @@ bool Ipv6OspfRouting::IsNeighborToBeAdjacent(uint32_t ifaceIdx, RouterId neighbo
     );
 }
 
+// ExStartのネイバーから最後に受け取ったDDでmaster/slaveを決め、Exchangeに進める
+// Exchange/Loadingの枠が埋まっていればExStartのまま待ち行列に入れる
+void Ipv6OspfRouting::NegotiateExchange(uint32_t ifaceIdx, RouterId neighborRouterId) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << neighborRouterId);
+    NeighborData &neighData = m_interfaces[ifaceIdx].GetNeighbor(neighborRouterId);
+    OSPFDatabaseDescription &ddPacket = neighData.GetLastPacket();
+
+    bool asSlave = ddPacket.IsNegotiation() && m_routerId < neighborRouterId;
+    bool asMaster = (
+        !(ddPacket.GetInitFlag() || ddPacket.GetMasterFlag()) &&
+        ddPacket.GetSequenceNumber () == neighData.GetSequenceNumber() &&
+        m_routerId > neighborRouterId
+    );
+    if (!asSlave && !asMaster) {
+        NS_LOG_LOGIC("EXSTARTだが何も条件を満たしていなかった");
+        NS_LOG_LOGIC("Slave条件: ddPacket.IsNegotiation() -> " << (ddPacket.IsNegotiation() ? "true" : "false") << " && m_routerId < neighborRouterId -> " << (m_routerId < neighborRouterId ? "true" : "false"));
+        NS_LOG_LOGIC("Master条件: !(ddPacket.GetInitFlag() || ddPacket.GetMasterFlag()) -> " << (!(ddPacket.GetInitFlag() || ddPacket.GetMasterFlag()) ? "true" : "false")
+            << " && ddPacket.GetSequenceNumber () == neighData.GetSequenceNumber() -> " << ddPacket.GetSequenceNumber () << " == " << neighData.GetSequenceNumber () << (ddPacket.GetSequenceNumber () == neighData.GetSequenceNumber() ? "true" : "false")
+            << " && m_routerId > neighborRouterId -> " << (m_routerId > neighborRouterId ? "true": "false"));
+        return;
+    }
+    if (m_maxConcurrentAdjacencies > 0 && m_adjacenciesInProgress >= m_maxConcurrentAdjacencies) {
+        std::pair<uint32_t, RouterId> key = std::make_pair(ifaceIdx, neighborRouterId);
+        if (std::find(m_pendingAdjacencies.begin(), m_pendingAdjacencies.end(), key) == m_pendingAdjacencies.end()) {
+            m_pendingAdjacencies.push_back(key);
+        }
+        NS_LOG_LOGIC("adjacency is held in ExStart: router " << m_routerId << ", nghRtrId " << neighborRouterId << ", in progress " << m_adjacenciesInProgress);
+        return;
+    }
+
+    neighData.SetDdWindowed(m_ddWindowSize > 1 && (ddPacket.GetOptions() & OSPF_OPTION_DD_WINDOW));
+    if (asSlave) {
+        neighData.SetAsSlave();
+        neighData.SetSequenceNumber(ddPacket.GetSequenceNumber());
+        NS_LOG_LOGIC("Exchange start: (" << m_routerId << "の視点): master - " << neighborRouterId << ", slave - " << m_routerId);
+        NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::NEGOT_DONE);
+    } else {
+        neighData.SetAsMaster();
+        NS_LOG_LOGIC("Exchange start: (" << m_routerId << "の視点): master - " << m_routerId << ", slave - " << neighborRouterId);
+        NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::NEGOT_DONE);
+        neighData.IncrementSequenceNumber();
+    }
+}
+
+// 空いた枠の分だけ、ExStartで待っているネイバーを到着順にExchangeへ進める
+void Ipv6OspfRouting::ResumePendingAdjacencies() {
+    NS_LOG_FUNCTION(m_routerId);
+    while (
+        !m_pendingAdjacencies.empty() &&
+        (m_maxConcurrentAdjacencies == 0 || m_adjacenciesInProgress < m_maxConcurrentAdjacencies)
+    ) {
+        std::pair<uint32_t, RouterId> key = m_pendingAdjacencies.front();
+        m_pendingAdjacencies.pop_front();
+        InterfaceData &ifaceData = m_interfaces[key.first];
+        // 待っている間に落ちたか、ネゴシエーションをやり直したネイバーは飛ばす
+        if (!ifaceData.HasNeighbor(key.second) || !ifaceData.GetNeighbor(key.second).IsState(NeighborState::EXSTART)) {
+            continue;
+        }
+        NegotiateExchange(key.first, key.second);
+    }
+}
+
+// DR/BDRを選び直し、変わったらTWOWAY以上の全ネイバーの隣接を見直す
+void Ipv6OspfRouting::CalcDesignatedRouter(uint32_t ifaceIdx) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx);
+    InterfaceData &ifaceData = m_interfaces[ifaceIdx];
+    InterfaceState beforeState = ifaceData.GetState();
+
+    bool changed = ifaceData.CalcDesignatedRouter(m_routerId);
+    NS_LOG_INFO("DR election on router " << m_routerId << ", iface " << ifaceIdx << ": DR " << ifaceData.GetDesignatedRouter() << ", BDR " << ifaceData.GetBackupDesignatedRouter() << ", " << ToString(ifaceData.GetState()));
+
+    if (changed) {
+        for (RouterId neighborRouterId : ifaceData.GetActiveNeighbors()) {
+            NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::IS_ADJ_OK);
+        }
+    }
+    if (changed || beforeState != ifaceData.GetState()) {
+        OriginateRouterSpecificLSAs(ifaceIdx);
+    }
+}
+
 void Ipv6OspfRouting::NotifyInterfaceEvent(uint32_t ifaceIdx, InterfaceEvent event) {
     NS_LOG_FUNCTION(m_routerId << ifaceIdx << ToString(event));
     InterfaceData &ifaceData = m_interfaces[ifaceIdx];
@@ -1612,7 +2852,8 @@ void Ipv6OspfRouting::NotifyInterfaceEvent(uint32_t ifaceIdx, InterfaceEvent eve
     case InterfaceEvent::BACKUP_SEEN: // fall through
     case InterfaceEvent::WAIT_TIMER: {
         if (ifaceData.IsState(InterfaceState::WAITING)) {
-            ifaceData.CalcDesignatedRouter();
+            ifaceData.GetWaitTimer().Cancel();
+            CalcDesignatedRouter(ifaceIdx);
         }
         break;
     }
@@ -1622,26 +2863,28 @@ void Ipv6OspfRouting::NotifyInterfaceEvent(uint32_t ifaceIdx, InterfaceEvent eve
             ifaceData.IsState(InterfaceState::DR) ||
             ifaceData.IsState(InterfaceState::BACKUP)
         ) {
-            ifaceData.CalcDesignatedRouter();
+            CalcDesignatedRouter(ifaceIdx);
         }
         break;
     }
     case InterfaceEvent::IF_DOWN: {
         ifaceData.SetState(InterfaceState::DOWN);
         OriginateRouterSpecificLSAs(ifaceIdx);
-        ifaceData.ResetInstance();
+        // ネイバー削除に伴う再生成が元のエリアに向くよう、リセットより先に行う
         for (auto& kv : ifaceData.GetNeighbors()) {
             NotifyNeighborEvent(ifaceIdx, kv.first, NeighborEvent::KILL_NBR);
         }
+        ifaceData.ResetInstance();
         break;
     }
     case InterfaceEvent::LOOP_IND: {
         ifaceData.SetState(InterfaceState::LOOPBACK);
         OriginateRouterSpecificLSAs(ifaceIdx);
-        ifaceData.ResetInstance();
+        // ネイバー削除に伴う再生成が元のエリアに向くよう、リセットより先に行う
         for (auto& kv : ifaceData.GetNeighbors()) {
             NotifyNeighborEvent(ifaceIdx, kv.first, NeighborEvent::KILL_NBR);
         }
+        ifaceData.ResetInstance();
         break;
     }
     case InterfaceEvent::UNLOOP_IND: {
@@ -1699,14 +2942,42 @@ void Ipv6OspfRouting::NotifyNeighborEvent(uint32_t ifaceIdx, RouterId neighborRo
         if (neighbor.IsState(NeighborState::EXSTART)) {
             neighbor.SetState(NeighborState::EXCHANGE);
 
+            OSPFLSDB& lsdb = GetArea(ifaceData.GetAreaId()).GetLSDB();
+            const std::vector<uint32_t>& localDigest = lsdb.GetBucketDigests();
+            const std::vector<uint32_t>& peerDigest = neighbor.GetLastPacket().GetLsdbDigest();
+            bool useDigest = m_lsdbDigest && peerDigest.size() == localDigest.size();
+            if (useDigest && peerDigest == localDigest) {
+                // LSDBが一致しているのでExchange/Loadingを省く
+                // slaveはmasterがNEGOT_DONEになれるように応答だけ返す
+                // Link-LSAはダイジェストに含まれないが、FULLになった時点で再生成されて届く
+                NS_LOG_LOGIC("LSDB digest matched: router " << m_routerId << ", nghRtrId " << neighborRouterId);
+                neighbor.SetState(NeighborState::FULL);
+                if (neighbor.IsSlave()) {
+                    Simulator::ScheduleNow(&Ipv6OspfRouting::SendDatabaseDescriptionPacket, this, ifaceIdx, neighborRouterId, false);
+                }
+                if (!neighbor.IsHelpingRestart()) {
+                    OriginateRouterSpecificLSAs(ifaceIdx);
+                }
+                break;
+            }
+
             // FIXME: tooooo ad-hoc
-            std::vector<Ptr<OSPFLSAHeader> > summarySeed, summaryList;
+            std::vector<OSPFLSAHeader> summarySeed, summaryList;
             std::vector<Ptr<OSPFLSA> > rxmt;
-            m_lsdb.GetSummary(summarySeed, rxmt);
+            lsdb.GetSummary(summarySeed, rxmt);
 
-            for(auto hdr : summarySeed) {
-                if(hdr->IsLinkLocalScope() && !ifaceData.IsKnownLinkLocalLSA(hdr->CreateIdentifier())) {
-                    continue;
+            summaryList.reserve(summarySeed.size());
+            for(auto& hdr : summarySeed) {
+                if(hdr.IsLinkLocalScope()) {
+                    if (!ifaceData.IsKnownLinkLocalLSA(hdr.CreateIdentifier())) {
+                        continue;
+                    }
+                } else if (useDigest) {
+                    // ダイジェストが一致したバケットのLSAは記述しない
+                    uint32_t bucket = OSPFLSDB::GetDigestBucket(hdr.CreateIdentifier());
+                    if (peerDigest[bucket] == localDigest[bucket]) {
+                        continue;
+                    }
                 }
                 summaryList.push_back(hdr);
             }
@@ -1716,7 +2987,11 @@ void Ipv6OspfRouting::NotifyNeighborEvent(uint32_t ifaceIdx, RouterId neighborRo
             for(auto maxAgedLsa : rxmt) {
                 AddToRxmtList(ifaceIdx, neighborRouterId, maxAgedLsa);
             }
-            Simulator::ScheduleNow(&Ipv6OspfRouting::SendDatabaseDescriptionPacket, this, ifaceIdx, neighborRouterId, false);
+            if (neighbor.IsDdWindowed() && neighbor.IsMaster()) {
+                Simulator::ScheduleNow(&Ipv6OspfRouting::SendDatabaseDescriptionWindow, this, ifaceIdx, neighborRouterId);
+            } else {
+                Simulator::ScheduleNow(&Ipv6OspfRouting::SendDatabaseDescriptionPacket, this, ifaceIdx, neighborRouterId, false);
+            }
         }
         break;
     }
@@ -1724,7 +2999,9 @@ void Ipv6OspfRouting::NotifyNeighborEvent(uint32_t ifaceIdx, RouterId neighborRo
         if (neighbor.IsState(NeighborState::EXCHANGE)) {
             if (neighbor.IsRequestListEmpty()) {
                 neighbor.SetState(NeighborState::FULL);
-                OriginateRouterSpecificLSAs(ifaceIdx);
+                if (!neighbor.IsHelpingRestart()) {
+                    OriginateRouterSpecificLSAs(ifaceIdx);
+                }
             } else {
                 neighbor.SetState(NeighborState::LOADING);
                 Simulator::ScheduleNow(&Ipv6OspfRouting::SendLinkStateRequestPacket, this, ifaceIdx, neighborRouterId);
@@ -1735,7 +3012,9 @@ void Ipv6OspfRouting::NotifyNeighborEvent(uint32_t ifaceIdx, RouterId neighborRo
     case NeighborEvent::LOADING_DONE: {
         if (neighbor.IsState(NeighborState::LOADING)) {
             neighbor.SetState(NeighborState::FULL);
-            OriginateRouterSpecificLSAs(ifaceIdx);
+            if (!neighbor.IsHelpingRestart()) {
+                OriginateRouterSpecificLSAs(ifaceIdx);
+            }
         }
         break;
     }
@@ -1758,6 +3037,12 @@ void Ipv6OspfRouting::NotifyNeighborEvent(uint32_t ifaceIdx, RouterId neighborRo
     }
     case NeighborEvent::BAD_LS_REQ: // fall through
     case NeighborEvent::SEQ_NUM_MISMATCH: {
+        // RFC 3623 3.2 helper中のFULLの隣接は、再起動したネイバーがInit付きDDで交換をやり直すときだけ張り直す
+        // 張り直している間もIsAdvertisedFullでLSAには載せ続ける
+        if (neighbor.IsHelpingRestart() && neighbor.IsState(NeighborState::FULL) && !neighbor.GetLastPacket().GetInitFlag()) {
+            NS_LOG_LOGIC("mismatch of restarting neighbor " << neighborRouterId << " is ignored: router " << m_routerId);
+            break;
+        }
         if (neighbor.GetState() >= NeighborState::EXCHANGE) {
             neighbor.SetState(NeighborState::EXSTART);
             neighbor.ClearList();
@@ -1769,11 +3054,28 @@ void Ipv6OspfRouting::NotifyNeighborEvent(uint32_t ifaceIdx, RouterId neighborRo
     case NeighborEvent::KILL_NBR: // fall through
     case NeighborEvent::LL_DOWN: // fall through
     case NeighborEvent::INACTIVE: {
+        // RFC 3623 3.2 helper中は再起動中のネイバーのHelloが途切れても隣接を保つ
+        if (event == NeighborEvent::INACTIVE && neighbor.IsHelpingRestart()) {
+            NS_LOG_LOGIC("inactivity of restarting neighbor " << neighborRouterId << " is ignored: router " << m_routerId);
+            break;
+        }
+        neighbor.ClearHelpingRestart();
         neighbor.SetState(NeighborState::DOWN);
         neighbor.ClearList();
+        neighbor.ResetLiveness();
+        neighbor.GetInactivityTimer().Cancel();
+        // 隣接が失われたのでRouter-LSAから外す
+        if (beforeState == NeighborState::FULL) {
+            OriginateRouterSpecificLSAs(ifaceIdx);
+        }
         break;
     }
     case NeighborEvent::ONEWAY_RECEIVED: {
+        // 再起動直後のネイバーのHelloにはまだこのルータが載っていないので、helper中は隣接を落とさない
+        if (neighbor.IsHelpingRestart()) {
+            NS_LOG_LOGIC("1-way hello of restarting neighbor " << neighborRouterId << " is ignored: router " << m_routerId);
+            break;
+        }
         if (neighbor.GetState() >= NeighborState::TWOWAY) {
             neighbor.SetState(NeighborState::INIT);
             neighbor.ClearList();
@@ -1781,6 +3083,34 @@ void Ipv6OspfRouting::NotifyNeighborEvent(uint32_t ifaceIdx, RouterId neighborRo
         break;
     }
     } // switch
+    // Exchange/Loadingの隣接を数え、抜けた分の枠をExStartで待っているネイバーに回す
+    bool wasInProgress = beforeState == NeighborState::EXCHANGE || beforeState == NeighborState::LOADING;
+    bool inProgress = neighbor.IsState(NeighborState::EXCHANGE) || neighbor.IsState(NeighborState::LOADING);
+    if (wasInProgress != inProgress) {
+        if (inProgress) {
+            ++m_adjacenciesInProgress;
+        } else {
+            --m_adjacenciesInProgress;
+            if (!m_pendingAdjacencies.empty()) {
+                Simulator::ScheduleNow(&Ipv6OspfRouting::ResumePendingAdjacencies, this);
+            }
+        }
+    }
+    // restarterは再起動前の隣接が全てFULLに戻ったら再起動を終える
+    if (m_restarting && beforeState != NeighborState::FULL && neighbor.IsState(NeighborState::FULL)) {
+        m_restartNeighbors.erase(std::make_pair(ifaceIdx, neighborRouterId));
+        if (m_restartNeighbors.empty()) {
+            Simulator::ScheduleNow(&Ipv6OspfRouting::ExitGracefulRestart, this);
+        }
+    }
+    // HelloのNeighbor欄はTWOWAY以上のネイバーなので、境界をまたいだときだけ作り直す
+    // 双方向の通信が成立したか失われたので、DR/BDRの選出もやり直す
+    if ((beforeState >= NeighborState::TWOWAY) != (neighbor.GetState() >= NeighborState::TWOWAY)) {
+        ifaceData.InvalidateHelloCache();
+        if (!ifaceData.IsType(InterfaceType::P2P)) {
+            Simulator::ScheduleNow(&Ipv6OspfRouting::NotifyInterfaceEvent, this, ifaceIdx, InterfaceEvent::NEIGH_CHANGE);
+        }
+    }
     NS_LOG_INFO("neighbor state mutation ( " << m_routerId << ", " << neighborRouterId << " ): " << ToString(beforeState) << " -> " << ToString(neighbor.GetState()));
 }
 
@@ -1789,29 +3119,79 @@ void Ipv6OspfRouting::SendHelloPacket(uint32_t ifaceIdx) {
 
     // 宛先はAllSPFRoutersでよい
     InterfaceData& ifaceData = m_interfaces[ifaceIdx];
-    OSPFHello hello;
-
-    hello.SetRouterId(m_routerId);
-    hello.SetAreaId(ifaceData.GetAreaId());
-    hello.SetInstanceId(0);
-    hello.SetInterfaceId(ifaceData.GetInterfaceId());
-    hello.SetRouterPriority(1);
-    hello.SetOptions(0x13); // V6, E, R
-    hello.SetHelloInterval(ifaceData.GetHelloInterval().ToInteger(Time::S));
-    hello.SetRouterDeadInterval(ifaceData.GetRouterDeadInterval().ToInteger(Time::S));
-    hello.SetDesignatedRouter(ifaceData.GetDesignatedRouter());
-    hello.SetBackupDesignatedRouter(ifaceData.GetBackupDesignatedRouter());
-    hello.SetNeighbors(ifaceData.GetActiveNeighbors());
-
-    Ptr<Packet> packet = Create<Packet>();
-    packet->AddHeader(hello);
-
-    Ptr<Socket> socket = m_ifaceIdxToSocket[ifaceIdx];
-    socket->SendTo(packet, 0, Inet6SocketAddress(Ipv6OspfRouting::AllSPFRouters, PROTO_PORT));
+
+    // 内容が変わらない限り前回シリアライズしたものを使い回す
+    // Packet::Copyはバッファを共有するので再シリアライズもチェックサム計算も起きない
+    Ptr<Packet> cached = ifaceData.GetHelloCache();
+    if (!cached) {
+        OSPFHello hello;
+
+        hello.SetRouterId(m_routerId);
+        hello.SetAreaId(ifaceData.GetAreaId());
+        hello.SetInstanceId(0);
+        hello.SetInterfaceId(ifaceData.GetInterfaceId());
+        hello.SetRouterPriority(ifaceData.GetRouterPriority());
+        hello.SetOptions(GetOptionsForInterface(ifaceIdx));
+        hello.SetHelloInterval(ifaceData.GetHelloInterval().ToInteger(Time::S));
+        hello.SetRouterDeadInterval(ifaceData.GetRouterDeadInterval().ToInteger(Time::S));
+        hello.SetDesignatedRouter(ifaceData.GetDesignatedRouter());
+        hello.SetBackupDesignatedRouter(ifaceData.GetBackupDesignatedRouter());
+        hello.SetNeighbors(ifaceData.GetActiveNeighbors());
+
+        cached = BuildPacket(ifaceIdx, hello, AllSPFRouters);
+        ifaceData.SetHelloCache(cached);
+        NS_LOG_LOGIC("rebuild hello cache: router " << m_routerId << ", iface " << ifaceIdx);
+    }
+
+    SendToInterface(ifaceIdx, cached->Copy(), AllSPFRouters);
     
     Simulator::ScheduleNow(&InterfaceData::ScheduleHello, &ifaceData);
 }
 
+// プローブを送り、同じタイマーでこのインターフェイスの全ネイバーの検出時間超過を調べる
+// ネイバーごとにタイマーを持たないので、イベント数はインターフェイス数にしか比例しない
+void Ipv6OspfRouting::SendLivenessProbe(uint32_t ifaceIdx) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx);
+    InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+
+    Ptr<Packet> cached = ifaceData.GetLivenessProbeCache();
+    if (!cached) {
+        OSPFLivenessProbe probe;
+        probe.SetRouterId(m_routerId);
+        probe.SetAreaId(ifaceData.GetAreaId());
+        probe.SetInstanceId(0);
+        probe.SetInterfaceId(ifaceData.GetInterfaceId());
+        cached = BuildPacket(ifaceIdx, probe, AllSPFRouters);
+        ifaceData.SetLivenessProbeCache(cached);
+    }
+    SendToInterface(ifaceIdx, cached->Copy(), AllSPFRouters);
+
+    Time now = Simulator::Now();
+    Time detectionTime = NanoSeconds(m_livenessInterval.GetNanoSeconds() * m_livenessMultiplier);
+    std::vector<RouterId> expired;
+    for (auto& kv : ifaceData.GetNeighbors()) {
+        NeighborData& neighData = kv.second;
+        if (
+            neighData.IsLivenessUp() &&
+            !neighData.IsHelpingRestart() &&
+            neighData.GetState() >= NeighborState::INIT &&
+            now - neighData.GetLastLivenessProbe() > detectionTime
+        ) {
+            expired.push_back(kv.first);
+        }
+    }
+    // P2Pで唯一のネイバーが落ちたならリンク断とみなす
+    if (!expired.empty() && ifaceData.IsType(InterfaceType::P2P)) {
+        ActivateLoopFreeAlternates(ifaceIdx);
+    }
+    for (RouterId neighborRouterId : expired) {
+        NS_LOG_INFO("liveness probe timeout: router " << m_routerId << ", iface " << ifaceIdx << ", neighbor " << neighborRouterId);
+        NotifyNeighborEvent(ifaceIdx, neighborRouterId, NeighborEvent::KILL_NBR);
+    }
+
+    Simulator::ScheduleNow(&InterfaceData::ScheduleLiveness, &ifaceData);
+}
+
 void Ipv6OspfRouting::SendDatabaseDescriptionPacket(uint32_t ifaceIdx, RouterId neighborRouterId, bool isInit) {
     NS_LOG_FUNCTION(m_routerId << ifaceIdx << neighborRouterId << (isInit ? "true" : "false"));
 
@@ -1823,7 +3203,7 @@ void Ipv6OspfRouting::SendDatabaseDescriptionPacket(uint32_t ifaceIdx, RouterId
     dd.SetRouterId(m_routerId);
     dd.SetAreaId(ifaceData.GetAreaId());
     dd.SetInstanceId(0);
-    dd.SetOptions(0x13); // V6, E, R
+    dd.SetOptions(GetOptionsForInterface(ifaceIdx) | (m_ddWindowSize > 1 ? OSPF_OPTION_DD_WINDOW : 0));
     uint32_t mtu = m_ipv6->GetMtu(ifaceIdx);
     dd.SetMtu(mtu); // TODO: 仮想リンクの場合は0にしなければならない
     dd.SetInitFlag(isInit);
@@ -1837,14 +3217,82 @@ void Ipv6OspfRouting::SendDatabaseDescriptionPacket(uint32_t ifaceIdx, RouterId
     dd.SetSequenceNumber(seqNum);
     if (!isInit && !neighData.GetLastPacket().GetInitFlag()) {
         dd.SetLSAHeaders(neighData.GetSummaryList(mtu - 40));
+    } else if (m_lsdbDigest) {
+        // ExStartのDDとslaveの最初の応答にはLSAヘッダが載らないので、代わりにLSDBダイジェストを載せる
+        dd.SetOptions(dd.GetOptions() | OSPF_OPTION_L);
+        dd.SetLsdbDigest(GetArea(ifaceData.GetAreaId()).GetLSDB().GetBucketDigests());
     }
 
-    Ptr<Packet> packet = Create<Packet>();
-    packet->AddHeader(dd);
+    SendToInterface(ifaceIdx, dd, neighData.GetAddress());
+}
+// Summary Listから詰められるだけLSAヘッダを取り出し、チェックサム済みのDDを作る
+Ptr<Packet> Ipv6OspfRouting::BuildWindowedDatabaseDescription(uint32_t ifaceIdx, RouterId neighborRouterId, int32_t seqNum, bool masterFlag) {
+    InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+    NeighborData& neighData = ifaceData.GetNeighbor(neighborRouterId);
+
+    OSPFDatabaseDescription dd;
+    dd.SetRouterId(m_routerId);
+    dd.SetAreaId(ifaceData.GetAreaId());
+    dd.SetInstanceId(0);
+    dd.SetOptions(GetOptionsForInterface(ifaceIdx) | OSPF_OPTION_DD_WINDOW);
+    uint32_t mtu = m_ipv6->GetMtu(ifaceIdx);
+    dd.SetMtu(mtu);
+    dd.SetInitFlag(false);
+    dd.SetMasterFlag(masterFlag);
+    dd.SetSequenceNumber(seqNum);
+    dd.SetLSAHeaders(neighData.GetSummaryList(mtu - 40));
+    dd.SetMoreFlag(neighData.HasMoreSummary());
+
+    return BuildPacket(ifaceIdx, dd, neighData.GetAddress());
+}
+
+// master: 未確認のDDが窓の大きさになるまで送る
+// 自分のSummary Listが空でも、slaveにまだ残りがあれば応答させるために空のDDを送る
+void Ipv6OspfRouting::SendDatabaseDescriptionWindow(uint32_t ifaceIdx, RouterId neighborRouterId) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << neighborRouterId);
+
+    InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+    NeighborData& neighData = ifaceData.GetNeighbor(neighborRouterId);
+    if (!neighData.IsState(NeighborState::EXCHANGE) || !neighData.IsMaster()) {
+        return;
+    }
+
+    while (
+        neighData.CountDdWindowPackets() < m_ddWindowSize &&
+        (neighData.HasMoreSummary() || neighData.IsDdPeerMore())
+    ) {
+        int32_t seqNum = neighData.GetSequenceNumber();
+        Ptr<Packet> packet = BuildWindowedDatabaseDescription(ifaceIdx, neighborRouterId, seqNum, true);
+        neighData.AddDdWindowPacket(seqNum, packet);
+        neighData.IncrementSequenceNumber();
+        SendToInterface(ifaceIdx, packet->Copy(), neighData.GetAddress());
+    }
+
+    EventId& rxmtEvent = neighData.GetDdRxmtEvent();
+    if (neighData.CountDdWindowPackets() && !rxmtEvent.IsRunning()) {
+        rxmtEvent = Simulator::Schedule(ifaceData.GetRxmtInterval(), &Ipv6OspfRouting::RetransmitDatabaseDescriptionWindow, this, ifaceIdx, neighborRouterId);
+    }
+}
+
+// master: RxmtIntervalが過ぎても応答のないDDだけを再送する
+void Ipv6OspfRouting::RetransmitDatabaseDescriptionWindow(uint32_t ifaceIdx, RouterId neighborRouterId) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << neighborRouterId);
+
+    InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+    NeighborData& neighData = ifaceData.GetNeighbor(neighborRouterId);
+    if (!neighData.IsState(NeighborState::EXCHANGE) || !neighData.IsMaster()) {
+        return;
+    }
 
-    Ptr<Socket> socket = m_ifaceIdxToSocket[ifaceIdx];
-    socket->SendTo(packet, 0, Inet6SocketAddress(neighData.GetAddress(), PROTO_PORT));
+    for (auto& kv : neighData.GetDdWindowPackets()) {
+        NS_LOG_LOGIC("retransmit DD: seq " << kv.first);
+        SendToInterface(ifaceIdx, kv.second->Copy(), neighData.GetAddress());
+    }
+    if (neighData.CountDdWindowPackets()) {
+        neighData.GetDdRxmtEvent() = Simulator::Schedule(ifaceData.GetRxmtInterval(), &Ipv6OspfRouting::RetransmitDatabaseDescriptionWindow, this, ifaceIdx, neighborRouterId);
+    }
 }
+
 void Ipv6OspfRouting::SendLinkStateRequestPacket(uint32_t ifaceIdx, RouterId neighborRouterId) {
     NS_LOG_FUNCTION(m_routerId << ifaceIdx << neighborRouterId);
 
@@ -1864,25 +3312,21 @@ void Ipv6OspfRouting::SendLinkStateRequestPacket(uint32_t ifaceIdx, RouterId nei
     // lsr.SetOptions(0x13); // V6, E, R
     uint32_t mtu = m_ipv6->GetMtu(ifaceIdx);
     std::vector<OSPFLinkStateIdentifier> lsids;
-    std::vector<Ptr<OSPFLSAHeader> > tmp = neighData.GetRequestList(mtu - 20);
+    std::vector<OSPFLSAHeader> tmp = neighData.GetRequestList(mtu - 20);
     NS_LOG_LOGIC("Request List for #" << m_routerId << "size: " << neighData.GetRequestList().size() << ", partial size: " << tmp.size());
-    for (auto lsHdr : tmp) {
-        lsids.push_back(lsHdr->CreateIdentifier());
+    for (auto& lsHdr : tmp) {
+        lsids.push_back(lsHdr.CreateIdentifier());
     }
     lsr.SetLinkStateIdentifiers(lsids);
 
-    Ptr<Packet> packet = Create<Packet>();
-    packet->AddHeader(lsr);
-
-    Ptr<Socket> socket = m_ifaceIdxToSocket[ifaceIdx];
-    socket->SendTo(packet, 0, Inet6SocketAddress(neighData.GetAddress(), PROTO_PORT));
+    SendToInterface(ifaceIdx, lsr, neighData.GetAddress());
 
     if (!neighData.IsRequestListEmpty()) {
         Simulator::Schedule(ifaceData.GetRxmtInterval(), &Ipv6OspfRouting::SendLinkStateRequestPacket, this, ifaceIdx, neighborRouterId);
     }
 }
-void Ipv6OspfRouting::SendLinkStateAckPacket(uint32_t ifaceIdx, Ptr<OSPFLSAHeader> lsaHeader, RouterId neighborRouterId) {
-    std::vector<Ptr<OSPFLSAHeader> > lsaHdrs;
+void Ipv6OspfRouting::SendLinkStateAckPacket(uint32_t ifaceIdx, const OSPFLSAHeader& lsaHeader, RouterId neighborRouterId) {
+    std::vector<OSPFLSAHeader> lsaHdrs;
     lsaHdrs.push_back(lsaHeader);
     Ipv6OspfRouting::SendLinkStateAckPacket(ifaceIdx, lsaHdrs, neighborRouterId);
 }
@@ -1922,6 +3366,18 @@ void Ipv6OspfRouting::SendLinkStateUpdatePacket(uint32_t ifaceIdx, RouterId neig
         NS_LOG_LOGIC("Rxmt List for #" << m_routerId << " is empty");
         return;
     }
+    if (m_floodWindow > 0) {
+        // RxmtIntervalの間確認応答が進まなければ、窓を縮めて送信済みのものから再送する
+        if (
+            neighData.GetRxmtSentCount() > 0 &&
+            Simulator::Now() - neighData.GetFloodProgress() >= ifaceData.GetRxmtInterval()
+        ) {
+            NS_LOG_LOGIC("flooding timeout: router " << m_routerId << ", nbr " << neighborRouterId << ", window " << neighData.GetFloodWindow());
+            neighData.OnFloodTimeout(m_floodWindow);
+        }
+        SendLinkStateUpdateWindow(ifaceIdx, neighborRouterId);
+        return;
+    }
 
     Ipv6Address dstAddr = (
         ifaceData.GetType() == InterfaceType::P2P ?
@@ -1945,11 +3401,42 @@ void Ipv6OspfRouting::SendLinkStateUpdatePacket(uint32_t ifaceIdx, RouterId neig
 
     NS_LOG_INFO("Sending LSU("<<m_routerId<<", "<<neighborRouterId<<"): " << lsu);
 
-    Ptr<Packet> packet = Create<Packet>();
-    packet->AddHeader(lsu);
+    SendToInterface(ifaceIdx, lsu, dstAddr);
+}
+// 確認応答待ちのLSAが窓に収まる間、Rxmt Listの未送信のLSAをMTUごとのLSUにして送る
+void Ipv6OspfRouting::SendLinkStateUpdateWindow(uint32_t ifaceIdx, RouterId neighborRouterId) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx << neighborRouterId);
+
+    InterfaceData& ifaceData = m_interfaces[ifaceIdx];
+    NeighborData& neighData = ifaceData.GetNeighbor(neighborRouterId);
+    if (neighData.GetState() < NeighborState::EXCHANGE) {
+        return;
+    }
+    neighData.InitializeFloodWindow(m_floodWindow);
 
-    Ptr<Socket> socket = m_ifaceIdxToSocket[ifaceIdx];
-    socket->SendTo(packet, 0, Inet6SocketAddress(dstAddr, PROTO_PORT));
+    Ipv6Address dstAddr = (
+        ifaceData.GetType() == InterfaceType::P2P ?
+            Ipv6OspfRouting::AllSPFRouters :
+            neighData.GetAddress()
+    );
+    // IPv6ヘッダ(40)、OSPFヘッダ(16)、LSUのLSA数(4)を除いた分にLSAを詰める
+    int32_t maxBytes = m_ipv6->GetMtu(ifaceIdx) - 60;
+    while (true) {
+        std::vector<Ptr<OSPFLSA> > lsas = neighData.TakeUnsentRxmt(maxBytes);
+        if (lsas.empty()) {
+            break;
+        }
+        for (auto& item : lsas) {
+            item->AgingBeforeFlooding(ifaceData.GetIfaceTransDelay());
+        }
+        OSPFLinkStateUpdate lsu;
+        lsu.SetRouterId(m_routerId);
+        lsu.SetAreaId(ifaceData.GetAreaId());
+        lsu.SetInstanceId(0);
+        lsu.SetLSAs(lsas);
+        NS_LOG_INFO("Sending LSU("<<m_routerId<<", "<<neighborRouterId<<"): " << lsas.size() << " LSAs, window " << neighData.GetFloodWindow() << ", in flight " << neighData.GetRxmtSentCount());
+        SendToInterface(ifaceIdx, lsu, dstAddr);
+    }
 }
 void Ipv6OspfRouting::SendLinkStateUpdatePacketDirectAsap(uint32_t ifaceIdx, Ptr<OSPFLSA> lsa, RouterId neighborRouterId) {
     std::vector<Ptr<OSPFLSA> > lsas = std::vector<Ptr<OSPFLSA> >();
@@ -1992,17 +3479,13 @@ void Ipv6OspfRouting::SendLinkStateUpdatePacketDirect(uint32_t ifaceIdx, std::ve
 
     NS_LOG_INFO("Sending LSU("<<m_routerId<<", "<<neighborRouterId<<"): " << lsu);
 
-    Ptr<Packet> packet = Create<Packet>();
-    packet->AddHeader(lsu);
-
-    Ptr<Socket> socket = m_ifaceIdxToSocket[ifaceIdx];
-    socket->SendTo(packet, 0, Inet6SocketAddress(dstAddr, PROTO_PORT));
+    SendToInterface(ifaceIdx, lsu, dstAddr);
 
     if (lsas.size() > 0) {
         Simulator::ScheduleNow(&Ipv6OspfRouting::SendLinkStateUpdatePacketDirect, this, ifaceIdx, lsas, neighborRouterId);
     }
 }
-void Ipv6OspfRouting::SendLinkStateAckPacket(uint32_t ifaceIdx, std::vector<Ptr<OSPFLSAHeader> >& lsaHeaders, RouterId neighborRouterId) {
+void Ipv6OspfRouting::SendLinkStateAckPacket(uint32_t ifaceIdx, std::vector<OSPFLSAHeader>& lsaHeaders, RouterId neighborRouterId) {
     NS_LOG_FUNCTION(m_routerId << ifaceIdx << neighborRouterId);
 
     InterfaceData& ifaceData = m_interfaces[ifaceIdx];
@@ -2018,11 +3501,7 @@ void Ipv6OspfRouting::SendLinkStateAckPacket(uint32_t ifaceIdx, std::vector<Ptr<
     lsack.SetInstanceId(0);
     lsack.SetLSAHeaders(lsaHeaders);
 
-    Ptr<Packet> packet = Create<Packet>();
-    packet->AddHeader(lsack);
-
-    Ptr<Socket> socket = m_ifaceIdxToSocket[ifaceIdx];
-    socket->SendTo(packet, 0, Inet6SocketAddress(dstAddr, PROTO_PORT));
+    SendToInterface(ifaceIdx, lsack, dstAddr);
 }
 
 Ptr<Ipv6Route> Ipv6OspfRouting::Lookup(Ipv6Address src, Ipv6Address dst, Ptr<NetDevice> interface) {
@@ -2031,12 +3510,13 @@ Ptr<Ipv6Route> Ipv6OspfRouting::Lookup(Ipv6Address src, Ipv6Address dst, Ptr<Net
     Ptr<Ipv6Route> route = 0;
 
     Ipv6RoutingTableEntry* entry = new Ipv6RoutingTableEntry();
-    if (m_routingTable.LookupRoute(dst, *entry)) {
+    if (m_routingTable.LookupRoute(dst, *entry, src)) {
         NS_LOG_LOGIC("Lookup succeeded");
         int32_t ifaceIdx = entry->GetInterface();
         NS_LOG_LOGIC("ifaceIdx: " << ifaceIdx);
         route = Create<Ipv6Route>();
-        if (entry->GetGateway().IsAny()) {
+        // ゲートウェイがリンクローカルでも、送信元はインターフェイスのグローバルアドレスにする
+        if (entry->GetGateway().IsAny() || entry->GetGateway().IsLinkLocal()) {
             for (uint32_t i = 0, l = m_ipv6->GetNAddresses (ifaceIdx); i < l; ++i) {
                 Ipv6InterfaceAddress addr = m_ipv6->GetAddress (ifaceIdx, i);
                 if (
@@ -2066,36 +3546,106 @@ Ptr<Ipv6Route> Ipv6OspfRouting::Lookup(Ipv6Address src, Ipv6Address dst, Ptr<Net
     return 0;
 }
 
-void Ipv6OspfRouting::CalcRoutingTable (bool recalcAll) {
-    NS_LOG_FUNCTION(m_routerId << recalcAll);
-    static uint16_t MAX_METRIC = 65535; // 2 ** 16 - 1
-    static RouterId MAX_ROUTER_ID = 4294967295; // 2**32 - 1
-    uint32_t routers = m_knownMaxRouterId + 1; // 0 is reserved
-    NS_LOG_INFO("CalcRoutingTable - routerId: " << m_routerId << ", routers: " << routers);
+typedef Ipv6OspfRouting::SpfTable SpfTable;
 
-    std::unordered_map<RouterId, std::unordered_map<RouterId, uint16_t> > table;
-    uint16_t INFCOST = 65535;
-    std::vector<uint16_t> costs(routers, 65535); // 経路長
-    std::vector<RouterId> prevs(routers, 0); // 0は経路なしなので存在確認不要
-    costs[m_routerId] = 0;
+// 経路長は32ビットで持つ。16ビットなのは広告するリンクのメトリックだけ
+static const uint32_t INFCOST = UINT32_MAX;
 
-    // NS_LOG_LOGIC("print entire LSDB");
-    // for (auto& kv : m_lsdb.GetTable()) {
-        // NS_LOG_LOGIC(" - " << *kv.second);
-    // }
+// rootからの最短距離と、各頂点の直前の頂点を求める
+static void RunDijkstra (const SpfTable& table, uint32_t root, std::vector<uint32_t>& costs, std::vector<uint32_t>& prevs) {
+    std::priority_queue<
+        std::pair<uint32_t, uint32_t>, // cost, id
+        std::vector<std::pair<uint32_t, uint32_t>>,
+        std::greater<std::pair<uint32_t, uint32_t>>
+    > pq;
+    costs[root] = 0;
+    pq.push(std::make_pair(0, root));
+    uint32_t currCost, tmpCost, adjCost;
+    uint32_t currId, adjRtrId;
+    NS_LOG_INFO("iterate dijkstra's algorithm - loop start");
+    while (!pq.empty()) {
+        currCost = pq.top().first;
+        currId = pq.top().second;
+        pq.pop();
+        NS_LOG_INFO(" currState - id: " << currId << ", cost: " << currCost);
+        auto adjacents = table.find(currId);
+        if (adjacents == table.end()) continue;
+        for (auto& kv : adjacents->second) { // unorderedなので順序保証なし
+            adjRtrId = kv.first;
+            adjCost = kv.second;
+            tmpCost = currCost + adjCost;
+            if (
+                tmpCost < costs[adjRtrId] || (
+                    tmpCost == costs[adjRtrId] && currId < prevs[adjRtrId] // 等しかったらID若い方を優先
+                )
+            ) {
+                costs[adjRtrId] = tmpCost;
+                prevs[adjRtrId] = currId;
+                pq.push(std::make_pair(tmpCost, adjRtrId));
+                NS_LOG_LOGIC(" pushState - id: " << adjRtrId << ", cost: " << tmpCost);
+            }
+        }
+    }
+}
+
+// OSPFv2 16.1 エリアごとの最短経路木
+// costs, nextHopsはルータIDの後ろにトランジットネットワークの頂点を並べたもの
+// neighborCostsが渡されたら、隣接ルータごとにそのルータを根とした最短距離も求める
+// graphが渡されたら、計算に使ったグラフを返す
+void Ipv6OspfRouting::CalcAreaShortestPath (uint32_t areaId, std::vector<uint32_t>& costs, std::vector<RouterId>& nextHops,
+                                            std::map<RouterId, std::vector<uint32_t> >* neighborCosts, SpfTable* graph) {
+    NS_LOG_FUNCTION(m_routerId << areaId);
+    AreaData& area = GetArea(areaId);
+    OSPFLSDB& lsdb = area.GetLSDB();
+    uint32_t routers = m_knownMaxRouterId + 1; // 0 is reserved
+    NS_LOG_INFO("CalcAreaShortestPath - routerId: " << m_routerId << ", area: " << areaId << ", routers: " << routers);
+
+    // トランジットネットワークはルータIDの後ろに頂点番号を振る
+    // Network-LSAは(DRのルータID, DRのInterface ID)で引く
+    std::map<std::pair<RouterId, uint32_t>, uint32_t> networkVertices;
+    uint32_t vertices = routers;
+    for (auto& id : area.m_networkLSA_set) {
+        if (lsdb.DetectMaxAge(id)) continue;
+        networkVertices[std::make_pair(id.m_advRtr, id.m_id)] = vertices++;
+    }
+
+    SpfTable table;
+    costs.assign(vertices, INFCOST); // 経路長
+    std::vector<RouterId>& prevs = nextHops;
+    prevs.assign(vertices, 0); // 0は経路なしなので存在確認不要
 
     // build table
     NS_LOG_INFO("build table");
-    for (auto& id : m_routerLSA_set) {
-        Ptr<OSPFLSA> rtrLSA = m_lsdb.Get(id);
+    for (auto& id : area.m_routerLSA_set) {
+        if (lsdb.DetectMaxAge(id)) continue; // フラッシュされたフラグメント
+        Ptr<OSPFLSA> rtrLSA = lsdb.Get(id);
         NS_LOG_INFO("building ... " << *rtrLSA);
-        RouterId routerId = rtrLSA->GetHeader()->GetAdvertisingRouter();
+        RouterId routerId = rtrLSA->GetHeader().GetAdvertisingRouter();
         auto rtrBody = rtrLSA->GetBody<OSPFRouterLSABody>();
         for (uint32_t idx = 0, l = rtrBody->CountNeighbors(); idx < l; ++idx) {
+            if (rtrBody->GetType(idx) == 2) {
+                // トランジットネットワークへのリンク: 対応するNetwork-LSAがなければ使わない
+                auto network = networkVertices.find(std::make_pair(rtrBody->GetNeighborRouterId(idx), rtrBody->GetNeighborInterfaceId(idx)));
+                if (network == networkVertices.end()) continue;
+                table[routerId][network->second] = rtrBody->GetMetric(idx);
+                NS_LOG_LOGIC("add route base table: " << routerId << " -> network " << network->second << ", metric: " << rtrBody->GetMetric(idx));
+                continue;
+            }
             table[routerId][rtrBody->GetNeighborRouterId(idx)] = rtrBody->GetMetric(idx);
             NS_LOG_LOGIC("add route base table: " << routerId << " -> " << rtrBody->GetNeighborRouterId(idx) << ", metric: " << rtrBody->GetMetric(idx));
         }
     }
+    // ネットワークから接続ルータへのコストは0
+    for (auto& kv : networkVertices) {
+        Ptr<OSPFLSA> netLSA = lsdb.Get(OSPFLinkStateIdentifier(OSPF_LSA_TYPE_NETWORK, kv.first.second, kv.first.first));
+        auto netBody = netLSA->GetBody<OSPFNetworkLSABody>();
+        for (uint32_t idx = 0, l = netBody->CountAttachedRouters(); idx < l; ++idx) {
+            RouterId attachedId = netBody->GetAttachedRouter(idx);
+            if (attachedId >= routers) continue;
+            table[kv.second][attachedId] = 0;
+            NS_LOG_LOGIC("add route base table: network " << kv.second << " -> " << attachedId << ", metric: 0");
+        }
+    }
 
     NS_LOG_LOGIC("print calculation table for #router: " << m_routerId);
     for (auto& col : table) {
@@ -2106,50 +3656,25 @@ void Ipv6OspfRouting::CalcRoutingTable (bool recalcAll) {
     }
 
     NS_LOG_INFO("iterate dijkstra's algorithm");
-    std::priority_queue<
-        std::pair<uint32_t, RouterId>, // cost, id
-        std::vector<std::pair<uint32_t, RouterId>>,
-        std::greater<std::pair<uint32_t, RouterId>>
-    > pq;
-    pq.push(std::make_pair(0, m_routerId));
-    uint16_t currCost, tmpCost, adjCost;
-    RouterId currId, adjRtrId;
-    NS_LOG_INFO("iterate dijkstra's algorithm - loop start");
-    while (!pq.empty()) {
-        currCost = pq.top().first;
-        currId = pq.top().second;
-        pq.pop();
-        NS_LOG_INFO(" currState - id: " << currId << ", cost: " << currCost);
-        if (table[currId].size()) {
-            for (auto& kv : table[currId]) { // unorderedなので順序保証なし
-                adjRtrId = kv.first;
-                adjCost = kv.second;
-                tmpCost = currCost + adjCost;
-                if (
-                    tmpCost < costs[adjRtrId] || (
-                        tmpCost == costs[adjRtrId] && currId < prevs[adjRtrId] // 等しかったらID若い方を優先
-                    )
-                ) {
-                    costs[adjRtrId] = tmpCost;
-                    prevs[adjRtrId] = currId;
-                    pq.push(std::make_pair(tmpCost, adjRtrId));
-                    NS_LOG_LOGIC(" pushState - id: " << adjRtrId << ", cost: " << tmpCost);
-                }
-            }
-        }
-    }
+    RunDijkstra(table, m_routerId, costs, prevs);
 
     // ネクストホップ復元 - prevs[i]はi番目に行くためのネクストホップを格納
+    // 直接つながったトランジットネットワークの先にいるルータも、直接のネクストホップになる
     std::unordered_set<RouterId> directConnected_set;
     std::vector<RouterId> directConnected_ids;
     NS_LOG_INFO("# rebuild nexthops");
     for (uint32_t i = 0, l = routers; i < l; ++i) {
-        if (prevs[i] == m_routerId) {
+        if (
+            prevs[i] == m_routerId || (
+                prevs[i] >= routers &&
+                prevs[prevs[i]] == m_routerId
+            )
+        ) {
             directConnected_set.insert(i);
             directConnected_ids.push_back(i);
         }
     }
-    for (uint32_t i = 0, l = routers; i < l; ++i) {
+    for (uint32_t i = 0, l = vertices; i < l; ++i) {
         while (prevs[i] && !directConnected_set.count(prevs[i])) {
             prevs[i] = prevs[prevs[i]];
         }
@@ -2158,55 +3683,462 @@ void Ipv6OspfRouting::CalcRoutingTable (bool recalcAll) {
         prevs[item] = item;
     }
 
-    // 別名つけておく
-    std::vector<RouterId>& nextHops = prevs;
+    // RFC 5286 3.1 代替経路の候補である隣接ルータからの距離
+    if (neighborCosts) {
+        neighborCosts->clear();
+        std::vector<uint32_t> neighborPrevs;
+        for (auto item : directConnected_ids) {
+            std::vector<uint32_t>& neighborCost = (*neighborCosts)[item];
+            neighborCost.assign(vertices, INFCOST);
+            neighborPrevs.assign(vertices, 0);
+            RunDijkstra(table, item, neighborCost, neighborPrevs);
+        }
+    }
+    if (graph) {
+        graph->swap(table);
+    }
 
     NS_LOG_INFO("nextHops: #" << nextHops.size());
     for (int i = 0, l = nextHops.size(); i < l; ++i) {
         NS_LOG_INFO("[ " << i << " ]: " << nextHops[i]);
     }
+}
+
+void Ipv6OspfRouting::CalcRoutingTable (bool recalcAll) {
+    NS_LOG_FUNCTION(m_routerId << recalcAll);
+    // Graceful Restart中は再起動前の経路表でフォワーディングを続ける
+    if (m_restarting) {
+        NS_LOG_LOGIC("routing table is kept during graceful restart: router " << m_routerId);
+        return;
+    }
+    if (m_inProcessingBatch || m_lfaHoldEvent.IsRunning()) {
+        m_deferredCalc = true;
+        m_deferredCalcAll = m_deferredCalcAll || recalcAll;
+        return;
+    }
+    bool isAreaBorderRouter = IsAreaBorderRouter();
+
+    // エリアごとにSPFを計算し、intra-area経路と、ABRが広告したinter-area経路を集める
+    // 同じプレフィクスならintra-area経路を優先し、その中ではコストの小さいものを選ぶ
+    AreaRouteMap intraRoutes, interRoutes;
+    std::vector<uint32_t> costs;
+    std::vector<RouterId> nextHops;
+    std::map<RouterId, std::vector<uint32_t> > neighborCosts;
+    bool isMaxFlow = m_routeEngine == RouteEngine::MAX_FLOW;
+    SpfTable graph, reversed;
+    std::map<RouterId, std::vector<AreaNextHop> > flowNextHops;
+    for (auto& areaKv : m_areas) {
+        uint32_t areaId = areaKv.first;
+        AreaData& area = areaKv.second;
+        OSPFLSDB& lsdb = area.GetLSDB();
+        CalcAreaShortestPath(areaId, costs, nextHops, m_loopFreeAlternate ? &neighborCosts : nullptr, isMaxFlow ? &graph : nullptr);
+        if (isMaxFlow) {
+            reversed.clear();
+            flowNextHops.clear();
+            for (auto& from : graph) {
+                for (auto& to : from.second) {
+                    reversed[to.first][from.first] = to.second;
+                }
+            }
+        }
+
+        NS_LOG_INFO("# rebuild network structure - area " << areaId);
+        // ルータからネットワークを復元する
+        for (auto& id : area.m_intraAreaPrefixLSA_set) {
+            NS_LOG_INFO("iterate...");
+            if (lsdb.DetectMaxAge(id)) continue;
+            Ptr<OSPFLSA> lsa = lsdb.Get(id);
+            RouterId routerId = lsa->GetHeader().GetAdvertisingRouter();
+            OSPFIntraAreaPrefixLSABody* body = lsa->GetBody<OSPFIntraAreaPrefixLSABody>();
+            bool isSelfOriginated = id.IsOriginatedBy(m_routerId, m_rtrIfaceId_set);
+            if (body->GetReferenceType() != OSPF_LSA_TYPE_ROUTER) continue;
+            if (!isSelfOriginated && (routerId >= costs.size() || costs[routerId] == INFCOST)) continue;
 
-    NS_LOG_INFO("# rebuild network structure");
-    // ルータからネットワークを復元する
-    m_routingTable.Clear();
-    for (auto& id : m_intraAreaPrefixLSA_set) {
-        NS_LOG_INFO("iterate...");
-        Ptr<OSPFLSA> lsa = m_lsdb.Get(id);
-        RouterId routerId = lsa->GetHeader()->GetAdvertisingRouter();
-        Ptr<OSPFIntraAreaPrefixLSABody> body = lsa->GetBody<OSPFIntraAreaPrefixLSABody>();
-        bool isSelfOriginated = id.IsOriginatedBy(m_routerId, m_rtrIfaceId_set);
-
-        if (body->GetReferenceType() == OSPF_LSA_TYPE_ROUTER) {
             NS_LOG_INFO("prefixes: " << body->CountPrefixes());
             for (uint32_t idx = 0, l = body->CountPrefixes(); idx < l; ++idx) {
                 // self originatedな場合、自明にdirectly connected
-                Ipv6RoutingTableEntry* rtentry = new Ipv6RoutingTableEntry();
                 Ipv6Prefix prefix(body->GetPrefixLength(idx));
                 Ipv6Address address = body->GetPrefixAddress(idx);
 
                 int32_t ifaceIdx = (
                     isSelfOriginated ?
                         m_ipv6->GetInterfaceForPrefix(address, prefix) :
-                        GetInterfaceForNeighbor(nextHops[routerId])
+                        GetInterfaceForNeighbor(areaId, nextHops[routerId])
                 );
                 if (ifaceIdx < 0) continue;
-                NS_LOG_INFO("address: " << address << ", " << prefix << " , ifaceIdx: " << ifaceIdx);
-                *rtentry = Ipv6RoutingTableEntry::CreateNetworkRouteTo(
-                    address, // dest address
-                    prefix, // prefix
-                    Ipv6Address::GetZero(), // nextHop address
-                    ifaceIdx // output ifaceIdx
-                );
-                m_routingTable.AddRoute(*rtentry);
+
+                AreaRoute route;
+                route.m_cost = (isSelfOriginated ? 0 : costs[routerId]) + body->GetPrefixMetric(idx);
+                route.m_areaId = areaId;
+                route.m_ifaceIdx = ifaceIdx;
+                // 共有セグメントではネクストホップのルータをリンクローカルアドレスで指定する
+                route.m_gateway = Ipv6Address::GetZero();
+                if (!isSelfOriginated && !m_interfaces[ifaceIdx].IsType(InterfaceType::P2P)) {
+                    route.m_gateway = m_interfaces[ifaceIdx].GetNeighbor(nextHops[routerId]).GetAddress();
+                }
+                if (!isSelfOriginated && m_loopFreeAlternate) {
+                    SelectLoopFreeAlternate(areaId, routerId, costs, nextHops, neighborCosts, route);
+                }
+                if (!isSelfOriginated && isMaxFlow) {
+                    route.m_multipath = CalcMaxFlowNextHops(areaId, graph, reversed, costs.size(), routerId, flowNextHops);
+                }
+                NS_LOG_INFO("address: " << address << ", " << prefix << " , ifaceIdx: " << ifaceIdx << ", gateway: " << route.m_gateway << ", cost: " << route.m_cost);
+
+                AreaRoutePrefix key(address, body->GetPrefixLength(idx));
+                auto found = intraRoutes.find(key);
+                if (found == intraRoutes.end() || route.m_cost < found->second.m_cost) {
+                    intraRoutes[key] = route;
+                }
+            }
+        }
+
+        // OSPFv2 16.2 Calculating the inter-area routes
+        // ABRはバックボーンのものだけを見る(仮想リンクは未実装)
+        if (isAreaBorderRouter && !area.IsBackbone()) continue;
+        for (auto& id : area.m_interAreaPrefixLSA_set) {
+            if (lsdb.DetectMaxAge(id)) continue;
+            if (id.IsOriginatedBy(m_routerId, m_rtrIfaceId_set)) continue;
+            RouterId abrId = id.m_advRtr;
+            if (abrId >= costs.size() || costs[abrId] == INFCOST) continue;
+            Ptr<OSPFLSA> lsa = lsdb.Get(id);
+            OSPFInterAreaPrefixLSABody* body = lsa->GetBody<OSPFInterAreaPrefixLSABody>();
+            if (body->GetMetric() >= g_lsInfinity) continue;
+
+            int32_t ifaceIdx = GetInterfaceForNeighbor(areaId, nextHops[abrId]);
+            if (ifaceIdx < 0) continue;
+
+            AreaRoute route;
+            route.m_cost = costs[abrId] + body->GetMetric();
+            route.m_areaId = areaId;
+            route.m_ifaceIdx = ifaceIdx;
+            route.m_gateway = Ipv6Address::GetZero();
+            if (!m_interfaces[ifaceIdx].IsType(InterfaceType::P2P)) {
+                route.m_gateway = m_interfaces[ifaceIdx].GetNeighbor(nextHops[abrId]).GetAddress();
+            }
+            if (m_loopFreeAlternate) {
+                SelectLoopFreeAlternate(areaId, abrId, costs, nextHops, neighborCosts, route);
+            }
+            if (isMaxFlow) {
+                route.m_multipath = CalcMaxFlowNextHops(areaId, graph, reversed, costs.size(), abrId, flowNextHops);
             }
+            NS_LOG_INFO("inter-area address: " << body->GetPrefixAddress() << "/" << (uint16_t)body->GetPrefixLength() << " via ABR " << abrId << ", cost: " << route.m_cost);
+
+            AreaRoutePrefix key(body->GetPrefixAddress(), body->GetPrefixLength());
+            auto found = interRoutes.find(key);
+            if (found == interRoutes.end() || route.m_cost < found->second.m_cost) {
+                interRoutes[key] = route;
+            }
+        }
+    }
+
+    m_routingTable.Clear();
+    for (auto& kv : intraRoutes) {
+        Ipv6RoutingTableEntry rtentry = Ipv6RoutingTableEntry::CreateNetworkRouteTo(
+            kv.first.first, // dest address
+            Ipv6Prefix(kv.first.second), // prefix
+            kv.second.m_gateway, // nextHop address
+            kv.second.m_ifaceIdx // output ifaceIdx
+        );
+        m_routingTable.AddRoute(rtentry);
+        if (kv.second.m_backupIfaceIdx >= 0) {
+            Ipv6RoutingTableEntry backup = Ipv6RoutingTableEntry::CreateNetworkRouteTo(
+                kv.first.first, Ipv6Prefix(kv.first.second), kv.second.m_backupGateway, kv.second.m_backupIfaceIdx
+            );
+            m_routingTable.AddBackupRoute(backup);
+        }
+        for (auto& hop : kv.second.m_multipath) {
+            Ipv6RoutingTableEntry path = Ipv6RoutingTableEntry::CreateNetworkRouteTo(
+                kv.first.first, Ipv6Prefix(kv.first.second), hop.m_gateway, hop.m_ifaceIdx
+            );
+            m_routingTable.AddMultipathRoute(path, hop.m_weight);
+        }
+    }
+    for (auto it = interRoutes.begin(); it != interRoutes.end(); ) {
+        if (intraRoutes.count(it->first)) {
+            it = interRoutes.erase(it);
+            continue;
+        }
+        Ipv6RoutingTableEntry rtentry = Ipv6RoutingTableEntry::CreateNetworkRouteTo(
+            it->first.first,
+            Ipv6Prefix(it->first.second),
+            it->second.m_gateway,
+            it->second.m_ifaceIdx
+        );
+        m_routingTable.AddRoute(rtentry);
+        if (it->second.m_backupIfaceIdx >= 0) {
+            Ipv6RoutingTableEntry backup = Ipv6RoutingTableEntry::CreateNetworkRouteTo(
+                it->first.first, Ipv6Prefix(it->first.second), it->second.m_backupGateway, it->second.m_backupIfaceIdx
+            );
+            m_routingTable.AddBackupRoute(backup);
+        }
+        for (auto& hop : it->second.m_multipath) {
+            Ipv6RoutingTableEntry path = Ipv6RoutingTableEntry::CreateNetworkRouteTo(
+                it->first.first, Ipv6Prefix(it->first.second), hop.m_gateway, hop.m_ifaceIdx
+            );
+            m_routingTable.AddMultipathRoute(path, hop.m_weight);
+        }
+        ++it;
+    }
+
+    // ABRでなくなった場合も、以前広告したものをフラッシュするために呼ぶ
+    for (auto& kv : m_areas) {
+        OriginateInterAreaPrefixLSAs(kv.first, intraRoutes, interRoutes);
+    }
+}
+
+// OSPFv2 12.4.3 Summary-LSAs
+// https://tools.ietf.org/html/rfc2328#page-130
+// 他のエリアのintra-area経路を、そのエリアの範囲でまとめてareaIdへ広告する
+// バックボーン以外のエリアには、バックボーンから学んだinter-area経路も広告する
+void Ipv6OspfRouting::OriginateInterAreaPrefixLSAs(uint32_t areaId, const AreaRouteMap& intraRoutes, const AreaRouteMap& interRoutes) {
+    NS_LOG_FUNCTION(m_routerId << areaId);
+    AreaData& area = GetArea(areaId);
+
+    std::map<AreaRoutePrefix, uint32_t> advertised;
+    if (IsAreaBorderRouter() && !area.IsTotallyStubby()) {
+        for (auto& kv : intraRoutes) {
+            const AreaRoute& route = kv.second;
+            if (route.m_areaId == areaId) continue;
+            const AreaRange* range = GetArea(route.m_areaId).FindRange(kv.first.first, kv.first.second);
+            if (!range) {
+                advertised[kv.first] = route.m_cost;
+                continue;
+            }
+            if (!range->m_advertise) continue;
+            // 範囲のコストは含まれる経路のコストの最大値
+            AreaRoutePrefix rangePrefix(range->m_prefix, range->m_prefixLength);
+            auto found = advertised.find(rangePrefix);
+            if (found == advertised.end() || found->second < route.m_cost) {
+                advertised[rangePrefix] = route.m_cost;
+            }
+        }
+        if (!area.IsBackbone()) {
+            for (auto& kv : interRoutes) {
+                if (!advertised.count(kv.first)) {
+                    advertised[kv.first] = kv.second.m_cost;
+                }
+            }
+        }
+    }
+    // OSPFv2 12.4.3.1 スタブエリアにはデフォルト経路を広告する
+    if (IsAreaBorderRouter() && area.IsStub()) {
+        advertised[AreaRoutePrefix(g_defaultDestination, 0)] = area.GetStubDefaultCost();
+    }
+
+    // 広告しなくなったものはMaxAgeにしてフラッシュする
+    std::map<AreaRoutePrefix, uint32_t>& lsIds = area.GetSummaryLsIds();
+    for (auto it = lsIds.begin(); it != lsIds.end(); ) {
+        if (advertised.count(it->first)) {
+            ++it;
+            continue;
+        }
+        uint32_t lsId = it->second;
+        it = lsIds.erase(it);
+        FlushInterAreaPrefixLSA(areaId, lsId);
+    }
+    for (auto& kv : advertised) {
+        OriginateInterAreaPrefixLSA(areaId, area.GetSummaryLsId(kv.first), kv.first, std::min(kv.second, g_lsInfinity - 1));
+    }
+}
+
+// プレフィクスごとに1つ生成する。内容が変わらなければ何もしない
+// 経路表の計算から呼ばれるので、ここから経路表を計算し直さない
+void Ipv6OspfRouting::OriginateInterAreaPrefixLSA(uint32_t areaId, uint32_t lsId, const AreaRoutePrefix& prefix, uint32_t metric) {
+    NS_LOG_FUNCTION(m_routerId << areaId << lsId << prefix.first << (uint16_t)prefix.second << metric);
+    OSPFLSDB& lsdb = GetArea(areaId).GetLSDB();
+    OSPFLinkStateIdentifier id(OSPF_LSA_TYPE_INTER_AREA_PREFIX, lsId, m_routerId);
+
+    OSPFInterAreaPrefixLSABody body;
+    body.SetMetric(metric);
+    body.SetPrefix(prefix.first, prefix.second);
+    if (
+        lsdb.Has(id) &&
+        !lsdb.DetectMaxAge(id) &&
+        *lsdb.Get(id)->GetBody<OSPFInterAreaPrefixLSABody>() == body
+    ) {
+        return;
+    }
+    if (DeferOriginationIfThrottled(areaId, id)) {
+        return;
+    }
+
+    Ptr<OSPFLSA> lsa;
+    if (lsdb.Has(id)) {
+        NS_LOG_LOGIC("インスタンス更新 - Inter-Area-Prefix-LSA for " << m_routerId);
+        lsa = lsdb.Get(id);
+        OSPFLSAHeader& hdr = lsa->GetHeader();
+        hdr.SetAge(0);
+        hdr.IncrementSequenceNumber();
+    } else {
+        NS_LOG_LOGIC("新規インスタンス作成 - Inter-Area-Prefix-LSA for " << m_routerId);
+        lsa = Ptr<OSPFLSA>(new OSPFLSA());
+        lsa->Initialize(OSPF_LSA_TYPE_INTER_AREA_PREFIX);
+        OSPFLSAHeader& hdr = lsa->GetHeader();
+        hdr.SetAge(0);
+        hdr.InitializeSequenceNumber();
+        hdr.SetId(lsId);
+        hdr.SetAdvertisingRouter(m_routerId);
+    }
+    *lsa->GetBody<OSPFInterAreaPrefixLSABody>() = body;
+
+    NS_LOG_INFO("Inter-Area-Prefix-LSA for #" << m_routerId << " area " << areaId << " result: " << *lsa);
+
+    RegisterToLSDB(areaId, lsa);
+    m_lastOriginationTime[std::make_pair(areaId, id)] = Simulator::Now();
+    RemoveFromAllRxmtList(areaId, id);
+    AppendToRxmtList(lsa, areaId, 0, m_routerId);
+}
+
+void Ipv6OspfRouting::FlushInterAreaPrefixLSA(uint32_t areaId, uint32_t lsId) {
+    NS_LOG_FUNCTION (m_routerId << areaId << lsId);
+    OSPFLSDB& lsdb = GetArea(areaId).GetLSDB();
+    OSPFLinkStateIdentifier id(OSPF_LSA_TYPE_INTER_AREA_PREFIX, lsId, m_routerId);
+
+    auto pending = m_deferredOrigination.find(std::make_pair(areaId, id));
+    if (pending != m_deferredOrigination.end()) {
+        pending->second.Cancel();
+        m_deferredOrigination.erase(pending);
+    }
+    if (!lsdb.Has(id) || lsdb.DetectMaxAge(id)) {
+        return;
+    }
+
+    NS_LOG_LOGIC("フラッシュ - Inter-Area-Prefix-LSA for " << m_routerId << " area " << areaId << " lsId " << lsId);
+    Ptr<OSPFLSA> lsa = lsdb.Get(id);
+    lsa->GetHeader().SetAge(g_maxAge);
+    RegisterToLSDB(areaId, lsa);
+    RemoveFromAllRxmtList(areaId, id);
+    AppendToRxmtList(lsa, areaId, 0, m_routerId);
+}
+
+// RFC 5286 3.2 Basic Loop-Free Condition: D(N, D) < D(N, S) + D(S, D)
+// どちらかに届かない隣接ルータは代替にしない
+bool Ipv6OspfRouting::IsLoopFree (uint32_t neighborToDestination, uint32_t neighborToSelf, uint32_t selfToDestination) {
+    if (neighborToDestination == INFCOST || neighborToSelf == INFCOST) return false;
+    return neighborToDestination < (uint64_t)neighborToSelf + selfToDestination;
+}
+
+// 主経路と別のインターフェイスにいる隣接ルータNのうち、条件を満たし総コストが最小のものを選ぶ
+void Ipv6OspfRouting::SelectLoopFreeAlternate (uint32_t areaId, RouterId destination, const std::vector<uint32_t>& costs,
+                                               const std::vector<RouterId>& nextHops,
+                                               const std::map<RouterId, std::vector<uint32_t> >& neighborCosts, AreaRoute& route) {
+    RouterId primary = nextHops[destination];
+    uint64_t bestCost = UINT64_MAX;
+    for (auto& kv : neighborCosts) {
+        RouterId neighborId = kv.first;
+        const std::vector<uint32_t>& fromNeighbor = kv.second;
+        if (neighborId == primary || neighborId == m_routerId) continue;
+        if (!IsLoopFree(fromNeighbor[destination], fromNeighbor[m_routerId], costs[destination])) continue;
+        int32_t ifaceIdx = GetInterfaceForNeighbor(areaId, neighborId);
+        if (ifaceIdx < 0 || ifaceIdx == route.m_ifaceIdx) continue;
+        uint64_t cost = (uint64_t)costs[neighborId] + fromNeighbor[destination];
+        if (cost >= bestCost) continue;
+        bestCost = cost;
+        route.m_backupIfaceIdx = ifaceIdx;
+        route.m_backupGateway = Ipv6Address::GetZero();
+        if (!m_interfaces[ifaceIdx].IsType(InterfaceType::P2P)) {
+            route.m_backupGateway = m_interfaces[ifaceIdx].GetNeighbor(neighborId).GetAddress();
+        }
+    }
+    NS_LOG_LOGIC("LFA for router " << destination << ": iface " << route.m_backupIfaceIdx);
+}
+
+// destinationへの最大フローを、自身から出ていく量でネクストホップに按分する
+// 宛先までの距離が減る辺だけを使うので、各ルータが独立に計算してもループしない
+// ただしトランジットネットワークから接続ルータへの辺(コスト0)は距離が等しくてもよい
+// 容量はメトリックの逆数に比例させる(メトリックは参照帯域 / 伝送速度)
+const std::vector<AreaNextHop>& Ipv6OspfRouting::CalcMaxFlowNextHops (uint32_t areaId, const SpfTable& graph, const SpfTable& reversed,
+                                                                      uint32_t vertices, RouterId destination,
+                                                                      std::map<RouterId, std::vector<AreaNextHop> >& cache) {
+    auto cached = cache.find(destination);
+    if (cached != cache.end()) {
+        return cached->second;
+    }
+    NS_LOG_FUNCTION(m_routerId << areaId << destination);
+    std::vector<AreaNextHop>& result = cache[destination];
+    uint32_t routers = m_knownMaxRouterId + 1;
+
+    std::vector<uint32_t> costsTo(vertices, INFCOST);
+    std::vector<uint32_t> prevs(vertices, 0);
+    RunDijkstra(reversed, destination, costsTo, prevs);
+    if (costsTo[m_routerId] == INFCOST) {
+        return result;
+    }
+
+    MaxFlowGraph flowGraph;
+    flowGraph.Reset(vertices);
+    for (auto& from : graph) {
+        if (costsTo[from.first] == INFCOST) continue;
+        for (auto& to : from.second) {
+            bool isNetwork = from.first >= routers;
+            if (isNetwork ? costsTo[to.first] > costsTo[from.first] : costsTo[to.first] >= costsTo[from.first]) continue;
+            flowGraph.AddEdge(from.first, to.first, to.second ? 0xffff / to.second : UINT32_MAX);
+        }
+    }
+    flowGraph.Compute(m_routerId, destination);
+
+    // 直接のネクストホップはルータ。トランジットネットワークを経由するなら、その先の流れで按分する
+    std::map<RouterId, uint64_t> shares;
+    std::vector<std::pair<uint32_t, uint32_t> > flows, networkFlows;
+    flowGraph.GetOutgoingFlows(m_routerId, flows);
+    for (auto& flow : flows) {
+        if (flow.first < routers) {
+            shares[flow.first] += flow.second;
+            continue;
+        }
+        flowGraph.GetOutgoingFlows(flow.first, networkFlows);
+        uint64_t networkTotal = 0;
+        for (auto& networkFlow : networkFlows) networkTotal += networkFlow.second;
+        if (networkTotal == 0) continue;
+        for (auto& networkFlow : networkFlows) {
+            if (networkFlow.first == m_routerId) continue;
+            shares[networkFlow.first] += std::max<uint64_t>(1, (uint64_t)flow.second * networkFlow.second / networkTotal);
         }
     }
+
+    for (auto& kv : shares) {
+        int32_t ifaceIdx = GetInterfaceForNeighbor(areaId, kv.first);
+        if (ifaceIdx < 0) continue;
+        AreaNextHop hop;
+        hop.m_ifaceIdx = ifaceIdx;
+        hop.m_gateway = Ipv6Address::GetZero();
+        if (!m_interfaces[ifaceIdx].IsType(InterfaceType::P2P)) {
+            hop.m_gateway = m_interfaces[ifaceIdx].GetNeighbor(kv.first).GetAddress();
+        }
+        hop.m_weight = std::min<uint64_t>(kv.second, UINT32_MAX);
+        result.push_back(hop);
+        NS_LOG_LOGIC("max flow to router " << destination << ": via " << kv.first << " (iface " << ifaceIdx << "), weight " << hop.m_weight);
+    }
+    return result;
+}
+
+// 再計算の結果が出るまで、ifaceIdxを使う経路を代替経路で置き換えておく
+void Ipv6OspfRouting::ActivateLoopFreeAlternates (uint32_t ifaceIdx) {
+    NS_LOG_FUNCTION(m_routerId << ifaceIdx);
+    if (!m_loopFreeAlternate) return;
+    uint32_t activated = m_routingTable.ActivateBackupRoutes(ifaceIdx);
+    NS_LOG_INFO("router " << m_routerId << " switched " << activated << " routes away from interface " << ifaceIdx);
+    // 続くIF_DOWNやKillNbrのSPFで代替経路が消えないよう、再計算を保留する
+    if (activated > 0 && m_lfaHoldTime.IsStrictlyPositive() && !m_lfaHoldEvent.IsRunning()) {
+        m_lfaHoldEvent = Simulator::Schedule(m_lfaHoldTime, &Ipv6OspfRouting::FinishLocalRepair, this);
+    }
+}
+
+// 保留中に要求された再計算をまとめて1回行う
+void Ipv6OspfRouting::FinishLocalRepair () {
+    NS_LOG_FUNCTION(m_routerId);
+    if (m_deferredCalc) {
+        bool recalcAll = m_deferredCalcAll;
+        m_deferredCalc = false;
+        m_deferredCalcAll = false;
+        CalcRoutingTable(recalcAll);
+    }
 }
 
-int32_t Ipv6OspfRouting::GetInterfaceForNeighbor (RouterId routerId) {
-    NS_LOG_FUNCTION(m_routerId << "target: " << routerId);
+int32_t Ipv6OspfRouting::GetInterfaceForNeighbor (uint32_t areaId, RouterId routerId) {
+    NS_LOG_FUNCTION(m_routerId << areaId << "target: " << routerId);
     for (InterfaceData& ifaceData : m_interfaces) {
-        if (ifaceData.HasNeighbor(routerId)) {
+        if (ifaceData.GetAreaId() == areaId && ifaceData.HasNeighbor(routerId)) {
             NS_LOG_LOGIC("returns: " << ifaceData.GetInterfaceId());
             return ifaceData.GetInterfaceId();
         }
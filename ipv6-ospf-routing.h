@@ -3,18 +3,26 @@
 
 #include <stdint.h>
 
+#include <deque>
 #include <list>
+#include <set>
+#include <unordered_map>
 
 #include "ns3/ptr.h"
 #include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/data-rate.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/ipv6.h"
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-routing-protocol.h"
 #include "ospf-routing-table.h"
 #include "ospf-struct-interface.h"
+#include "ospf-struct-area.h"
 #include "ospf-link-state-database.h"
 #include "ospf-lsa-identifier.h"
+#include "ospf-header.h"
+#include "ospf-packet-view.h"
 
 namespace ns3 {
 namespace ospf {
@@ -28,6 +36,15 @@ namespace ospf {
 // class Ipv6MulticastRoutingTableEntry;
 typedef uint32_t RouterId;
 
+// 経路計算の方式
+namespace RouteEngineNS {
+enum Type {
+    SHORTEST_PATH, // OSPFv2 16.1 最短経路
+    MAX_FLOW, // 宛先に近づく辺だけの最大フローで、重み付きマルチパスにする
+};
+}
+typedef RouteEngineNS::Type RouteEngine;
+
 class Ipv6OspfRouting : public Ipv6RoutingProtocol {
 
 private:
@@ -40,32 +57,139 @@ private:
     uint32_t m_routerId;
     uint32_t m_knownMaxRouterId;
 
-    typedef std::map< Ptr<Socket>, uint32_t > SocketToIfaceIdx;
-    typedef std::map< uint32_t, Ptr<Socket> > IfaceIdxToSocket;
-
-    SocketToIfaceIdx m_socketToIfaceIdx;
-    IfaceIdxToSocket m_ifaceIdxToSocket;
-    SocketToIfaceIdx m_llmSocketToIfaceIdx;
-    IfaceIdxToSocket m_ifaceIdxToLlmSocket;
+    // ルータごとに1つのraw socketで送受信する
+    // 受信時はパケットのRecvIf(NetDeviceのifIndex)からifaceIdxを引き、送信時はifaceIdxからNetDeviceを引く
+    Ptr<Socket> m_socket;
+    std::map<uint32_t, uint32_t> m_deviceToIfaceIdx; // NetDeviceのifIndex -> ifaceIdx
+    std::vector<Ptr<NetDevice> > m_ifaceIdxToDevice;
+    std::vector<uint8_t> m_rxBuffer; // 受信パケットを連続領域に展開するための再利用バッファ
+    // 送信するOSPFパケットのTraffic Class。優先キューでデータより先に送り出させる
+    uint8_t m_trafficClass;
+
+    // パケットタイプで引く受信ハンドラ表
+    typedef void (Ipv6OspfRouting::*PacketHandler)(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet);
+    static const PacketHandler s_packetHandlers[OSPF_TYPE_LIVENESS_PROBE + 1];
+
+    // 受信処理の優先度付きキュー(RFC 4222): m_processingBatchSizeが0なら受信したその場で処理する
+    // 1以上なら検証済みのパケットをキューに入れ、Hello・LSAck・生存確認のプローブを先に処理し、
+    // 残りは1回にm_processingBatchSize個ずつ処理して、経路表の再計算をバッチの終わりに1回にまとめる
+    struct QueuedPacket {
+        uint32_t m_ifaceIdx;
+        Ipv6Address m_srcAddr;
+        std::vector<uint8_t> m_data;
+    };
+    uint32_t m_processingBatchSize;
+    std::deque<QueuedPacket> m_urgentPackets;
+    std::deque<QueuedPacket> m_bulkPackets;
+    EventId m_processingEvent;
+    bool m_inProcessingBatch;
+    bool m_deferredCalc;
+    bool m_deferredCalcAll;
     std::vector<InterfaceData> m_interfaces;
     RoutingTable m_routingTable;
-    OSPFLSDB m_lsdb;
     Time m_lastLsuSendTime;
     std::set<uint32_t> m_rtrIfaceId_set;
 
-    // area data structureだが簡単のために書いてしまう
-    std::set<OSPFLinkStateIdentifier> m_intraAreaPrefixLSA_set;
-    std::set<OSPFLinkStateIdentifier> m_routerLSA_set;
+    // エリアごとにLSDBとSPFを持つ。接続しているエリアが2つ以上ならABRとしてふるまう
+    std::map<uint32_t, AreaData> m_areas;
+    std::map<uint32_t, uint32_t> m_interfaceAreas; // ifaceIdx -> Area ID、なければ1
+
+    // プレフィクス抑制(RFC 6860相当): ここに含まれるP2Pインターフェイスは、FULLの隣接がある間
+    // (中継専用のリンクである間)そのプレフィクスをIntra-Area-Prefix-LSAに載せない
+    std::set<uint32_t> m_prefixSuppressedIfaces;
+    bool m_isAreaBorderRouter = false;
 
     bool m_tableUpdateRequired = false;
     bool m_tableUpdateReducible = false;
 
+    // MinLSInterval: 自己生成LSAごとの最終生成時刻と、まとめて遅延実行する再生成イベント
+    // Router-LSAなどはエリアごとに同じLink State IDを使うので、Area IDと組にして引く
+    typedef std::pair<uint32_t, OSPFLinkStateIdentifier> AreaLinkStateIdentifier;
+    std::map<AreaLinkStateIdentifier, Time> m_lastOriginationTime;
+    std::map<AreaLinkStateIdentifier, EventId> m_deferredOrigination;
+    std::set<AreaLinkStateIdentifier> m_deferredForceRefresh; // 遅延中の要求にforceRefreshが含まれていたもの
+
+    // 高速な生存確認(BFD相当): インターフェイスごとにm_livenessIntervalでプローブを送り、
+    // m_livenessInterval * m_livenessMultiplierの間プローブが届かないネイバーをKillNbrする
+    // m_livenessIntervalが0なら無効
+    Time m_livenessInterval;
+    uint32_t m_livenessMultiplier;
+
+    // 窓付きDD交換: 1なら通常のロックステップ
+    // 2以上かつネイバーもOSPF_OPTION_DD_WINDOWを立てていれば、masterは最大この数のDDを未確認のまま送る
+    uint32_t m_ddWindowSize;
+
+    // ブロードキャストインターフェイスのRouter Priority、0ならDR/BDRにならない
+    uint8_t m_routerPriority;
+
+    // メトリック = 参照帯域 / インターフェイスの伝送速度 (1以上0xffff以下に丸める)
+    // 計算結果はInterfaceDataにキャッシュし、RefreshInterfaceMetricsか参照帯域の変更で作り直す
+    DataRate m_referenceBandwidth;
+    std::map<uint32_t, uint16_t> m_interfaceMetrics; // ifaceIdx -> 手動設定のメトリック
+
+    // ループフリー代替経路(RFC 5286): SPFのついでに隣接ルータを根とする最短距離も求め、
+    // 宛先ごとに別インターフェイスの代替ネクストホップを経路表に持つ
+    // 出力インターフェイスが落ちたら、フラッディングと再計算を待たずに代替経路へ切り替える
+    // 切り替えた後m_lfaHoldTimeの間は経路表の再計算を保留し、代替経路を上書きしない
+    bool m_loopFreeAlternate;
+    Time m_lfaHoldTime;
+    EventId m_lfaHoldEvent;
+
+    RouteEngine m_routeEngine;
+
+    // 動的フラッディング(RFC 9667相当): 全ルータがLSDBから同じ疎なフラッディングトポロジを計算し、
+    // P2Pの隣接のうちトポロジ上のものにだけフラッディングする
+    // トポロジが分断しているか、トポロジ上の隣接がFULLでなければ通常のフラッディングに戻す
+    bool m_floodingReduction;
+
+    // 隣接の再確立時、ExStartのDDにLLSでLSDBのバケットごとのダイジェストを載せる
+    // 全バケットが一致すればExchange/Loadingを省いてFULLにし、
+    // 一致しなければ異なるバケットのLSAだけをSummary Listに入れる
+    bool m_lsdbDigest;
+
+    // Graceful Restart(RFC 5187, RFC 3623)
+    // restarter: StartGracefulRestartからExitGracefulRestartまで経路表を保ち、LSAを生成しない
+    // 再起動前にFULLだった隣接が全てFULLに戻るか、猶予期間が過ぎたら終わる
+    // helper: ネイバーからGrace-LSAを受け取ったら、猶予期間の間そのネイバーをFULLとして広告し続ける
+    Time m_gracePeriod;
+    bool m_gracefulRestartHelper;
+    bool m_restarting;
+    EventId m_restartTimer;
+    std::set<std::pair<uint32_t, RouterId> > m_restartNeighbors; // (ifaceIdx, routerId)
+
+    // スタブルータ(RFC 6987): Router-LSAの全リンクをMaxLinkMetricで広告し、トランジットに使わせない
+    // 自身のプレフィクスはIntra-Area-Prefix-LSAのメトリックのままなので到達できる
+    // 起動後m_stubRouterOnStartupの間と、SetStubRouterで指定した間だけ有効
+    Time m_stubRouterOnStartup;
+    bool m_stubRouter;
+    EventId m_stubRouterTimer;
+
+    // 隣接確立のペーシング(RFC 4222): Exchange/Loadingの隣接を同時に最大m_maxConcurrentAdjacencies本に抑える
+    // 枠が空いていなければExStartのまま待たせ、枠が空いたら最後に受け取ったDDでネゴシエーションをやり直す
+    // 0なら無制限
+    uint32_t m_maxConcurrentAdjacencies;
+    uint32_t m_adjacenciesInProgress;
+    std::list<std::pair<uint32_t, RouterId> > m_pendingAdjacencies; // (ifaceIdx, routerId)
+
+    // Router-LSAとIntra-Area-Prefix-LSAの分割(RFC 5340 4.4.3.2)
+    // インターフェイスをifaceIdx順にm_maxLsaSizeに収まる数ずつまとめ、まとまりごとに別のLink State IDで生成する
+    // 分割されうるときは中身の変わったフラグメントだけを作り直す。0ならIPv6の最小MTUから決める
+    uint32_t m_maxLsaSize;
+    std::map<std::pair<uint32_t, uint16_t>, std::set<uint32_t> > m_lsaFragments; // (areaId, LS Type) -> 生成中のLink State ID
+
+    // 窓付きフラッディング: 0なら従来どおり、Rxmt Listを再送の周期ごとに1パケットずつ送る
+    // 1以上ならネイバーごとの確認応答待ちのLSA数の初期窓で、Rxmt Listに入れたらすぐ窓の分だけ送る
+    uint32_t m_floodWindow;
+
     /**
     * \brief Ipv6 reference.
     */
     Ptr<Ipv6> m_ipv6;
 
 public:
+    // SPFの入力となる有向グラフ [from][to] = metric
+    typedef std::unordered_map<uint32_t, std::unordered_map<uint32_t, uint16_t> > SpfTable;
+
     static TypeId GetTypeId ();
 
     Ipv6OspfRouting ();
@@ -88,44 +212,116 @@ public:
     virtual void SetIpv6 (Ptr<Ipv6> ipv6);
     virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const;
 
-    virtual void HandleProtocolMessage (Ptr<Socket> socket);
+    // インターフェイスが上がる前に呼ぶこと
+    virtual void SetInterfaceArea (uint32_t ifaceIdx, uint32_t areaId);
+    // 中継専用のP2Pリンクのプレフィクスを広告しないようにする
+    virtual void SetInterfacePrefixSuppression (uint32_t ifaceIdx, bool suppress);
+    virtual bool IsPrefixSuppressed (uint32_t ifaceIdx);
+    // 伝送速度によらないメトリックを設定する。0なら自動計算に戻す
+    virtual void SetInterfaceMetric (uint32_t ifaceIdx, uint16_t metric);
+    virtual void SetReferenceBandwidth (DataRate referenceBandwidth);
+    virtual DataRate GetReferenceBandwidth () const;
+    // デバイスやチャネルのDataRateを変更したら呼ぶこと。メトリックが変わったインターフェイスのLSAを再生成する
+    virtual void RefreshInterfaceMetrics ();
+    // ABRとしてareaIdの経路を他のエリアへ広告するとき、範囲に含まれるものを1つにまとめる
+    virtual void AddAreaRange (uint32_t areaId, Ipv6Address prefix, uint8_t prefixLength, bool advertise = true);
+    // スタブエリアにする。バックボーンは指定できない
+    // noSummaryならtotally stubbyにし、ABRはデフォルト経路だけを広告する
+    virtual void SetStubArea (uint32_t areaId, bool noSummary = false, uint32_t defaultCost = 1);
+    virtual AreaData& GetArea (uint32_t areaId);
+    virtual bool IsAreaBorderRouter ();
+    virtual uint32_t GetOptionsForInterface (uint32_t ifaceIdx);
+    virtual void StartGracefulRestart ();
+    virtual void SetStubRouter (bool stub);
+    virtual bool IsStubRouter () const;
+    virtual bool IsRestarting () const;
 
-    virtual void ReceiveHelloPacket(uint32_t ifaceIdx, Ipv6Address srcAddr, Ptr<Packet> packet);
-    virtual void ReceiveDatabaseDescriptionPacket(uint32_t ifaceIdx, Ptr<Packet> packet);
-    virtual void ReceiveLinkStateRequestPacket(uint32_t ifaceIdx, Ptr<Packet> packet);
-    virtual void ReceiveLinkStateUpdatePacket(uint32_t ifaceIdx, Ptr<Packet> packet);
-    virtual void ReceiveLinkStateAckPacket(uint32_t ifaceIdx, Ptr<Packet> packet);
+    virtual void HandleProtocolMessage (Ptr<Socket> socket);
+    virtual void ProcessQueuedPackets ();
+    virtual void DispatchQueuedPacket (const QueuedPacket& queued);
+    virtual Ptr<Packet> BuildPacket (uint32_t ifaceIdx, const OSPFHeader& header, Ipv6Address dstAddr);
+    virtual void SendToInterface (uint32_t ifaceIdx, const OSPFHeader& header, Ipv6Address dstAddr);
+    virtual void SendToInterface (uint32_t ifaceIdx, Ptr<Packet> packet, Ipv6Address dstAddr);
+
+    virtual void ReceiveHelloPacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet);
+    virtual void ReceiveDatabaseDescriptionPacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet);
+    virtual void ReceiveLinkStateRequestPacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet);
+    virtual void ReceiveLinkStateUpdatePacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet);
+    virtual void ReceiveLinkStateAckPacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet);
+    virtual void ReceiveLivenessProbePacket(uint32_t ifaceIdx, Ipv6Address srcAddr, const OSPFPacketView& packet);
 
     virtual void SendHelloPacket(uint32_t ifaceIdx);
+    virtual void SendLivenessProbe(uint32_t ifaceIdx);
     virtual void SendDatabaseDescriptionPacket(uint32_t ifaceIdx, RouterId neighborRouterId = 0, bool isInit = false);
+    virtual bool ProcessDatabaseDescriptionHeaders(uint32_t areaId, NeighborData& neighData, const OSPFDatabaseDescriptionView& ddPacket);
+    virtual void ReceiveWindowedDatabaseDescription(uint32_t ifaceIdx, RouterId neighborRouterId, const OSPFDatabaseDescriptionView& ddPacket);
+    virtual Ptr<Packet> BuildWindowedDatabaseDescription(uint32_t ifaceIdx, RouterId neighborRouterId, int32_t seqNum, bool masterFlag);
+    virtual void SendDatabaseDescriptionWindow(uint32_t ifaceIdx, RouterId neighborRouterId);
+    virtual void RetransmitDatabaseDescriptionWindow(uint32_t ifaceIdx, RouterId neighborRouterId);
     virtual void SendLinkStateRequestPacket(uint32_t ifaceIdx, RouterId neighborRouterId = 0);
     virtual void SendLinkStateUpdatePacketEntryPoint();
     virtual void SendLinkStateUpdatePacket(uint32_t ifaceIdx);
     virtual void SendLinkStateUpdatePacket(uint32_t ifaceIdx, RouterId neighborRouterId);
     virtual void SendLinkStateUpdatePacketDirectAsap(uint32_t ifaceIdx, Ptr<OSPFLSA> lsa, RouterId neighborRouterId = 0);
     virtual void SendLinkStateUpdatePacketDirect(uint32_t ifaceIdx, std::vector<Ptr<OSPFLSA> >& lsas, RouterId neighborRouterId = 0);
-    virtual void SendLinkStateAckPacket(uint32_t ifaceIdx, Ptr<OSPFLSAHeader> lsaHeader , RouterId neighborRouterId = 0);
-    virtual void SendLinkStateAckPacket(uint32_t ifaceIdx, std::vector<Ptr<OSPFLSAHeader> >& lsaHeaders , RouterId neighborRouterId = 0);
+    virtual void SendLinkStateAckPacket(uint32_t ifaceIdx, const OSPFLSAHeader& lsaHeader , RouterId neighborRouterId = 0);
+    virtual void SendLinkStateAckPacket(uint32_t ifaceIdx, std::vector<OSPFLSAHeader>& lsaHeaders , RouterId neighborRouterId = 0);
 
     virtual void NotifyInterfaceEvent(uint32_t ifaceIdx, InterfaceEvent event);
     virtual void NotifyNeighborEvent(uint32_t ifaceIdx, RouterId neighborRouterId, NeighborEvent event);
     virtual bool IsNeighborToBeAdjacent(uint32_t ifaceIdx, RouterId neighborRouterId);
-    virtual void RemoveFromAllRxmtList(OSPFLinkStateIdentifier& id);
+    virtual void NegotiateExchange(uint32_t ifaceIdx, RouterId neighborRouterId);
+    virtual void ResumePendingAdjacencies();
+    virtual void CalcDesignatedRouter(uint32_t ifaceIdx);
+    virtual void RemoveFromAllRxmtList(uint32_t areaId, OSPFLinkStateIdentifier& id);
     virtual Time& GetLastLSUSentTime ();
-    virtual void AppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t ifaceIdx, RouterId senderRouterId, bool sendAsap = false);
+    virtual void AppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t areaId, uint32_t ifaceIdx, RouterId senderRouterId, bool sendAsap = false);
+    virtual void CalcFloodingTopology (uint32_t areaId);
+    virtual bool IsFloodingReduced (uint32_t areaId);
+    virtual void FloodToNeighbor (uint32_t ifaceIdx, RouterId neighborRouterId, Ptr<OSPFLSA> lsa, bool sendAsap);
+    virtual void SendLinkStateUpdateWindow (uint32_t ifaceIdx, RouterId neighborRouterId);
     virtual void DirectAppendToRxmtList (Ptr<OSPFLSA> lsa, uint32_t ifaceIdx, RouterId neighborRouterId, bool sendAsap = false);
 
     virtual uint16_t CalcMetricForInterface (uint32_t ifaceIdx);
+    virtual uint64_t GetInterfaceBitRate (uint32_t ifaceIdx);
 
     virtual void OriginateRouterSpecificLSAs(uint32_t ifaceIdx, bool forceRefresh = false);
     virtual void OriginateLinkLSA(uint32_t ifaceIdx, bool forceRefresh = false);
-    virtual void OriginateRouterLSA(bool forceRefresh = false);
-    virtual void OriginateIntraAreaPrefixLSA(bool forceRefresh = false);
+    virtual void OriginateRouterLSA(uint32_t areaId, bool forceRefresh = false);
+    virtual void OriginateIntraAreaPrefixLSA(uint32_t areaId, bool forceRefresh = false);
+    virtual void OriginateNetworkLSA(uint32_t ifaceIdx, bool forceRefresh = false);
+    virtual uint32_t CalcLsaSizeBudget ();
+    virtual uint32_t CalcInterfacesPerFragment (uint32_t areaId, uint16_t type);
+    virtual void OriginateFragment (uint32_t areaId, Ptr<OSPFLSA> fresh, bool onlyIfChanged);
+    virtual void FlushStaleFragments (uint32_t areaId, uint16_t type, const std::set<uint32_t>& fragments);
+    virtual bool IsOriginatedFragment (uint32_t areaId, const OSPFLinkStateIdentifier& id);
+    virtual void FlushNetworkLSA(uint32_t ifaceIdx);
+    virtual void OriginateInterAreaPrefixLSAs(uint32_t areaId, const AreaRouteMap& intraRoutes, const AreaRouteMap& interRoutes);
+    virtual void OriginateInterAreaPrefixLSA(uint32_t areaId, uint32_t lsId, const AreaRoutePrefix& prefix, uint32_t metric);
+    virtual void FlushInterAreaPrefixLSA(uint32_t areaId, uint32_t lsId);
+    virtual bool DeferOriginationIfThrottled(uint32_t areaId, const OSPFLinkStateIdentifier& id, bool forceRefresh = false);
+    virtual void OriginateDeferredLSA(uint32_t areaId, OSPFLinkStateIdentifier id);
+    virtual void OriginateGraceLSA(uint32_t ifaceIdx, bool flush);
+    virtual void ExitGracefulRestart();
+    virtual void EnterHelperMode(uint32_t ifaceIdx, RouterId neighborRouterId, Time gracePeriod);
+    virtual void ExitHelperMode(uint32_t ifaceIdx, RouterId neighborRouterId);
 
     virtual void CalcRoutingTable (bool recalcAll = false);
-    virtual int32_t GetInterfaceForNeighbor (RouterId routerId);
-    virtual void RegisterToLSDB (Ptr<OSPFLSA> lsa);
-    virtual void UpdateLSACaches (Ptr<OSPFLSA> lsa);
+    virtual void CalcAreaShortestPath (uint32_t areaId, std::vector<uint32_t>& costs, std::vector<RouterId>& nextHops,
+                                       std::map<RouterId, std::vector<uint32_t> >* neighborCosts = nullptr,
+                                       SpfTable* graph = nullptr);
+    virtual const std::vector<AreaNextHop>& CalcMaxFlowNextHops (uint32_t areaId, const SpfTable& graph, const SpfTable& reversed,
+                                                                 uint32_t vertices, RouterId destination,
+                                                                 std::map<RouterId, std::vector<AreaNextHop> >& cache);
+    virtual void SelectLoopFreeAlternate (uint32_t areaId, RouterId destination, const std::vector<uint32_t>& costs,
+                                          const std::vector<RouterId>& nextHops,
+                                          const std::map<RouterId, std::vector<uint32_t> >& neighborCosts, AreaRoute& route);
+    static bool IsLoopFree (uint32_t neighborToDestination, uint32_t neighborToSelf, uint32_t selfToDestination);
+    virtual void ActivateLoopFreeAlternates (uint32_t ifaceIdx);
+    virtual void FinishLocalRepair ();
+    virtual int32_t GetInterfaceForNeighbor (uint32_t areaId, RouterId routerId);
+    virtual void RegisterToLSDB (uint32_t areaId, Ptr<OSPFLSA> lsa);
+    virtual void UpdateLSACaches (uint32_t areaId, Ptr<OSPFLSA> lsa);
     virtual void AddToRxmtList (int32_t ifaceIdx, Ptr<OSPFLSA> lsa);
     virtual void AddToRxmtList (int32_t ifaceIdx, RouterId neighborRouterId, Ptr<OSPFLSA> lsa);
     
@@ -14,6 +14,10 @@ static const uint32_t g_maxAge = 3600; // seconds
 static const uint32_t g_checkAge = 300; // seconds
 static const int32_t g_maxAgeDiff = 900; // seconds
 static const uint32_t g_lsInfinity = 0xffffff;
+static const uint16_t g_maxLinkMetric = 0xffff; // RFC 6987
+static const uint32_t g_prefixesPerInterfaceSlot = 4; // Intra-Area-Prefix-LSAのフラグメントでインターフェイスごとに見込むプレフィクス数
+static const uint8_t g_trafficClassCS6 = 0xc0; // Internetwork Control (RFC 2328 A.1)
+static const uint32_t g_backboneAreaId = 0;
 static const Ipv6Address g_defaultDestination;
 static const int32_t g_initialSeqNum = 0x80000001;
 static const int32_t g_maxSeqNum = 0x7fffffff;
@@ -0,0 +1,54 @@
+#include "ipv6-ospf-routing-helper.h"
+#include "ospf-constants.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/ipv6-queue-disc-item.h"
+#include "ns3/queue-disc.h"
+#include <iostream>
+using namespace std;
+
+static Ptr<QueueDiscItem> CreateIpv6Item (uint8_t trafficClass, uint32_t size) {
+    Ipv6Header header;
+    header.SetTrafficClass(trafficClass);
+    header.SetNextHeader(89); // OSPF
+    header.SetPayloadLength(size);
+    return Create<Ipv6QueueDiscItem>(Create<Packet>(size), Address(), 0x86DD, header);
+}
+
+// InstallControlPriorityQueueDiscで入れたキューディスクが、
+// 先に詰まっているデータより後から来たCS6のパケットを先に出すことを確かめる
+void TestForOSPFControlPriority () {
+
+    cout << " - TestForOSPFControlPriority - " << endl;
+    NodeContainer nodes;
+    nodes.Create(2);
+    InternetStackHelper internet;
+    internet.SetIpv4StackInstall(false);
+    internet.Install(nodes);
+    PointToPointHelper p2p;
+    NetDeviceContainer devices = p2p.Install(nodes);
+
+    ns3::ospf::Ipv6OspfRoutingHelper helper;
+    QueueDiscContainer qdiscs = helper.InstallControlPriorityQueueDisc(devices);
+    NS_ABORT_MSG_UNLESS(qdiscs.GetN() == 2, "queue disc is not installed on every device");
+    Ptr<QueueDisc> qdisc = qdiscs.Get(0);
+    // パケットフィルタと内部キューが揃っていなければここで止まる
+    qdisc->Initialize();
+
+    for (uint32_t i = 0; i < 10; ++i) {
+        NS_ABORT_MSG_UNLESS(qdisc->Enqueue(CreateIpv6Item(0, 1000)), "bulk packet is dropped");
+    }
+    NS_ABORT_MSG_UNLESS(qdisc->Enqueue(CreateIpv6Item(ns3::ospf::g_trafficClassCS6, 64)), "OSPF packet is dropped");
+
+    Ptr<QueueDiscItem> first = qdisc->Dequeue();
+    NS_ABORT_MSG_UNLESS(first && first->GetPacket()->GetSize() == 64, "OSPF packet is not sent ahead of bulk traffic");
+    NS_ABORT_MSG_UNLESS(qdisc->Dequeue()->GetPacket()->GetSize() == 1000, "bulk packet is lost");
+
+    Simulator::Destroy();
+    return;
+}
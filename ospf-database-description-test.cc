@@ -1,8 +1,11 @@
 #include "ospf-database-description.h"
+#include "ospf-packet-view.h"
+#include "ospf-link-state-database.h"
 #include "ns3/test.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include <iostream>
 using namespace std;
 
@@ -20,7 +23,7 @@ void TestForOSPFDatabaseDescription () {
     srcHdr.SetMoreFlag(false);
     srcHdr.SetMasterFlag(true);
     srcHdr.SetSequenceNumber(6789);
-    srcHdr.SetLSAHeaders(vector<Ptr<ns3::ospf::OSPFLSAHeader> >(3));
+    srcHdr.SetLSAHeaders(vector<ns3::ospf::OSPFLSAHeader>(3));
 
     Ptr<Packet> packet = Create<Packet>();
     packet->AddHeader(srcHdr);
@@ -29,5 +32,73 @@ void TestForOSPFDatabaseDescription () {
 
     NS_ASSERT(srcHdr == dstHdr);
 
+    // LLSデータブロックで運ぶLSDBダイジェスト
+    ns3::ospf::OSPFDatabaseDescription digestHdr, digestDstHdr;
+    digestHdr.SetAreaId(234);
+    digestHdr.SetRouterId(123);
+    digestHdr.SetOptions(0x13 | OSPF_OPTION_L);
+    digestHdr.SetMtu(1500);
+    digestHdr.SetInitFlag(true);
+    digestHdr.SetMoreFlag(true);
+    digestHdr.SetMasterFlag(true);
+    digestHdr.SetSequenceNumber(6789);
+    vector<uint32_t> digest;
+    for (uint32_t i = 0; i < 16; ++i) {
+        digest.push_back(0x01020304 * (i + 1));
+    }
+    digestHdr.SetLsdbDigest(digest);
+
+    packet = Create<Packet>();
+    packet->AddHeader(digestHdr);
+    NS_ASSERT(packet->GetSize() == 16 + 12 + 8 + 16 * 4);
+    packet->RemoveHeader(digestDstHdr);
+    NS_ASSERT(digestHdr == digestDstHdr);
+    NS_ASSERT(digestDstHdr.GetPacketLength() == 16 + 12);
+
+    packet = Create<Packet>();
+    packet->AddHeader(digestHdr);
+    vector<uint8_t> buffer(packet->GetSize());
+    packet->CopyData(buffer.data(), buffer.size());
+    ns3::ospf::OSPFPacketView view;
+    NS_ABORT_MSG_UNLESS(view.Parse(buffer.data(), buffer.size()), "DD view parse failed");
+    NS_ASSERT(view.GetTrailerSize() == 8 + 16 * 4);
+    ns3::ospf::OSPFLLSView lls;
+    NS_ABORT_MSG_UNLESS(lls.Parse(view), "LLS block parse failed");
+    const uint8_t* value;
+    uint16_t length;
+    NS_ABORT_MSG_UNLESS(lls.FindTLV(OSPF_LLS_TYPE_LSDB_DIGEST, value, length), "LSDB digest TLV not found");
+    NS_ASSERT(length == 16 * 4);
+    NS_ASSERT(ns3::ospf::OSPFPacketView::ReadU32(value + 4) == digest[1]);
+    NS_ABORT_MSG_UNLESS(!lls.FindTLV(1, value, length), "unknown TLV was found");
+    buffer[buffer.size() - 1] ^= 0xff;
+    NS_ABORT_MSG_UNLESS(!lls.Parse(view), "corrupted LLS block was accepted");
+
+    // フラッシュ済み(MaxAge)のコピーと生きているコピーは、シーケンス番号が同じでもダイジェストが異なる
+    Ptr<ns3::ospf::OSPFLSA> live = Ptr<ns3::ospf::OSPFLSA>(new ns3::ospf::OSPFLSA());
+    live->Initialize(OSPF_LSA_TYPE_ROUTER);
+    live->GetHeader().SetId(0);
+    live->GetHeader().SetAdvertisingRouter(7);
+    live->GetHeader().InitializeSequenceNumber();
+    live->GetBody<ns3::ospf::OSPFRouterLSABody>()->AddNeighbor(1, 10, 1, 2, 8);
+    Ptr<ns3::ospf::OSPFLSA> flushed = Ptr<ns3::ospf::OSPFLSA>(new ns3::ospf::OSPFLSA(*live));
+    flushed->GetHeader().SetAge(ns3::ospf::g_maxAge);
+
+    ns3::ospf::OSPFLSDB liveDb, flushedDb;
+    liveDb.Add(live);
+    flushedDb.Add(flushed);
+    NS_ASSERT(liveDb.GetBucketDigests() != flushedDb.GetBucketDigests());
+
+    // 同じシーケンス番号でも本文が違えばダイジェストが異なる
+    Ptr<ns3::ospf::OSPFLSA> changed = Ptr<ns3::ospf::OSPFLSA>(new ns3::ospf::OSPFLSA(*live));
+    changed->GetBody<ns3::ospf::OSPFRouterLSABody>()->AddNeighbor(1, 10, 3, 4, 9);
+    ns3::ospf::OSPFLSDB changedDb;
+    changedDb.Add(changed);
+    NS_ASSERT(liveDb.GetBucketDigests() != changedDb.GetBucketDigests());
+
+    // 同じインスタンスなら一致する
+    ns3::ospf::OSPFLSDB sameDb;
+    sameDb.Add(Ptr<ns3::ospf::OSPFLSA>(new ns3::ospf::OSPFLSA(*live)));
+    NS_ASSERT(liveDb.GetBucketDigests() == sameDb.GetBucketDigests());
+
     return;
 }
\ No newline at end of file
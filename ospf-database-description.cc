@@ -25,12 +25,17 @@ bool m_initFlag;
 bool m_moreFlag;
 bool m_masterFlag;
 uint32_t m_ddSeqNum;
-vector<Ptr<OSPFLSAHeader> > m_lsaHeaders;
+vector<OSPFLSAHeader> m_lsaHeaders;
+vector<uint32_t> m_lsdbDigest;
 */
 
 uint32_t OSPFDatabaseDescription::GetSerializedSize () const {
-    return OSPFHeader::GetSerializedSize() + 12 + m_lsaHeaders.size() * 20;
-} 
+    return OSPFHeader::GetSerializedSize() + 12 + m_lsaHeaders.size() * 20 + GetTrailerSize();
+}
+// LLSヘッダ(4バイト) + LSDBダイジェストのTLV
+uint32_t OSPFDatabaseDescription::GetTrailerSize () const {
+    return m_lsdbDigest.empty() ? 0 : 4 + 4 + m_lsdbDigest.size() * 4;
+}
 void OSPFDatabaseDescription::Print (std::ostream &os) const {
     OSPFHeader::Print(os);
     os << "## DatabaseDescription Packet (";
@@ -44,7 +49,7 @@ void OSPFDatabaseDescription::Print (std::ostream &os) const {
     os << "ddSeqNum: " << m_ddSeqNum << ", ";
     os << "lsaHeader: " << m_lsaHeaders.size() << ", ";
     for (int i = 0, l = m_lsaHeaders.size(); i < l; ++i) {
-        m_lsaHeaders[i]->Print(os);
+        m_lsaHeaders[i].Print(os);
     }
 } 
 void OSPFDatabaseDescription::Serialize (Buffer::Iterator start) const {
@@ -82,8 +87,32 @@ void OSPFDatabaseDescription::Serialize (Buffer::Iterator start) const {
     // uint32_t size = m_lsaHeaders.size();
     // start.WriteHtonU32(size);
     for(int idx = 0, l = m_lsaHeaders.size(); idx < l; ++idx) {
-        m_lsaHeaders[idx]->Serialize(start);
+        m_lsaHeaders[idx].Serialize(start);
     }
+    if (m_lsdbDigest.empty()) {
+        return;
+    }
+/*
+    RFC 5613 2.2 LLS Data Block (Packet Lengthの後ろ)
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |            Checksum           |       LLS Data Length         |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |              Type             |            Length             |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                        Bucket Digests                         |
+      |                             ...                               |
+*/
+    uint32_t llsSize = GetTrailerSize();
+    Buffer::Iterator lls = start;
+    start.WriteHtonU16(0);
+    start.WriteHtonU16(llsSize / 4);
+    start.WriteHtonU16(OSPF_LLS_TYPE_LSDB_DIGEST);
+    start.WriteHtonU16(m_lsdbDigest.size() * 4);
+    for (uint32_t digest : m_lsdbDigest) {
+        start.WriteHtonU32(digest);
+    }
+    Buffer::Iterator itr = lls;
+    lls.WriteU16(itr.CalculateIpChecksum(llsSize));
 }
 uint32_t OSPFDatabaseDescription::Deserialize (Buffer::Iterator start) {
     start.Next(OSPFHeader::Deserialize(start));
@@ -95,14 +124,45 @@ uint32_t OSPFDatabaseDescription::Deserialize (Buffer::Iterator start) {
     m_masterFlag = buff & 0x1;
     m_ddSeqNum = start.ReadNtohU32();
     
-    uint32_t size = (m_packetLength - GetSerializedSize()) / 20;
+    uint32_t size = (m_packetLength - OSPFHeader::GetSerializedSize() - 12) / 20;
     m_lsaHeaders.resize(size);
     for(int idx = 0, l = size; idx < l; ++idx) {
-        m_lsaHeaders[idx] = Create<OSPFLSAHeader>();
-        m_lsaHeaders[idx]->Deserialize(start);
+        m_lsaHeaders[idx].Deserialize(start);
+    }
+
+    // LLSデータブロックからはLSDBダイジェストのTLVだけを読み、他のTLVは飛ばす
+    m_lsdbDigest.clear();
+    uint32_t llsSize = 0;
+    if ((m_options & OSPF_OPTION_L) && start.GetRemainingSize() >= 4) {
+        start.ReadNtohU16();
+        llsSize = start.ReadNtohU16() * 4;
+        if (llsSize < 4 || llsSize > start.GetRemainingSize() + 4) {
+            return OSPFHeader::GetSerializedSize() + 12 + size * 20 + 4;
+        }
+        uint32_t remain = llsSize - 4;
+        while (remain >= 4) {
+            uint16_t type = start.ReadNtohU16();
+            uint16_t length = start.ReadNtohU16();
+            uint32_t padded = (length + 3) & ~3u;
+            remain -= 4;
+            if (padded > remain) {
+                break;
+            }
+            if (type == OSPF_LLS_TYPE_LSDB_DIGEST) {
+                m_lsdbDigest.resize(length / 4);
+                for (uint32_t& digest : m_lsdbDigest) {
+                    digest = start.ReadNtohU32();
+                }
+                start.Next(padded - m_lsdbDigest.size() * 4);
+            } else {
+                start.Next(padded);
+            }
+            remain -= padded;
+        }
+        start.Next(remain);
     }
 
-    return OSPFDatabaseDescription::GetSerializedSize ();
+    return OSPFHeader::GetSerializedSize() + 12 + size * 20 + llsSize;
 }
 
 } // namespace ns3
@@ -10,6 +10,14 @@ using namespace ns3;
 namespace ns3 {
 namespace ospf {
 
+// 独自拡張: 窓付きDD交換に対応していることを示すOptionsビット
+// 双方が立てている場合のみ、複数のDDを同時に送る
+#define OSPF_OPTION_DD_WINDOW 0x800000
+
+// 独自拡張: LSDBダイジェストを運ぶLLS TLV (RFC 5613 2.3, Private Use)
+// 値はLSDBのバケットごとのダイジェストを並べたもの
+#define OSPF_LLS_TYPE_LSDB_DIGEST 32768
+
 class OSPFDatabaseDescription : public OSPFHeader {
 private:
     uint32_t m_options;
@@ -18,11 +26,18 @@ private:
     bool m_moreFlag;
     bool m_masterFlag;
     uint32_t m_ddSeqNum;
-    std::vector<Ptr<OSPFLSAHeader> > m_lsaHeaders;
+    std::vector<OSPFLSAHeader> m_lsaHeaders;
+    std::vector<uint32_t> m_lsdbDigest; // 空でなければLLSデータブロックで送る
 
 public:
     OSPFDatabaseDescription () : OSPFHeader () {
         SetType(OSPF_TYPE_DATABASE_DESCRIPTION);
+        m_options = 0;
+        m_mtu = 0;
+        m_initFlag = false;
+        m_moreFlag = false;
+        m_masterFlag = false;
+        m_ddSeqNum = 0;
     };
     ~OSPFDatabaseDescription () {};
 
@@ -34,6 +49,7 @@ public:
     virtual uint32_t GetSerializedSize () const;
     virtual void Print (std::ostream &os) const;
     virtual void Serialize (Buffer::Iterator start) const;
+    virtual uint32_t GetTrailerSize () const;
 
     void SetOptions(uint32_t options) {m_options = options;}
     uint32_t GetOptions() const {return m_options;}
@@ -47,8 +63,11 @@ public:
     bool GetMasterFlag() const {return m_masterFlag;}
     void SetSequenceNumber(uint32_t ddSeqNum) {m_ddSeqNum = ddSeqNum;}
     uint32_t GetSequenceNumber() const {return m_ddSeqNum;}
-    void SetLSAHeaders(std::vector<Ptr<OSPFLSAHeader> > headers) {m_lsaHeaders = headers;}
-    std::vector<Ptr<OSPFLSAHeader> >& GetLSAHeaders() {return m_lsaHeaders;}
+    void SetLSAHeaders(const std::vector<OSPFLSAHeader>& headers) {m_lsaHeaders = headers;}
+    std::vector<OSPFLSAHeader>& GetLSAHeaders() {return m_lsaHeaders;}
+    // 空でないダイジェストを設定したらOptionsのLビットも立てること
+    void SetLsdbDigest(const std::vector<uint32_t>& digest) {m_lsdbDigest = digest;}
+    const std::vector<uint32_t>& GetLsdbDigest() const {return m_lsdbDigest;}
     bool IsNegotiation () {
         return m_initFlag && m_moreFlag && m_masterFlag && m_lsaHeaders.size() == 0;
     }
@@ -64,7 +83,8 @@ public:
             m_moreFlag == other.m_moreFlag &&
             m_masterFlag == other.m_masterFlag &&
             m_ddSeqNum == other.m_ddSeqNum &&
-            m_lsaHeaders == other.m_lsaHeaders
+            m_lsaHeaders == other.m_lsaHeaders &&
+            m_lsdbDigest == other.m_lsdbDigest
         );
     }
 };
@@ -0,0 +1,111 @@
+#include "ospf-grace-lsa.h"
+#include "ospf-lsa.h"
+#include "ospf-link-state-database.h"
+#include "ospf-struct-neighbor.h"
+#include "ns3/test.h"
+#include "ns3/buffer.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include <iostream>
+using namespace std;
+
+static Ptr<ns3::ospf::OSPFLSA> CopyLSA (Ptr<ns3::ospf::OSPFLSA> lsa) {
+    return Ptr<ns3::ospf::OSPFLSA>(new ns3::ospf::OSPFLSA(*lsa));
+}
+
+void TestForOSPFGraceLSA () {
+
+    cout << " - TestForOSPFGraceLSA - " << endl;
+
+    // TLVの並び(Grace Period, Restart Reason)
+    ns3::ospf::OSPFGraceLSABody srcBody, dstBody;
+    srcBody.SetGracePeriod(120);
+    srcBody.SetRestartReason(OSPF_GRACE_REASON_SOFTWARE_RESTART);
+    Buffer buffer;
+    buffer.AddAtStart(srcBody.GetSerializedSize());
+    Buffer::Iterator itr = buffer.Begin();
+    srcBody.Serialize(itr);
+    NS_ASSERT(buffer.GetSize() == 16);
+    const uint8_t expected[16] = {0, 1, 0, 4, 0, 0, 0, 120, 0, 2, 0, 1, OSPF_GRACE_REASON_SOFTWARE_RESTART, 0, 0, 0};
+    NS_ABORT_MSG_UNLESS(std::equal(expected, expected + 16, buffer.PeekData()), "Grace-LSA TLVs are not encoded as RFC 3623 Appendix A");
+    itr = buffer.Begin();
+    NS_ASSERT(dstBody.Deserialize(itr, buffer.GetSize()) == 16);
+    NS_ASSERT(srcBody == dstBody);
+
+    // TLVの順序は任意で、知らないTypeは読み飛ばす
+    Buffer reordered;
+    reordered.AddAtStart(20);
+    itr = reordered.Begin();
+    itr.WriteHtonU16(2);
+    itr.WriteHtonU16(1);
+    itr.WriteU8(OSPF_GRACE_REASON_SOFTWARE_RELOAD);
+    itr.WriteU8(0);
+    itr.WriteHtonU16(0);
+    itr.WriteHtonU16(9);
+    itr.WriteHtonU16(2);
+    itr.WriteHtonU16(0xffff);
+    itr.WriteHtonU16(0);
+    itr.WriteHtonU16(1);
+    itr.WriteHtonU16(4);
+    itr.WriteHtonU32(300);
+    itr = reordered.Begin();
+    dstBody.Deserialize(itr, reordered.GetSize());
+    NS_ASSERT(dstBody.GetGracePeriod() == 300);
+    NS_ASSERT(dstBody.GetRestartReason() == OSPF_GRACE_REASON_SOFTWARE_RELOAD);
+
+    // helperになれるかどうか: 再送待ちに内容の変わったLSAがあるか
+    Ptr<ns3::ospf::OSPFLSA> lsa = Ptr<ns3::ospf::OSPFLSA>(new ns3::ospf::OSPFLSA());
+    lsa->Initialize(OSPF_LSA_TYPE_ROUTER);
+    lsa->GetHeader().SetId(0);
+    lsa->GetHeader().SetAdvertisingRouter(7);
+    lsa->GetHeader().InitializeSequenceNumber();
+    lsa->GetBody<ns3::ospf::OSPFRouterLSABody>()->AddNeighbor(1, 10, 1, 2, 8);
+    ns3::ospf::OSPFLSDB lsdb;
+    lsdb.Add(lsa);
+
+    // LSRefresh: 本文はそのままでシーケンス番号だけ進む
+    Ptr<ns3::ospf::OSPFLSA> refreshed = CopyLSA(lsa);
+    refreshed->GetHeader().IncrementSequenceNumber();
+    NS_ABORT_MSG_UNLESS(!lsdb.IsChangedInstance(refreshed), "received refresh is treated as a change");
+    lsdb.Add(refreshed);
+    NS_ABORT_MSG_UNLESS(!lsdb.IsChangedInstance(refreshed), "installed refresh is treated as a change");
+    // 格納済みのLSAをその場で作り直してUpdateDigestしても同じ
+    refreshed->GetHeader().IncrementSequenceNumber();
+    lsdb.UpdateDigest(refreshed->GetIdentifier());
+    lsdb.Add(refreshed);
+    NS_ABORT_MSG_UNLESS(!lsdb.IsChangedInstance(refreshed), "in-place refresh is treated as a change");
+
+    ns3::ospf::NeighborData neighbor;
+    Ptr<ns3::ospf::OSPFLSA> linkLsa = Ptr<ns3::ospf::OSPFLSA>(new ns3::ospf::OSPFLSA());
+    linkLsa->Initialize(OSPF_LSA_TYPE_LINK);
+    neighbor.AddRxmtList(linkLsa);
+    neighbor.AddRxmtList(refreshed);
+    NS_ABORT_MSG_UNLESS(!neighbor.HasChangedLSAInRxmtList(lsdb), "helper mode is refused for a routine refresh");
+
+    // 本文の変わったインスタンスはhelperを妨げる
+    Ptr<ns3::ospf::OSPFLSA> changed = CopyLSA(refreshed);
+    changed->GetHeader().IncrementSequenceNumber();
+    changed->GetBody<ns3::ospf::OSPFRouterLSABody>()->AddNeighbor(1, 10, 3, 4, 9);
+    NS_ABORT_MSG_UNLESS(lsdb.IsChangedInstance(changed), "received change is not detected");
+    lsdb.Add(changed);
+    neighbor.RemoveFromRxmtList(changed->GetIdentifier());
+    neighbor.AddRxmtList(changed);
+    NS_ABORT_MSG_UNLESS(neighbor.HasChangedLSAInRxmtList(lsdb), "helper mode is accepted with a changed LSA pending");
+    // 同じインスタンスを登録し直しても変化は消えない
+    lsdb.UpdateDigest(changed->GetIdentifier());
+    NS_ABORT_MSG_UNLESS(neighbor.HasChangedLSAInRxmtList(lsdb), "re-registration hides the change");
+
+    // 番号を進めずにMaxAgeにしたフラッシュも変化
+    Ptr<ns3::ospf::OSPFLSA> flushed = CopyLSA(changed);
+    flushed->GetHeader().SetAge(ns3::ospf::g_maxAge);
+    NS_ABORT_MSG_UNLESS(lsdb.IsChangedInstance(flushed), "received flush is not detected");
+    lsdb.Add(flushed);
+    NS_ABORT_MSG_UNLESS(lsdb.IsChangedInstance(flushed), "installed flush is not detected");
+
+    // 知らないLSAは新しい内容として扱う
+    Ptr<ns3::ospf::OSPFLSA> unknown = CopyLSA(lsa);
+    unknown->GetHeader().SetAdvertisingRouter(8);
+    NS_ABORT_MSG_UNLESS(lsdb.IsChangedInstance(unknown), "new LSA is not detected");
+
+    return;
+}
@@ -0,0 +1,60 @@
+#include "ospf-grace-lsa.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace ospf {
+
+/*
+uint32_t m_gracePeriod;
+uint8_t m_restartReason;
+*/
+
+NS_LOG_COMPONENT_DEFINE("OSPFGraceLSABody");
+
+uint32_t OSPFGraceLSABody::GetSerializedSize () const {
+    return 16;
+}
+void OSPFGraceLSABody::Print (std::ostream &os) const {
+    os << "(Grace LSA: [";
+    os << "gracePeriod: " << m_gracePeriod << ", ";
+    os << "restartReason: " << (uint16_t)m_restartReason;
+    os << "])";
+}
+void OSPFGraceLSABody::Serialize (Buffer::Iterator &i) const {
+    i.WriteHtonU16(1);
+    i.WriteHtonU16(4);
+    i.WriteHtonU32(m_gracePeriod);
+    i.WriteHtonU16(2);
+    i.WriteHtonU16(1);
+    i.WriteU8(m_restartReason);
+    i.WriteU8(0);
+    i.WriteHtonU16(0);
+}
+// TLVの並びは任意なので、知らないTypeは読み飛ばす
+uint32_t OSPFGraceLSABody::Deserialize (Buffer::Iterator &i, uint32_t remainBytes) {
+    m_gracePeriod = 0;
+    m_restartReason = OSPF_GRACE_REASON_UNKNOWN;
+    while (remainBytes >= 4) {
+        uint16_t type = i.ReadNtohU16();
+        uint16_t length = i.ReadNtohU16();
+        uint32_t padded = (length + 3) & ~3u;
+        remainBytes -= 4;
+        if (padded > remainBytes) {
+            break;
+        }
+        if (type == 1 && length == 4) {
+            m_gracePeriod = i.ReadNtohU32();
+        } else if (type == 2 && length == 1) {
+            m_restartReason = i.ReadU8();
+            i.Next(3);
+        } else {
+            i.Next(padded);
+        }
+        remainBytes -= padded;
+    }
+    i.Next(remainBytes);
+    return OSPFGraceLSABody::GetSerializedSize();
+}
+
+} // namespace ns3
+} // namespace ns3
@@ -0,0 +1,74 @@
+#ifndef OSPF_GRACE_LSA_H
+#define OSPF_GRACE_LSA_H
+
+/*
+    RFC 5187 / RFC 3623 Appendix A Grace-LSA
+
+       0                   1                   2                   3
+       0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |           LS Age              |0|0|0|          11             |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                  Link State ID (Interface ID)                 |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                     Advertising Router                        |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                     LS Sequence Number                        |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |        LS Checksum            |            Length             |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |           Type = 1            |          Length = 4           |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                  Grace Period (seconds)                       |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |           Type = 2            |          Length = 1           |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      | Restart Reason|                   Padding                     |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+                              Grace-LSA Format
+
+*/
+
+#include "ospf-lsa-header.h"
+
+using namespace ns3;
+
+namespace ns3 {
+namespace ospf {
+
+// Restart Reason
+#define OSPF_GRACE_REASON_UNKNOWN 0
+#define OSPF_GRACE_REASON_SOFTWARE_RESTART 1
+#define OSPF_GRACE_REASON_SOFTWARE_RELOAD 2
+#define OSPF_GRACE_REASON_SWITCH_TO_REDUNDANT 3
+
+class OSPFGraceLSABody {
+private:
+    uint32_t m_gracePeriod;
+    uint8_t m_restartReason;
+
+public:
+    OSPFGraceLSABody () : m_gracePeriod(0), m_restartReason(OSPF_GRACE_REASON_UNKNOWN) {};
+    ~OSPFGraceLSABody () {};
+
+    uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes);
+    uint32_t GetSerializedSize () const;
+    void Print (std::ostream &os) const;
+    void Serialize (Buffer::Iterator &i) const;
+
+    uint32_t GetGracePeriod() const {return m_gracePeriod;}
+    void SetGracePeriod(uint32_t seconds) {m_gracePeriod = seconds;}
+    uint8_t GetRestartReason() const {return m_restartReason;}
+    void SetRestartReason(uint8_t reason) {m_restartReason = reason;}
+    bool operator== (const OSPFGraceLSABody &other) const {
+        return (
+            m_gracePeriod == other.m_gracePeriod &&
+            m_restartReason == other.m_restartReason
+        );
+    }
+};
+
+}
+}
+#endif
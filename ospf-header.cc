@@ -51,7 +51,7 @@ void OSPFHeader::Serialize (Buffer::Iterator start) const {
 */
     start.WriteU8(m_version);
     start.WriteU8(m_type);
-    start.WriteHtonU16(GetSerializedSize());
+    start.WriteHtonU16(GetSerializedSize() - GetTrailerSize());
     start.WriteHtonU32(m_routerId);
     start.WriteHtonU32(m_areaId);
     start.WriteHtonU16(0);
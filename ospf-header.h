@@ -16,6 +16,13 @@ namespace ospf {
 #define OSPF_TYPE_LINK_STATE_REQUEST 3
 #define OSPF_TYPE_LINK_STATE_UPDATE 4
 #define OSPF_TYPE_LINK_STATE_ACK 5
+#define OSPF_TYPE_LIVENESS_PROBE 6 // 独自拡張: 高速な生存確認用
+
+// Options (RFC 5340 A.2)
+#define OSPF_OPTION_V6 0x01
+#define OSPF_OPTION_E 0x02
+#define OSPF_OPTION_R 0x10
+#define OSPF_OPTION_L 0x200 // RFC 5613 LLSデータブロックが付いている
 
 class OSPFHeader : public Header {
 protected:
@@ -49,6 +56,10 @@ public:
     virtual void Print (std::ostream &os) const; 
     virtual void Serialize (Buffer::Iterator start) const;
 
+    // Packet Lengthの後ろに付くLLSデータブロックなどの長さ
+    // GetSerializedSize()には含まれるが、Packet Lengthとチェックサムの対象には含まれない
+    virtual uint32_t GetTrailerSize () const {return 0;}
+
     void SetVersion(uint8_t version) {m_version = version;}
     uint8_t GetVersion() const {return m_version;}
     void SetType(uint8_t type) {m_type = type;}
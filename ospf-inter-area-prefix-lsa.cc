@@ -0,0 +1,66 @@
+#include "ospf-inter-area-prefix-lsa.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace ospf {
+
+/*
+uint32_t m_metric;
+uint8_t m_prefixLength;
+uint8_t m_prefixOptions;
+Ipv6Address m_addressPrefix;
+*/
+
+NS_LOG_COMPONENT_DEFINE("OSPFInterAreaPrefixLSABody");
+
+uint32_t OSPFInterAreaPrefixLSABody::GetSerializedSize () const {
+    return 8 + ((m_prefixLength + 31) / 32) * 4;
+} 
+void OSPFInterAreaPrefixLSABody::Print (std::ostream &os) const {
+    os << "(Inter area prefix LSA: [";
+    os << "metric: " << m_metric << ", ";
+    os << "prefixOption: " << (uint16_t)m_prefixOptions << ", ";
+    os << "prefixLength: " << (uint16_t)m_prefixLength << ", ";
+    os << "prefix: " << m_addressPrefix << "])";
+} 
+void OSPFInterAreaPrefixLSABody::Serialize (Buffer::Iterator &i) const {
+/*
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |      0        |                  Metric                       |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      | PrefixLength  | PrefixOptions |               0               |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                        Address Prefix                         |
+      |                             ...                               |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*/
+    i.WriteHtonU32(m_metric & 0x00ffffff);
+    i.WriteU8(m_prefixLength);
+    i.WriteU8(m_prefixOptions);
+    i.WriteHtonU16(0);
+
+    uint8_t buf[16];
+    m_addressPrefix.GetBytes(buf);
+    uint8_t bufSize = (m_prefixLength + 31) / 32 * 4;
+    for (int j = 0, l = bufSize; j < l; ++j) {
+        i.WriteU8(buf[j]);
+    }
+}
+uint32_t OSPFInterAreaPrefixLSABody::Deserialize (Buffer::Iterator &i, uint32_t remainBytes) {
+    m_metric = i.ReadNtohU32() & 0x00ffffff;
+    m_prefixLength = i.ReadU8();
+    m_prefixOptions = i.ReadU8();
+    i.ReadNtohU16();
+
+    uint8_t buf[16];
+    memset(buf, 0x00, 16);
+    uint8_t bufSize = (m_prefixLength + 31) / 32 * 4;
+    for (int j = 0, l = bufSize; j < l; ++j) {
+        buf[j] = i.ReadU8();
+    }
+    m_addressPrefix.Set(buf);
+    return OSPFInterAreaPrefixLSABody::GetSerializedSize();
+}
+
+} // namespace ns3
+} // namespace ns3
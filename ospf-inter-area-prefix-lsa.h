@@ -0,0 +1,78 @@
+#ifndef OSPF_INTER_AREA_PREFIX_LSA_H
+#define OSPF_INTER_AREA_PREFIX_LSA_H
+
+/*
+       0                   1                   2                   3
+       0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |            LS Age             |0|0|1|          3              |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                       Link State ID                           |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                    Advertising Router                         |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                    LS Sequence Number                         |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |        LS Checksum            |            Length             |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |      0        |                  Metric                       |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      | PrefixLength  | PrefixOptions |               0               |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                        Address Prefix                         |
+      |                             ...                               |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+                      Inter-Area-Prefix-LSA Format
+
+    ABRが接続エリアの外の宛先1つにつき1つ生成する
+    Link State IDは生成するABRの中で一意であればよい
+*/
+
+#include "ospf-lsa-header.h"
+#include "ns3/ipv6-address.h"
+
+using namespace ns3;
+
+namespace ns3 {
+namespace ospf {
+
+class OSPFInterAreaPrefixLSABody {
+private:
+    uint32_t m_metric; // 下位24ビット
+    uint8_t m_prefixLength;
+    uint8_t m_prefixOptions;
+    Ipv6Address m_addressPrefix;
+
+public:
+    OSPFInterAreaPrefixLSABody () : m_metric(0), m_prefixLength(0), m_prefixOptions(0) {};
+    ~OSPFInterAreaPrefixLSABody () {};
+
+    uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes);
+    uint32_t GetSerializedSize () const; 
+    void Print (std::ostream &os) const; 
+    void Serialize (Buffer::Iterator &i) const;
+
+    uint32_t GetMetric() const {return m_metric;}
+    void SetMetric(uint32_t metric) {m_metric = metric & 0x00ffffff;}
+    uint8_t GetPrefixLength() const {return m_prefixLength;}
+    uint8_t GetPrefixOptions() const {return m_prefixOptions;}
+    void SetPrefixOptions(uint8_t options) {m_prefixOptions = options;}
+    const Ipv6Address& GetPrefixAddress() const {return m_addressPrefix;}
+    void SetPrefix(Ipv6Address addr, uint8_t prefixLength) {
+        m_prefixLength = prefixLength;
+        m_addressPrefix = addr.CombinePrefix(Ipv6Prefix(prefixLength));
+    }
+    bool operator== (const OSPFInterAreaPrefixLSABody &other) const {
+        return (
+            m_metric == other.m_metric &&
+            m_prefixLength == other.m_prefixLength &&
+            m_prefixOptions == other.m_prefixOptions &&
+            m_addressPrefix == other.m_addressPrefix
+        );
+    }
+};
+
+}
+}
+#endif
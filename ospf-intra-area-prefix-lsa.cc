@@ -16,18 +16,6 @@ std::vector<Ipv6Address> m_addressPrefixes;
 */
 
 NS_LOG_COMPONENT_DEFINE("OSPFIntraAreaPrefixLSABody");
-NS_OBJECT_ENSURE_REGISTERED(OSPFIntraAreaPrefixLSABody);
-
-TypeId OSPFIntraAreaPrefixLSABody::GetTypeId () {
-    static TypeId tid = TypeId("ns3::ospf::OSPFIntraAreaPrefixLSABody")
-        .SetParent<OSPFLSABody>()
-        .AddConstructor<OSPFIntraAreaPrefixLSABody>();
-    return tid;
-}
-
-TypeId OSPFIntraAreaPrefixLSABody::GetInstanceId () const {
-    return GetTypeId();
-}
 
 uint32_t OSPFIntraAreaPrefixLSABody::GetSerializedSize () const {
     uint32_t size = 12;
@@ -2,7 +2,7 @@
 #define OSPF_INTRA_AREA_PREFIX_LSA_H
 
 #include <vector>
-#include "ospf-lsa-body.h"
+#include "ospf-lsa-header.h"
 #include "ns3/ipv6-address.h"
 
 using namespace ns3;
@@ -10,7 +10,7 @@ using namespace ns3;
 namespace ns3 {
 namespace ospf {
 
-class OSPFIntraAreaPrefixLSABody : public OSPFLSABody {
+class OSPFIntraAreaPrefixLSABody {
 private:
     // uint16_t m_prefixes;
     uint16_t m_refType;
@@ -22,42 +22,39 @@ private:
     std::vector<Ipv6Address> m_addressPrefixes;
 
 public:
-    OSPFIntraAreaPrefixLSABody () : OSPFLSABody () {};
+    OSPFIntraAreaPrefixLSABody () : m_refType(0), m_refId(0), m_refAdvRtr(0) {};
     ~OSPFIntraAreaPrefixLSABody () {};
 
-    static TypeId GetTypeId();
+    uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes);
+    uint32_t GetSerializedSize () const; 
+    void Print (std::ostream &os) const; 
+    void Serialize (Buffer::Iterator &i) const;
 
-    virtual TypeId GetInstanceId () const;
-    virtual uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes);
-    virtual uint32_t GetSerializedSize () const; 
-    virtual void Print (std::ostream &os) const; 
-    virtual void Serialize (Buffer::Iterator &i) const;
-
-    virtual uint16_t CountPrefixes() const {return m_addressPrefixes.size();}
-    virtual uint16_t GetReferenceType() const {return m_refType;}
-    virtual void SetReferenceType(uint16_t type) {m_refType = type;}
-    virtual uint32_t GetReferenceLinkStateId () const {return m_refId;}
-    virtual void SetReferenceLinkStateId (uint32_t id) {m_refId = id;}
-    virtual uint32_t GetReferenceAdvertisedRouter () const {return m_refAdvRtr;}
-    virtual void SetReferenceAdvertisedRouter (uint32_t advRtr) {m_refAdvRtr = advRtr;}
-    virtual uint8_t GetPrefixOption(uint32_t idx) const {return m_prefixOptions[idx];}
-    virtual uint8_t GetPrefixLength(uint32_t idx) const {return m_prefixLengthes[idx];}
-    virtual uint16_t GetPrefixMetric(uint32_t idx) const {return m_metrics[idx];}
-    virtual const Ipv6Address& GetPrefixAddress(uint32_t idx) const {return m_addressPrefixes[idx];}
-    virtual void ClearPrefixes() {
+    uint16_t CountPrefixes() const {return m_addressPrefixes.size();}
+    uint16_t GetReferenceType() const {return m_refType;}
+    void SetReferenceType(uint16_t type) {m_refType = type;}
+    uint32_t GetReferenceLinkStateId () const {return m_refId;}
+    void SetReferenceLinkStateId (uint32_t id) {m_refId = id;}
+    uint32_t GetReferenceAdvertisedRouter () const {return m_refAdvRtr;}
+    void SetReferenceAdvertisedRouter (uint32_t advRtr) {m_refAdvRtr = advRtr;}
+    uint8_t GetPrefixOption(uint32_t idx) const {return m_prefixOptions[idx];}
+    uint8_t GetPrefixLength(uint32_t idx) const {return m_prefixLengthes[idx];}
+    uint16_t GetPrefixMetric(uint32_t idx) const {return m_metrics[idx];}
+    const Ipv6Address& GetPrefixAddress(uint32_t idx) const {return m_addressPrefixes[idx];}
+    void ClearPrefixes() {
         m_prefixLengthes.clear();
         m_addressPrefixes.clear();
         m_prefixOptions.clear();
         m_metrics.clear();
     }
-    virtual void AddPrefix(Ipv6Address addr, uint8_t prefixLength, uint16_t metric, uint32_t option = 0) {
+    void AddPrefix(Ipv6Address addr, uint8_t prefixLength, uint16_t metric, uint32_t option = 0) {
         m_prefixLengthes.push_back(prefixLength);
         Ipv6Prefix prefix(prefixLength);
         m_addressPrefixes.push_back(addr.CombinePrefix(prefix));
         m_prefixOptions.push_back(option);
         m_metrics.push_back(metric);
     }
-    virtual bool operator== (const OSPFIntraAreaPrefixLSABody &other) const {
+    bool operator== (const OSPFIntraAreaPrefixLSABody &other) const {
         return (
             m_refType == other.m_refType &&
             m_refId == other.m_refId &&
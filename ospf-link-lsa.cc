@@ -13,18 +13,6 @@ vector<Ipv6Prefix> m_addressPrefixes;
 */
 
 NS_LOG_COMPONENT_DEFINE("OSPFLinkLSABody");
-NS_OBJECT_ENSURE_REGISTERED(OSPFLinkLSABody);
-
-TypeId OSPFLinkLSABody::GetTypeId () {
-    static TypeId tid = TypeId("ns3::ospf::OSPFLinkLSABody")
-        .SetParent<OSPFLSABody>()
-        .AddConstructor<OSPFLinkLSABody>();
-    return tid;
-}
-
-TypeId OSPFLinkLSABody::GetInstanceId () const {
-    return GetTypeId();
-}
 
 uint32_t OSPFLinkLSABody::GetSerializedSize () const {
     uint32_t size = 24;
@@ -45,7 +45,7 @@
 */
 
 #include <vector>
-#include "ospf-lsa-body.h"
+#include "ospf-lsa-header.h"
 #include "ns3/ipv6-address.h"
 
 using namespace ns3;
@@ -53,7 +53,7 @@ using namespace ns3;
 namespace ns3 {
 namespace ospf {
 
-class OSPFLinkLSABody : public OSPFLSABody {
+class OSPFLinkLSABody {
 private:
     uint8_t m_rtrPriority;
     uint32_t m_options;
@@ -63,41 +63,38 @@ private:
     std::vector<Ipv6Address> m_addressPrefixes;
 
 public:
-    OSPFLinkLSABody () : OSPFLSABody () {};
+    OSPFLinkLSABody () : m_rtrPriority(0), m_options(0) {};
     ~OSPFLinkLSABody () {};
 
-    static TypeId GetTypeId();
+    uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes);
+    uint32_t GetSerializedSize () const; 
+    void Print (std::ostream &os) const; 
+    void Serialize (Buffer::Iterator &i) const;
 
-    virtual TypeId GetInstanceId () const;
-    virtual uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes);
-    virtual uint32_t GetSerializedSize () const; 
-    virtual void Print (std::ostream &os) const; 
-    virtual void Serialize (Buffer::Iterator &i) const;
-
-    virtual uint8_t GetRtrPriority() const {return m_rtrPriority;}
-    virtual void SetRtrPriority(uint8_t prio) {m_rtrPriority = prio;}
-    virtual uint32_t GetOptions() const {return m_options;}
-    virtual void SetOptions(uint32_t opt) {m_options = opt;}
-    virtual const Ipv6Address& GetLinkLocalAddress() const {return m_addr;}
-    virtual void SetLinkLocalAddress(Ipv6Address &addr) {m_addr = addr;}
-    virtual uint8_t GetPrefixOption(uint32_t idx) const {return m_prefixOptions[idx];}
-    virtual uint8_t GetPrefixLength(uint32_t idx) const {return m_prefixLengthes[idx];}
-    virtual const Ipv6Address& GetPrefixAddress(uint32_t idx) const {return m_addressPrefixes[idx];}
-    virtual void ClearPrefixes() {
+    uint8_t GetRtrPriority() const {return m_rtrPriority;}
+    void SetRtrPriority(uint8_t prio) {m_rtrPriority = prio;}
+    uint32_t GetOptions() const {return m_options;}
+    void SetOptions(uint32_t opt) {m_options = opt;}
+    const Ipv6Address& GetLinkLocalAddress() const {return m_addr;}
+    void SetLinkLocalAddress(Ipv6Address &addr) {m_addr = addr;}
+    uint8_t GetPrefixOption(uint32_t idx) const {return m_prefixOptions[idx];}
+    uint8_t GetPrefixLength(uint32_t idx) const {return m_prefixLengthes[idx];}
+    const Ipv6Address& GetPrefixAddress(uint32_t idx) const {return m_addressPrefixes[idx];}
+    void ClearPrefixes() {
         m_prefixLengthes.clear();
         m_addressPrefixes.clear();
         m_prefixOptions.clear();
     }
-    virtual void AddPrefix(Ipv6Address addr, uint8_t prefixLength, uint32_t option = 0) {
+    void AddPrefix(Ipv6Address addr, uint8_t prefixLength, uint32_t option = 0) {
         m_prefixLengthes.push_back(prefixLength);
         Ipv6Prefix prefix(prefixLength);
         m_addressPrefixes.push_back(addr.CombinePrefix(prefix));
         m_prefixOptions.push_back(option);
     }
-    virtual uint32_t CountPrefixes() const {
+    uint32_t CountPrefixes() const {
         return m_addressPrefixes.size();
     }
-    virtual bool operator== (const OSPFLinkLSABody &other) const {
+    bool operator== (const OSPFLinkLSABody &other) const {
         return (
             m_rtrPriority == other.m_rtrPriority &&
             m_options == other.m_options &&
@@ -2,23 +2,96 @@
 #define OSPF_LSDB_H
 
 #include "ns3/nstime.h"
+#include "ns3/hash.h"
+#include "ns3/buffer.h"
 #include "ospf-constants.h"
 #include "ospf-lsa.h"
 #include "ospf-lsa-identifier.h"
 #include <set>
 #include <map>
 #include <algorithm>
+#include <vector>
 
 namespace ns3 {
 namespace ospf {
 
+// LSDBダイジェストのバケット数
+// LSAは(LS Type, Link State ID, Advertising Router)でバケットに振り分けられ、
+// バケットごとにインスタンスのハッシュのXORを持つ
+#define OSPF_LSDB_DIGEST_BUCKETS 16
+
 class OSPFLSDB {
     std::map<OSPFLinkStateIdentifier, Ptr<OSPFLSA>> m_db;
     std::map<OSPFLinkStateIdentifier, Time> m_addedTime;
     std::map<OSPFLinkStateIdentifier, uint16_t> m_addedAge;
+    std::map<OSPFLinkStateIdentifier, uint32_t> m_digestContribution;
+    std::vector<uint32_t> m_bucketDigests;
+    // 格納中のインスタンスの内容のハッシュとシーケンス番号、直前のインスタンスから内容が変わったか
+    std::map<OSPFLinkStateIdentifier, uint32_t> m_contentHash;
+    std::map<OSPFLinkStateIdentifier, int32_t> m_contentSeqNum;
+    std::map<OSPFLinkStateIdentifier, bool> m_contentChanged;
+
+    // フラッシュはシーケンス番号を進めずにMaxAgeにするので、MaxAgeかどうかも含める
+    // チェックサムは常に0なので、中身の違いは本文のハッシュで見る
+    static uint32_t HashContent (const OSPFLSA& lsa) {
+        Buffer body;
+        body.AddAtStart(lsa.GetBody().GetSerializedSize());
+        Buffer::Iterator itr = body.Begin();
+        lsa.GetBody().Serialize(itr);
+        uint32_t fields[2] = {
+            lsa.GetHeader().GetAge() >= g_maxAge, Hash32((const char*)body.PeekData(), body.GetSize())
+        };
+        return Hash32((const char*)fields, sizeof(fields));
+    }
+
+    static uint32_t HashInstance (const OSPFLSA& lsa) {
+        const OSPFLSAHeader& header = lsa.GetHeader();
+        uint32_t fields[5] = {
+            header.GetType(), header.GetId(), header.GetAdvertisingRouter(), (uint32_t)header.GetSequenceNumber(),
+            HashContent(lsa)
+        };
+        return Hash32((const char*)fields, sizeof(fields));
+    }
+
+    // 同じインスタンスの登録し直し(UpdateLSACachesの後のAddなど)では、変化の有無を上書きしない
+    void UpdateContent (const OSPFLinkStateIdentifier& id, const Ptr<OSPFLSA>& lsa) {
+        if (!lsa) {
+            m_contentHash.erase(id);
+            m_contentSeqNum.erase(id);
+            m_contentChanged.erase(id);
+            return;
+        }
+        uint32_t hash = HashContent(*lsa);
+        int32_t seqNum = lsa->GetHeader().GetSequenceNumber();
+        auto it = m_contentHash.find(id);
+        if (it == m_contentHash.end()) {
+            m_contentChanged[id] = true;
+        } else if (m_contentSeqNum[id] == seqNum) {
+            m_contentChanged[id] = m_contentChanged[id] || it->second != hash;
+        } else {
+            m_contentChanged[id] = it->second != hash;
+        }
+        m_contentHash[id] = hash;
+        m_contentSeqNum[id] = seqNum;
+    }
+
+    // インスタンスの寄与を差し替える。Link-local scopeのLSAはリンクごとに異なるので含めない
+    void UpdateDigestContribution (const OSPFLinkStateIdentifier& id, const Ptr<OSPFLSA>& lsa) {
+        UpdateContent(id, lsa);
+        auto it = m_digestContribution.find(id);
+        if (it != m_digestContribution.end()) {
+            m_bucketDigests[GetDigestBucket(id)] ^= it->second;
+            m_digestContribution.erase(it);
+        }
+        if (lsa && !lsa->GetHeader().IsLinkLocalScope()) {
+            uint32_t hash = HashInstance(*lsa);
+            m_bucketDigests[GetDigestBucket(id)] ^= hash;
+            m_digestContribution[id] = hash;
+        }
+    }
 
 public:
-    OSPFLSDB() {}
+    OSPFLSDB() : m_bucketDigests(OSPF_LSDB_DIGEST_BUCKETS, 0) {}
     ~OSPFLSDB() {
         for (auto it = m_db.begin(); it != m_db.end(); it = m_db.erase(it)) {
         }
@@ -36,7 +109,8 @@ public:
         OSPFLinkStateIdentifier id = lsa->GetIdentifier();
         m_db[id] = lsa;
         m_addedTime[id] = ns3::Now();
-        m_addedAge[id] = lsa->GetHeader()->GetAge();
+        m_addedAge[id] = lsa->GetHeader().GetAge();
+        UpdateDigestContribution(id, lsa);
     }
 
     bool DetectMaxAge(OSPFLinkStateIdentifier id) {
@@ -52,12 +126,45 @@ public:
     }
 
     Ptr<OSPFLSA> Get(const OSPFLinkStateIdentifier& id) {
-        m_db[id]->GetHeader()->SetAge(std::min(CalcAge(id), g_maxAge));
+        m_db[id]->GetHeader().SetAge(std::min(CalcAge(id), g_maxAge));
         return m_db[id];
     }
 
     void Remove(OSPFLinkStateIdentifier id) {
         m_db.erase(id);
+        UpdateDigestContribution(id, Ptr<OSPFLSA>());
+    }
+
+    // 格納済みのLSAをその場で更新した(シーケンス番号を進めた)後に呼ぶ
+    void UpdateDigest(const OSPFLinkStateIdentifier& id) {
+        auto it = m_db.find(id);
+        if (it != m_db.end()) {
+            UpdateDigestContribution(id, it->second);
+        }
+    }
+
+    // RFC 3623 3.1 LSRefreshのように本文が同じまま番号だけ進んだインスタンスは変化とみなさない
+    // 格納中のインスタンスそのものなら直前のインスタンスと比べ、まだ格納していない受信インスタンスなら格納中のものと比べる
+    bool IsChangedInstance(const Ptr<OSPFLSA>& lsa) const {
+        OSPFLinkStateIdentifier id = lsa->GetIdentifier();
+        auto stored = m_db.find(id);
+        auto hash = m_contentHash.find(id);
+        if (stored == m_db.end() || hash == m_contentHash.end()) {
+            return true;
+        }
+        if (stored->second == lsa) {
+            return m_contentChanged.find(id)->second;
+        }
+        return hash->second != HashContent(*lsa);
+    }
+
+    static uint32_t GetDigestBucket(const OSPFLinkStateIdentifier& id) {
+        uint32_t fields[3] = {id.m_type, id.m_id, id.m_advRtr};
+        return Hash32((const char*)fields, sizeof(fields)) % OSPF_LSDB_DIGEST_BUCKETS;
+    }
+
+    const std::vector<uint32_t>& GetBucketDigests() const {
+        return m_bucketDigests;
     }
 
     bool IsElapsedMinLsArrival(OSPFLinkStateIdentifier id) {
@@ -72,9 +179,9 @@ public:
         return ret;
     }
 
-    void GetSummary (std::vector<Ptr<OSPFLSAHeader> >& summary, std::vector<Ptr<OSPFLSA> >& rxmt) {
+    void GetSummary (std::vector<OSPFLSAHeader>& summary, std::vector<Ptr<OSPFLSA> >& rxmt) {
         for (auto& kv : m_db) {
-            if (kv.second->GetHeader()->IsASScope()) continue;
+            if (kv.second->GetHeader().IsASScope()) continue;
             summary.push_back(kv.second->GetHeader());
             if (DetectMaxAge(kv.first)) {
                 rxmt.push_back(kv.second);
@@ -13,16 +13,32 @@ void TestForOSPFLinkStateUpdate () {
     srcHdr.SetRouterId(123);
     srcHdr.SetInstanceId(5);
     
-    Ptr<ns3::ospf::OSPFLSA> h1, h2, h3;
+    Ptr<ns3::ospf::OSPFLSA> h1, h2, h3, h4, h5, h6;
     h1 = Create<ns3::ospf::OSPFLSA>();
     h2 = Create<ns3::ospf::OSPFLSA>();
     h3 = Create<ns3::ospf::OSPFLSA>();
+    h4 = Create<ns3::ospf::OSPFLSA>();
+    h5 = Create<ns3::ospf::OSPFLSA>();
+    h6 = Create<ns3::ospf::OSPFLSA>();
     h1->Initialize(OSPF_LSA_TYPE_LINK);
     h2->Initialize(OSPF_LSA_TYPE_LINK);
     h3->Initialize(OSPF_LSA_TYPE_ROUTER);
+    h4->Initialize(OSPF_LSA_TYPE_NETWORK);
+    h4->GetBody<ns3::ospf::OSPFNetworkLSABody>()->SetOptions(0x13);
+    h4->GetBody<ns3::ospf::OSPFNetworkLSABody>()->AddAttachedRouter(1);
+    h4->GetBody<ns3::ospf::OSPFNetworkLSABody>()->AddAttachedRouter(2);
+    h5->Initialize(OSPF_LSA_TYPE_INTER_AREA_PREFIX);
+    h5->GetBody<ns3::ospf::OSPFInterAreaPrefixLSABody>()->SetMetric(20);
+    h5->GetBody<ns3::ospf::OSPFInterAreaPrefixLSABody>()->SetPrefix(Ipv6Address("2001:db8:1::"), 48);
+    h6->Initialize(OSPF_LSA_TYPE_GRACE);
+    h6->GetBody<ns3::ospf::OSPFGraceLSABody>()->SetGracePeriod(120);
+    h6->GetBody<ns3::ospf::OSPFGraceLSABody>()->SetRestartReason(OSPF_GRACE_REASON_SOFTWARE_RESTART);
     srcHdr.AddLSA(h1);
     srcHdr.AddLSA(h2);
     srcHdr.AddLSA(h3);
+    srcHdr.AddLSA(h4);
+    srcHdr.AddLSA(h5);
+    srcHdr.AddLSA(h6);
 
 
     Ptr<Packet> packet = Create<Packet>();
@@ -0,0 +1,25 @@
+#include "ospf-liveness-probe.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+#include <iostream>
+using namespace std;
+
+void TestForOSPFLivenessProbe () {
+
+    cout << " - TestForOSPFLivenessProbe - " << endl;
+    ns3::ospf::OSPFLivenessProbe srcHdr, dstHdr;
+    srcHdr.SetAreaId(234);
+    srcHdr.SetRouterId(123);
+    srcHdr.SetInstanceId(5);
+    srcHdr.SetInterfaceId(3);
+
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(srcHdr);
+
+    packet->RemoveHeader(dstHdr);
+
+    NS_ASSERT(srcHdr == dstHdr);
+
+    return;
+}
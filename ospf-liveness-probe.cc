@@ -0,0 +1,45 @@
+#include "ospf-liveness-probe.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace ospf {
+
+NS_LOG_COMPONENT_DEFINE("OSPFLivenessProbe");
+NS_OBJECT_ENSURE_REGISTERED(OSPFLivenessProbe);
+
+TypeId OSPFLivenessProbe::GetTypeId () {
+    static TypeId tid = TypeId("ns3::ospf::OSPFLivenessProbe")
+        .SetParent<OSPFHeader>()
+        .AddConstructor<OSPFLivenessProbe>();
+    return tid;
+}
+
+TypeId OSPFLivenessProbe::GetInstanceTypeId () const {
+    return GetTypeId();
+}
+
+uint32_t OSPFLivenessProbe::GetSerializedSize () const {
+    return OSPFHeader::GetSerializedSize() + 4;
+} 
+void OSPFLivenessProbe::Print (std::ostream &os) const {
+    os << "(";
+    OSPFHeader::Print(os);
+    os << " Liveness Probe - ";
+    os << "interfaceId: " << m_interfaceId << ")";
+} 
+void OSPFLivenessProbe::Serialize (Buffer::Iterator start) const {
+    OSPFHeader::Serialize(start);
+    start.Next(OSPFHeader::GetSerializedSize());
+
+    start.WriteHtonU32(m_interfaceId);
+}
+uint32_t OSPFLivenessProbe::Deserialize (Buffer::Iterator start) {
+    start.Next(OSPFHeader::Deserialize(start));
+
+    m_interfaceId = start.ReadNtohU32();
+
+    return OSPFLivenessProbe::GetSerializedSize();
+}
+
+} // namespace ns3
+} // namespace ns3
@@ -0,0 +1,54 @@
+#ifndef OSPF_LIVENESS_PROBE_H
+#define OSPF_LIVENESS_PROBE_H
+
+#include "ospf-header.h"
+
+using namespace ns3;
+
+/*
+    高速な生存確認(BFD相当)のためのプローブ
+    OSPFv3の仕様にはないパケットタイプで、シミュレーション内でのみ使う
+
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                       Interface ID                            |
+      +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+*/
+
+namespace ns3 {
+namespace ospf {
+
+class OSPFLivenessProbe : public OSPFHeader {
+private:
+    uint32_t m_interfaceId;
+
+public:
+    OSPFLivenessProbe () : OSPFHeader (), m_interfaceId(0) {
+        SetType(OSPF_TYPE_LIVENESS_PROBE);
+    };
+    ~OSPFLivenessProbe () {};
+
+    static TypeId GetTypeId();
+
+    virtual TypeId GetInstanceTypeId (void) const;
+    virtual uint32_t Deserialize (Buffer::Iterator start); 
+    virtual uint32_t GetSerializedSize () const; 
+    virtual void Print (std::ostream &os) const; 
+    virtual void Serialize (Buffer::Iterator start) const;
+
+    void SetInterfaceId(uint32_t interfaceId) {m_interfaceId = interfaceId;}
+    uint32_t GetInterfaceId() const {return m_interfaceId;}
+
+    bool operator== (const OSPFLivenessProbe &other) const {
+        OSPFHeader sup = *this;
+        OSPFHeader oth = other;
+
+        return (
+            sup == oth &&
+            m_interfaceId == other.m_interfaceId
+        );
+    }
+};
+
+}
+}
+#endif
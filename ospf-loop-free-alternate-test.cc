@@ -0,0 +1,53 @@
+#include "ipv6-ospf-routing.h"
+#include "ospf-routing-table.h"
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include <iostream>
+using namespace std;
+
+void TestForOSPFLoopFreeAlternate () {
+
+    cout << " - TestForOSPFLoopFreeAlternate - " << endl;
+    typedef ns3::ospf::Ipv6OspfRouting Routing;
+
+    // S -(10)- D が主経路、N1は別の経路でDに届き、N2はSを経由してDに届く
+    //   N1: D(N1, D) = 5,  D(N1, S) = 10 -> 5 < 10 + 10
+    //   N2: D(N2, D) = 13, D(N2, S) = 3  -> 13 < 3 + 10 を満たさない(Sに戻ってくる)
+    NS_ABORT_MSG_UNLESS(Routing::IsLoopFree(5, 10, 10), "loop-free neighbor is rejected");
+    NS_ABORT_MSG_UNLESS(!Routing::IsLoopFree(13, 3, 10), "neighbor looping back through S is accepted");
+    // 等しい場合もループしうるので選ばない
+    NS_ABORT_MSG_UNLESS(!Routing::IsLoopFree(20, 10, 10), "neighbor at equal distance is accepted");
+    // 届かない隣接ルータは選ばない。大きなコストでも桁あふれしない
+    NS_ABORT_MSG_UNLESS(!Routing::IsLoopFree(UINT32_MAX, 10, 10), "neighbor without a path to D is accepted");
+    NS_ABORT_MSG_UNLESS(!Routing::IsLoopFree(5, UINT32_MAX, 10), "neighbor without a path to S is accepted");
+    NS_ABORT_MSG_UNLESS(Routing::IsLoopFree(UINT32_MAX - 1, UINT32_MAX - 1, 10), "large costs overflow");
+
+    // 落ちたインターフェイスを使う経路だけが代替経路に置き換わる
+    ns3::ospf::RoutingTable table;
+    Ipv6Address dst1("2001:db8:1::"), dst2("2001:db8:2::"), dst3("2001:db8:3::");
+    Ipv6RoutingTableEntry primary1 = Ipv6RoutingTableEntry::CreateNetworkRouteTo(dst1, Ipv6Prefix(64), Ipv6Address("fe80::1"), 1);
+    Ipv6RoutingTableEntry backup1 = Ipv6RoutingTableEntry::CreateNetworkRouteTo(dst1, Ipv6Prefix(64), Ipv6Address("fe80::2"), 2);
+    Ipv6RoutingTableEntry primary2 = Ipv6RoutingTableEntry::CreateNetworkRouteTo(dst2, Ipv6Prefix(64), Ipv6Address("fe80::3"), 3);
+    Ipv6RoutingTableEntry backup2 = Ipv6RoutingTableEntry::CreateNetworkRouteTo(dst2, Ipv6Prefix(64), Ipv6Address("fe80::2"), 2);
+    Ipv6RoutingTableEntry primary3 = Ipv6RoutingTableEntry::CreateNetworkRouteTo(dst3, Ipv6Prefix(64), Ipv6Address("fe80::1"), 1);
+    Ipv6RoutingTableEntry backup3 = Ipv6RoutingTableEntry::CreateNetworkRouteTo(dst3, Ipv6Prefix(64), Ipv6Address("fe80::4"), 1);
+    table.AddRoute(primary1);
+    table.AddBackupRoute(backup1);
+    table.AddRoute(primary2);
+    table.AddBackupRoute(backup2);
+    table.AddRoute(primary3);
+    table.AddBackupRoute(backup3);
+
+    NS_ASSERT(table.ActivateBackupRoutes(1) == 1);
+    Ipv6RoutingTableEntry entry;
+    Ipv6Address addr1("2001:db8:1::1"), addr2("2001:db8:2::1"), addr3("2001:db8:3::1");
+    NS_ABORT_MSG_UNLESS(table.LookupRoute(addr1, entry) && entry.GetInterface() == 2, "backup route is not activated");
+    NS_ABORT_MSG_UNLESS(table.LookupRoute(addr2, entry) && entry.GetInterface() == 3, "unaffected route is replaced");
+    // 同じインターフェイスへの代替経路は使わない
+    NS_ABORT_MSG_UNLESS(table.LookupRoute(addr3, entry) && entry.GetInterface() == 1, "backup on the failed interface is activated");
+    // 使った代替経路は残らない
+    NS_ASSERT(table.ActivateBackupRoutes(1) == 0);
+
+    return;
+}
@@ -2,31 +2,168 @@
 #define OSPF_LSA_BODY_H
 
 #include "ospf-lsa-header.h"
+#include "ospf-router-lsa.h"
+#include "ospf-network-lsa.h"
+#include "ospf-link-lsa.h"
+#include "ospf-inter-area-prefix-lsa.h"
+#include "ospf-intra-area-prefix-lsa.h"
+#include "ospf-grace-lsa.h"
 #include <iostream>
+#include <new>
+
+/*
+    LSAボディの閉じたタグ付き共用体
+
+    取りうるボディ型はLS Typeで決まる6種類だけなので、仮想関数とDynamicCastをやめて
+    LS Typeをタグとしてswitchで振り分ける。型付きアクセスはタグの比較だけで済み、
+    SPFや経路表の構築ループでRTTIを使わない。
+*/
 
 using namespace ns3;
 
 namespace ns3 {
 namespace ospf {
 
-class OSPFLSABody : public Object {
+class OSPFLSABody {
+private:
+    uint16_t m_type; // 対応するLS Type、ボディがなければ0
+    union {
+        OSPFRouterLSABody m_router;
+        OSPFNetworkLSABody m_network;
+        OSPFLinkLSABody m_link;
+        OSPFInterAreaPrefixLSABody m_interAreaPrefix;
+        OSPFIntraAreaPrefixLSABody m_intraAreaPrefix;
+        OSPFGraceLSABody m_grace;
+    };
+
+    OSPFRouterLSABody* Member (OSPFRouterLSABody*) {return m_type == OSPF_LSA_TYPE_ROUTER ? &m_router : nullptr;}
+    OSPFNetworkLSABody* Member (OSPFNetworkLSABody*) {return m_type == OSPF_LSA_TYPE_NETWORK ? &m_network : nullptr;}
+    OSPFLinkLSABody* Member (OSPFLinkLSABody*) {return m_type == OSPF_LSA_TYPE_LINK ? &m_link : nullptr;}
+    OSPFInterAreaPrefixLSABody* Member (OSPFInterAreaPrefixLSABody*) {return m_type == OSPF_LSA_TYPE_INTER_AREA_PREFIX ? &m_interAreaPrefix : nullptr;}
+    OSPFIntraAreaPrefixLSABody* Member (OSPFIntraAreaPrefixLSABody*) {return m_type == OSPF_LSA_TYPE_INTRA_AREA_PREFIX ? &m_intraAreaPrefix : nullptr;}
+    OSPFGraceLSABody* Member (OSPFGraceLSABody*) {return m_type == OSPF_LSA_TYPE_GRACE ? &m_grace : nullptr;}
 
-public:
-    OSPFLSABody () {};
-    ~OSPFLSABody () {};
+    void Destroy () {
+        switch (m_type) {
+            case OSPF_LSA_TYPE_ROUTER: m_router.~OSPFRouterLSABody(); break;
+            case OSPF_LSA_TYPE_NETWORK: m_network.~OSPFNetworkLSABody(); break;
+            case OSPF_LSA_TYPE_LINK: m_link.~OSPFLinkLSABody(); break;
+            case OSPF_LSA_TYPE_INTER_AREA_PREFIX: m_interAreaPrefix.~OSPFInterAreaPrefixLSABody(); break;
+            case OSPF_LSA_TYPE_INTRA_AREA_PREFIX: m_intraAreaPrefix.~OSPFIntraAreaPrefixLSABody(); break;
+            case OSPF_LSA_TYPE_GRACE: m_grace.~OSPFGraceLSABody(); break;
+        }
+        m_type = 0;
+    }
 
-    static TypeId GetTypeId() {
-        static TypeId tid = TypeId("ns3::ospf::OSPFLSABody")
-            .AddConstructor<OSPFLSABody>();
-        return tid;
+    void CopyFrom (const OSPFLSABody& other) {
+        switch (other.m_type) {
+            case OSPF_LSA_TYPE_ROUTER: new (&m_router) OSPFRouterLSABody(other.m_router); break;
+            case OSPF_LSA_TYPE_NETWORK: new (&m_network) OSPFNetworkLSABody(other.m_network); break;
+            case OSPF_LSA_TYPE_LINK: new (&m_link) OSPFLinkLSABody(other.m_link); break;
+            case OSPF_LSA_TYPE_INTER_AREA_PREFIX: new (&m_interAreaPrefix) OSPFInterAreaPrefixLSABody(other.m_interAreaPrefix); break;
+            case OSPF_LSA_TYPE_INTRA_AREA_PREFIX: new (&m_intraAreaPrefix) OSPFIntraAreaPrefixLSABody(other.m_intraAreaPrefix); break;
+            case OSPF_LSA_TYPE_GRACE: new (&m_grace) OSPFGraceLSABody(other.m_grace); break;
+        }
+        m_type = other.m_type;
+    }
+
+public:
+    OSPFLSABody () : m_type(0) {};
+    OSPFLSABody (const OSPFLSABody& other) : m_type(0) {
+        CopyFrom(other);
+    }
+    ~OSPFLSABody () {
+        Destroy();
     };
 
-    virtual TypeId GetInstanceId (void) const {return GetTypeId();};
-    virtual uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes) {return 0;};
-    virtual uint32_t GetSerializedSize () const {return 0;}; 
-    virtual void Print (std::ostream &os) const {}; 
-    virtual void Serialize (Buffer::Iterator &i) const {};
+    OSPFLSABody& operator= (const OSPFLSABody& other) {
+        if (this != &other) {
+            Destroy();
+            CopyFrom(other);
+        }
+        return *this;
+    }
+
+    // LS Typeに対応するボディを空の状態で作り直す
+    // 知らないLS Typeならボディなしになる
+    void Emplace (uint16_t type) {
+        Destroy();
+        switch (type) {
+            case OSPF_LSA_TYPE_ROUTER: new (&m_router) OSPFRouterLSABody(); break;
+            case OSPF_LSA_TYPE_NETWORK: new (&m_network) OSPFNetworkLSABody(); break;
+            case OSPF_LSA_TYPE_LINK: new (&m_link) OSPFLinkLSABody(); break;
+            case OSPF_LSA_TYPE_INTER_AREA_PREFIX: new (&m_interAreaPrefix) OSPFInterAreaPrefixLSABody(); break;
+            case OSPF_LSA_TYPE_INTRA_AREA_PREFIX: new (&m_intraAreaPrefix) OSPFIntraAreaPrefixLSABody(); break;
+            case OSPF_LSA_TYPE_GRACE: new (&m_grace) OSPFGraceLSABody(); break;
+            default: return;
+        }
+        m_type = type;
+    }
+
+    uint16_t GetType () const {return m_type;}
+    bool IsEmpty () const {return m_type == 0;}
+
+    // 型が一致しなければnullptr
+    template <typename T> T* Get () {
+        return Member(static_cast<T*>(nullptr));
+    }
+    template <typename T> const T* Get () const {
+        return const_cast<OSPFLSABody*>(this)->Member(static_cast<T*>(nullptr));
+    }
+
+    uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes) {
+        switch (m_type) {
+            case OSPF_LSA_TYPE_ROUTER: return m_router.Deserialize(i, remainBytes);
+            case OSPF_LSA_TYPE_NETWORK: return m_network.Deserialize(i, remainBytes);
+            case OSPF_LSA_TYPE_LINK: return m_link.Deserialize(i, remainBytes);
+            case OSPF_LSA_TYPE_INTER_AREA_PREFIX: return m_interAreaPrefix.Deserialize(i, remainBytes);
+            case OSPF_LSA_TYPE_INTRA_AREA_PREFIX: return m_intraAreaPrefix.Deserialize(i, remainBytes);
+            case OSPF_LSA_TYPE_GRACE: return m_grace.Deserialize(i, remainBytes);
+        }
+        i.Next(remainBytes);
+        return 0;
+    }
+    uint32_t GetSerializedSize () const {
+        switch (m_type) {
+            case OSPF_LSA_TYPE_ROUTER: return m_router.GetSerializedSize();
+            case OSPF_LSA_TYPE_NETWORK: return m_network.GetSerializedSize();
+            case OSPF_LSA_TYPE_LINK: return m_link.GetSerializedSize();
+            case OSPF_LSA_TYPE_INTER_AREA_PREFIX: return m_interAreaPrefix.GetSerializedSize();
+            case OSPF_LSA_TYPE_INTRA_AREA_PREFIX: return m_intraAreaPrefix.GetSerializedSize();
+            case OSPF_LSA_TYPE_GRACE: return m_grace.GetSerializedSize();
+        }
+        return 0;
+    }
+    void Print (std::ostream &os) const {
+        switch (m_type) {
+            case OSPF_LSA_TYPE_ROUTER: m_router.Print(os); break;
+            case OSPF_LSA_TYPE_NETWORK: m_network.Print(os); break;
+            case OSPF_LSA_TYPE_LINK: m_link.Print(os); break;
+            case OSPF_LSA_TYPE_INTER_AREA_PREFIX: m_interAreaPrefix.Print(os); break;
+            case OSPF_LSA_TYPE_INTRA_AREA_PREFIX: m_intraAreaPrefix.Print(os); break;
+            case OSPF_LSA_TYPE_GRACE: m_grace.Print(os); break;
+        }
+    }
+    void Serialize (Buffer::Iterator &i) const {
+        switch (m_type) {
+            case OSPF_LSA_TYPE_ROUTER: m_router.Serialize(i); break;
+            case OSPF_LSA_TYPE_NETWORK: m_network.Serialize(i); break;
+            case OSPF_LSA_TYPE_LINK: m_link.Serialize(i); break;
+            case OSPF_LSA_TYPE_INTER_AREA_PREFIX: m_interAreaPrefix.Serialize(i); break;
+            case OSPF_LSA_TYPE_INTRA_AREA_PREFIX: m_intraAreaPrefix.Serialize(i); break;
+            case OSPF_LSA_TYPE_GRACE: m_grace.Serialize(i); break;
+        }
+    }
     bool operator== (const OSPFLSABody &other) const {
+        if (m_type != other.m_type) return false;
+        switch (m_type) {
+            case OSPF_LSA_TYPE_ROUTER: return m_router == other.m_router;
+            case OSPF_LSA_TYPE_NETWORK: return m_network == other.m_network;
+            case OSPF_LSA_TYPE_LINK: return m_link == other.m_link;
+            case OSPF_LSA_TYPE_INTER_AREA_PREFIX: return m_interAreaPrefix == other.m_interAreaPrefix;
+            case OSPF_LSA_TYPE_INTRA_AREA_PREFIX: return m_intraAreaPrefix == other.m_intraAreaPrefix;
+            case OSPF_LSA_TYPE_GRACE: return m_grace == other.m_grace;
+        }
         return true;
     }
 };
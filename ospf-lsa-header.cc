@@ -5,17 +5,6 @@ namespace ns3 {
 namespace ospf {
 
 NS_LOG_COMPONENT_DEFINE("OSPFLSAHeader");
-NS_OBJECT_ENSURE_REGISTERED(OSPFLSAHeader);
-
-TypeId OSPFLSAHeader::GetTypeId () {
-    static TypeId tid = TypeId("ns3::ospf::OSPFLSAHeader")
-        .AddConstructor<OSPFLSAHeader>();
-    return tid;
-}
-
-TypeId OSPFLSAHeader::GetInstanceTypeId () const {
-    return GetTypeId();
-}
 
 uint32_t OSPFLSAHeader::GetSerializedSize () const {
     return 20;
@@ -80,10 +69,10 @@ std::ostream& operator<< (std::ostream& os, const OSPFLSAHeader& lsaHdr) {
     lsaHdr.Print(os);
     return os;
 }
-std::ostream& operator<< (std::ostream& os, std::vector<Ptr<OSPFLSAHeader> >& lsaHdrs) {
+std::ostream& operator<< (std::ostream& os, std::vector<OSPFLSAHeader>& lsaHdrs) {
     os << "#" << lsaHdrs.size() << " (";
-    for (auto item : lsaHdrs) {
-        item->Print(os);
+    for (auto& item : lsaHdrs) {
+        item.Print(os);
         os << ", ";
     }
     os << ")";
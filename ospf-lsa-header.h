@@ -2,12 +2,13 @@
 #define OSPF_LSA_HEADER_H
 
 #include "ns3/ipv6-address.h"
-#include "ns3/object.h"
 #include "ns3/buffer.h"
 #include "ospf-lsa-identifier.h"
 #include "ospf-constants.h"
 #include <cstdlib>
 #include <iostream>
+#include <type_traits>
+#include <vector>
 
 /*
 
@@ -43,17 +44,20 @@ namespace ospf {
 #define OSPF_LSA_TYPE_NSSA 0x2007
 #define OSPF_LSA_TYPE_LINK 0x0008
 #define OSPF_LSA_TYPE_INTRA_AREA_PREFIX 0x2009
+#define OSPF_LSA_TYPE_GRACE 0x000b // RFC 5187
 
-class OSPFLSAHeader : public Object {
+// 20バイトの値型。パケット内のリストやネイバーごとのリストにはコピーで持つ
+// 共有が必要なのはOSPFLSAの中身だけなので、Ptrでは包まない
+class OSPFLSAHeader {
 protected:
     typedef uint32_t RouterId;
-    uint16_t m_age;
-    uint16_t m_type;
-    uint32_t m_id;
-    RouterId m_advRtr;
-    int32_t m_seqNum;
-    uint16_t m_checksum;
-    uint16_t m_length;
+    uint16_t m_age = 0;
+    uint16_t m_type = 0;
+    uint32_t m_id = 0;
+    RouterId m_advRtr = 0;
+    int32_t m_seqNum = 0;
+    uint16_t m_checksum = 0;
+    uint16_t m_length = 0;
     /*
     types
         1: router LSA(from all router)
@@ -67,56 +71,31 @@ protected:
     */
 
 public:
-    OSPFLSAHeader () {};
-    OSPFLSAHeader (const OSPFLSAHeader &o) {
-        m_age = o.m_age;
-        m_type = o.m_type;
-        m_id = o.m_id;
-        m_advRtr = o.m_advRtr;
-        m_seqNum = o.m_seqNum;
-        m_checksum = o.m_checksum;
-        m_length = o.m_length;
-    };
-    OSPFLSAHeader &operator= (const OSPFLSAHeader &o) {
-        m_age = o.m_age;
-        m_type = o.m_type;
-        m_id = o.m_id;
-        m_advRtr = o.m_advRtr;
-        m_seqNum = o.m_seqNum;
-        m_checksum = o.m_checksum;
-        m_length = o.m_length;
-        return (*this);
-    };
-    ~OSPFLSAHeader () {};
-
-    static TypeId GetTypeId();
-
-    virtual TypeId GetInstanceTypeId (void) const;
-    virtual uint32_t Deserialize (Buffer::Iterator &i);
-    virtual uint32_t GetSerializedSize () const; 
-    virtual void Print (std::ostream &os) const; 
-    virtual void Serialize (Buffer::Iterator &i) const;
-    virtual void Serialize (Buffer::Iterator &i, uint32_t bodySize) const;
-
-    virtual void SetAge(uint16_t age) {m_age = age;}
-    virtual uint16_t GetAge() {return m_age;}
-    virtual void SetType(uint16_t type) {m_type = type;}
-    virtual uint16_t GetType() {return m_type;}
-    virtual bool IsLinkLocalScope () {return (m_type & 0xf000) == 0;}
-    virtual bool IsAreaScope () {return (m_type & 0xf000) == 2;}
-    virtual bool IsASScope () {return (m_type & 0xf000) == 4;}
-    virtual void SetId(uint32_t id) {m_id = id;}
-    virtual uint32_t GetId() {return m_id;}
-    virtual void SetAdvertisingRouter(RouterId advRtr) {m_advRtr = advRtr;}
-    virtual RouterId GetAdvertisingRouter() {return m_advRtr;}
-    virtual void SetSequenceNumber(int32_t seqNum) {m_seqNum = seqNum;}
-    virtual int32_t GetSequenceNumber() {return m_seqNum;}
-    virtual void IncrementSequenceNumber() {m_seqNum++;}
-    virtual void InitializeSequenceNumber() {m_seqNum = g_initialSeqNum;}
-    virtual void SetChecksum(uint16_t checksum) {m_checksum = checksum;}
-    virtual uint16_t GetCheckSum() {return m_checksum;}
-    virtual void SetLength(uint16_t length) {m_length = length;}
-    virtual uint16_t GetLength() {return m_length;}
+    uint32_t Deserialize (Buffer::Iterator &i);
+    uint32_t GetSerializedSize () const;
+    void Print (std::ostream &os) const;
+    void Serialize (Buffer::Iterator &i) const;
+    void Serialize (Buffer::Iterator &i, uint32_t bodySize) const;
+
+    void SetAge(uint16_t age) {m_age = age;}
+    uint16_t GetAge() const {return m_age;}
+    void SetType(uint16_t type) {m_type = type;}
+    uint16_t GetType() const {return m_type;}
+    bool IsLinkLocalScope () const {return (m_type & 0xf000) == 0;}
+    bool IsAreaScope () const {return (m_type & 0xf000) == 2;}
+    bool IsASScope () const {return (m_type & 0xf000) == 4;}
+    void SetId(uint32_t id) {m_id = id;}
+    uint32_t GetId() const {return m_id;}
+    void SetAdvertisingRouter(RouterId advRtr) {m_advRtr = advRtr;}
+    RouterId GetAdvertisingRouter() const {return m_advRtr;}
+    void SetSequenceNumber(int32_t seqNum) {m_seqNum = seqNum;}
+    int32_t GetSequenceNumber() const {return m_seqNum;}
+    void IncrementSequenceNumber() {m_seqNum++;}
+    void InitializeSequenceNumber() {m_seqNum = g_initialSeqNum;}
+    void SetChecksum(uint16_t checksum) {m_checksum = checksum;}
+    uint16_t GetCheckSum() const {return m_checksum;}
+    void SetLength(uint16_t length) {m_length = length;}
+    uint16_t GetLength() const {return m_length;}
     OSPFLinkStateIdentifier CreateIdentifier () const {
         return OSPFLinkStateIdentifier(m_type, m_id, m_advRtr);
     }
@@ -170,12 +149,15 @@ public:
         );
     }
 
-    bool IsDeprecatedInstance () {
+    bool IsDeprecatedInstance () const {
         return m_age == g_maxAge && m_seqNum == g_maxSeqNum;
     }
 };
 std::ostream& operator<< (std::ostream& os, const OSPFLSAHeader& lsaHdr);
-std::ostream& operator<< (std::ostream& os, std::vector<Ptr<OSPFLSAHeader> >& lsaHdrs);
+std::ostream& operator<< (std::ostream& os, std::vector<OSPFLSAHeader>& lsaHdrs);
+
+static_assert(sizeof(OSPFLSAHeader) == 20, "OSPFLSAHeader must match the 20-byte wire format");
+static_assert(std::is_trivially_copyable<OSPFLSAHeader>::value, "OSPFLSAHeader must be trivially copyable");
 
 }
 }
@@ -15,43 +15,32 @@ TypeId OSPFLSA::GetTypeId () {
 
 uint32_t OSPFLSA::GetSerializedSize () const {
     return (
-        (m_header ? m_header->GetSerializedSize() : 0) +
-        (m_body ? m_body->GetSerializedSize() : 0)
+        m_header.GetSerializedSize() +
+        m_body.GetSerializedSize()
     );
 } 
 void OSPFLSA::Print (std::ostream &os) const {
-    if (m_header) m_header->Print(os);
-    if (m_body) m_body->Print(os);
+    m_header.Print(os);
+    m_body.Print(os);
 } 
 void OSPFLSA::Serialize (Buffer::Iterator &i) const {
-    if (m_header && m_body) {
-        m_header->Serialize(i, m_body->GetSerializedSize());
-        m_body->Serialize(i);
+    if (!m_body.IsEmpty()) {
+        m_header.Serialize(i, m_body.GetSerializedSize());
+        m_body.Serialize(i);
         return;
     }
 
-    if (m_header) {
-        m_header->Serialize(i);
-        return;
-    }
-
-    if (m_body) {
-        m_body->Serialize(i);
-        return;
-    }
+    m_header.Serialize(i);
 }
 uint32_t OSPFLSA::Deserialize (Buffer::Iterator &i) {
-    if (!m_header) {
-        m_header = Create<OSPFLSAHeader>();
-    }
-    // i.Next(m_header->Deserialize(i));
-    m_header->Deserialize(i);
+    // i.Next(m_header.Deserialize(i));
+    m_header.Deserialize(i);
 
-    uint16_t type = m_header->GetType();
+    uint16_t type = m_header.GetType();
     CreateBody(type);
 
     // i.Next(m_body->Deserialize(i));
-    m_body->Deserialize(i, m_header->GetLength() - m_header->GetSerializedSize());
+    m_body.Deserialize(i, m_header.GetLength() - m_header.GetSerializedSize());
 
     return OSPFLSA::GetSerializedSize();
 }
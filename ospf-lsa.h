@@ -4,10 +4,6 @@
 #include "ospf-lsa-header.h"
 #include "ospf-lsa-body.h"
 
-#include "ospf-router-lsa.h"
-#include "ospf-link-lsa.h"
-#include "ospf-intra-area-prefix-lsa.h"
-
 #include <iostream>
 
 using namespace ns3;
@@ -17,8 +13,8 @@ namespace ospf {
 
 class OSPFLSA : public Object {
 private:
-    Ptr<OSPFLSAHeader> m_header;
-    Ptr<OSPFLSABody> m_body;
+    OSPFLSAHeader m_header;
+    OSPFLSABody m_body;
 
 public:
     OSPFLSA () {
@@ -42,8 +38,7 @@ public:
     }
 
     void AgingBeforeFlooding (uint16_t aging) {
-        m_header = Ptr<OSPFLSAHeader>(new OSPFLSAHeader(*m_header));
-        m_header->SetAge(m_header->GetAge() + aging);
+        m_header.SetAge(m_header.GetAge() + aging);
     }
 
     virtual TypeId GetInstanceId (void) const {return GetTypeId();};
@@ -58,60 +53,41 @@ public:
     }
 
     void CreateHeader (uint16_t type) {
-        m_header = Create<OSPFLSAHeader>();
-        m_header->SetType(type);
+        m_header = OSPFLSAHeader();
+        m_header.SetType(type);
     }
 
     void CreateBody (uint16_t type) {
-        switch(type) {
-            case OSPF_LSA_TYPE_ROUTER: {
-                m_body = Create<OSPFRouterLSABody>();
-            } break;
-            case OSPF_LSA_TYPE_LINK: {
-                m_body = Create<OSPFLinkLSABody>();
-            } break;
-            case OSPF_LSA_TYPE_INTRA_AREA_PREFIX: {
-                m_body = Create<OSPFIntraAreaPrefixLSABody>();
-            } break;
-        }
+        m_body.Emplace(type);
     }
 
     OSPFLinkStateIdentifier GetIdentifier () {
-        return GetHeader()->CreateIdentifier();
+        return m_header.CreateIdentifier();
     }
 
     bool IsDeprecatedInstance() {
-        return GetHeader()->IsDeprecatedInstance();
+        return m_header.IsDeprecatedInstance();
     }
 
-    Ptr<OSPFLSAHeader> GetHeader () {return m_header;}
-    Ptr<OSPFLSABody> GetBody () {return m_body;}
-    template <typename T> Ptr<T> GetBody () {
-        return DynamicCast<T>(m_body);
+    OSPFLSAHeader& GetHeader () {return m_header;}
+    const OSPFLSAHeader& GetHeader () const {return m_header;}
+    OSPFLSABody& GetBody () {return m_body;}
+    const OSPFLSABody& GetBody () const {return m_body;}
+    // LS Typeが合わなければnullptr
+    template <typename T> T* GetBody () {
+        return m_body.Get<T>();
+    }
+    template <typename T> const T* GetBody () const {
+        return m_body.Get<T>();
     }
     virtual bool operator== (const OSPFLSA &other) const {
-        if (m_header && m_body) {
-            return (
-                *m_header == *other.m_header &&
-                *m_body == *other.m_body
-            );
-        }
-        if (!m_header && m_body) {
-            return *m_body == *other.m_body;
-        }
-        if (!m_body && m_header) {
-            return *m_header == *other.m_header;
-        }
         return (
             m_header == other.m_header &&
             m_body == other.m_body
         );
     }
     virtual bool operator== (const OSPFLinkStateIdentifier &other) const {
-        if (m_header) {
-            return *m_header == other;
-        }
-        return false;
+        return m_header == other;
     }
 };
 std::ostream& operator<< (std::ostream& os, const OSPFLSA& lsa);
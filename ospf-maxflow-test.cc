@@ -0,0 +1,34 @@
+#include "ospf-maxflow.h"
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include <map>
+#include <iostream>
+using namespace std;
+
+void TestForOSPFMaxFlow () {
+
+    cout << " - TestForOSPFMaxFlow - " << endl;
+    ns3::ospf::MaxFlowGraph graph;
+    graph.Reset(4);
+    graph.AddEdge(0, 1, 3);
+    graph.AddEdge(0, 2, 2);
+    graph.AddEdge(1, 3, 2);
+    graph.AddEdge(1, 2, 1);
+    graph.AddEdge(2, 3, 5);
+
+    NS_ABORT_MSG_UNLESS(graph.Compute(0, 3) == 5, "max flow 0 -> 3");
+
+    vector<pair<uint32_t, uint32_t> > flows;
+    graph.GetOutgoingFlows(0, flows);
+    map<uint32_t, uint32_t> shares(flows.begin(), flows.end());
+    NS_ASSERT(shares.size() == 2);
+    NS_ASSERT(shares[1] == 3);
+    NS_ASSERT(shares[2] == 2);
+
+    // 同じグラフで宛先を変えても前回のフローは残らない
+    NS_ABORT_MSG_UNLESS(graph.Compute(0, 2) == 3, "max flow 0 -> 2");
+    NS_ABORT_MSG_UNLESS(graph.Compute(3, 0) == 0, "max flow 3 -> 0");
+
+    return;
+}
@@ -0,0 +1,83 @@
+#include <queue>
+#include <algorithm>
+
+#include "ospf-maxflow.h"
+
+namespace ns3 {
+namespace ospf {
+
+void MaxFlowGraph::Reset (uint32_t vertices) {
+    m_adjacents.assign(vertices, std::vector<Edge>());
+}
+
+void MaxFlowGraph::AddEdge (uint32_t from, uint32_t to, uint32_t capacity) {
+    Edge forward = {to, (uint32_t)m_adjacents[to].size(), capacity, capacity};
+    Edge backward = {from, (uint32_t)m_adjacents[from].size(), 0, 0};
+    m_adjacents[from].push_back(forward);
+    m_adjacents[to].push_back(backward);
+}
+
+// 残余グラフ上のsrcからの階層、dstに届かなければfalse
+bool MaxFlowGraph::BuildLevel (uint32_t src, uint32_t dst) {
+    m_level.assign(m_adjacents.size(), -1);
+    std::queue<uint32_t> que;
+    m_level[src] = 0;
+    que.push(src);
+    while (!que.empty()) {
+        uint32_t from = que.front();
+        que.pop();
+        for (const Edge& edge : m_adjacents[from]) {
+            if (edge.m_residual > 0 && m_level[edge.m_to] < 0) {
+                m_level[edge.m_to] = m_level[from] + 1;
+                que.push(edge.m_to);
+            }
+        }
+    }
+    return m_level[dst] >= 0;
+}
+
+// 階層が1つずつ増える辺だけを通る増加道を探して流す
+uint32_t MaxFlowGraph::Augment (uint32_t vertex, uint32_t dst, uint32_t limit) {
+    if (vertex == dst) return limit;
+    for (uint32_t& idx = m_iter[vertex]; idx < m_adjacents[vertex].size(); ++idx) {
+        Edge& edge = m_adjacents[vertex][idx];
+        if (edge.m_residual == 0 || m_level[edge.m_to] != m_level[vertex] + 1) continue;
+        uint32_t flow = Augment(edge.m_to, dst, std::min(limit, edge.m_residual));
+        if (flow > 0) {
+            edge.m_residual -= flow;
+            m_adjacents[edge.m_to][edge.m_rev].m_residual += flow;
+            return flow;
+        }
+    }
+    return 0;
+}
+
+uint64_t MaxFlowGraph::Compute (uint32_t src, uint32_t dst) {
+    for (auto& edges : m_adjacents) {
+        for (Edge& edge : edges) {
+            edge.m_residual = edge.m_capacity;
+        }
+    }
+    if (src == dst || src >= m_adjacents.size() || dst >= m_adjacents.size()) return 0;
+
+    uint64_t total = 0;
+    while (BuildLevel(src, dst)) {
+        m_iter.assign(m_adjacents.size(), 0);
+        while (uint32_t flow = Augment(src, dst, UINT32_MAX)) {
+            total += flow;
+        }
+    }
+    return total;
+}
+
+void MaxFlowGraph::GetOutgoingFlows (uint32_t vertex, std::vector<std::pair<uint32_t, uint32_t> >& flows) const {
+    flows.clear();
+    for (const Edge& edge : m_adjacents[vertex]) {
+        if (edge.m_capacity > edge.m_residual) {
+            flows.push_back(std::make_pair(edge.m_to, edge.m_capacity - edge.m_residual));
+        }
+    }
+}
+
+}
+}
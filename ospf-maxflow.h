@@ -0,0 +1,53 @@
+#ifndef OSPF_MAXFLOW_H
+#define OSPF_MAXFLOW_H
+
+#include <stdint.h>
+#include <vector>
+#include <utility>
+
+/*
+    Dinic法による最大フロー
+
+    maxflow-test/a.cc の試作を、頂点ごとの疎な隣接リストにしたもの。
+    辺ごとに逆辺の位置を持ち、残余容量だけを更新する。
+    Computeは前回の結果を捨てて容量から計算し直すので、同じグラフで宛先を変えて何度も呼べる。
+*/
+
+namespace ns3 {
+namespace ospf {
+
+class MaxFlowGraph {
+private:
+    struct Edge {
+        uint32_t m_to;
+        uint32_t m_rev; // m_adjacents[m_to]の中の逆辺の位置
+        uint32_t m_capacity; // 逆辺なら0
+        uint32_t m_residual;
+    };
+    std::vector<std::vector<Edge> > m_adjacents;
+    std::vector<int32_t> m_level;
+    std::vector<uint32_t> m_iter;
+
+    bool BuildLevel (uint32_t src, uint32_t dst);
+    uint32_t Augment (uint32_t vertex, uint32_t dst, uint32_t limit);
+
+public:
+    MaxFlowGraph () {}
+
+    void Reset (uint32_t vertices);
+    uint32_t CountVertices () const {
+        return m_adjacents.size();
+    }
+    void AddEdge (uint32_t from, uint32_t to, uint32_t capacity);
+
+    // srcからdstへの最大フローの量を返す
+    uint64_t Compute (uint32_t src, uint32_t dst);
+
+    // 直前のComputeで、vertexから出ていく辺に流れた正のフロー (行き先, 量)
+    void GetOutgoingFlows (uint32_t vertex, std::vector<std::pair<uint32_t, uint32_t> >& flows) const;
+};
+
+}
+}
+
+#endif
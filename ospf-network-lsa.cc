@@ -0,0 +1,52 @@
+#include "ospf-network-lsa.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace ospf {
+
+/*
+uint32_t m_options;
+vector<uint32_t> m_attachedRouters;
+*/
+
+NS_LOG_COMPONENT_DEFINE("OSPFNetworkLSABody");
+
+uint32_t OSPFNetworkLSABody::GetSerializedSize () const {
+    return 4 + 4 * m_attachedRouters.size();
+} 
+void OSPFNetworkLSABody::Print (std::ostream &os) const {
+    os << "(Network LSA: [";
+    os << "options: " << m_options << ", ";
+    os << "#attached: " << m_attachedRouters.size() << "(";
+    for (uint32_t idx = 0, l = m_attachedRouters.size(); idx < l; ++idx) {
+        if (idx) os << ", ";
+        os << m_attachedRouters[idx];
+    }
+    os << ")])";
+} 
+void OSPFNetworkLSABody::Serialize (Buffer::Iterator &i) const {
+/*
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |      0        |              Options                           |
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                        Attached Router                         |
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                             ...                                |
+*/
+    i.WriteHtonU32(m_options & 0x00ffffff);
+    for (int idx = 0, l = m_attachedRouters.size(); idx < l; ++idx) {
+        i.WriteHtonU32(m_attachedRouters[idx]);
+    }
+}
+uint32_t OSPFNetworkLSABody::Deserialize (Buffer::Iterator &i, uint32_t remainBytes) {
+    m_options = i.ReadNtohU32() & 0x00ffffff;
+
+    uint32_t size = (remainBytes - 4) / 4;
+    for (int idx = 0, l = size; idx < l; ++idx) {
+        m_attachedRouters.push_back(i.ReadNtohU32());
+    }
+    return OSPFNetworkLSABody::GetSerializedSize();
+}
+
+} // namespace ns3
+} // namespace ns3
@@ -0,0 +1,72 @@
+#ifndef OSPF_NETWORK_LSA_H
+#define OSPF_NETWORK_LSA_H
+
+/*
+       0                    1                   2                   3
+       0 1 2 3  4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |           LS Age               |0|0|1|         2               |
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                       Link State ID                            |
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                    Advertising Router                          |
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                    LS Sequence Number                          |
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |        LS Checksum             |            Length             |
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |      0        |              Options                           |
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                        Attached Router                         |
+      +-+-+-+--+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+      |                             ...                                |
+
+                             Network-LSA Format
+
+    DRがトランジットネットワークごとに1つ生成する
+    Link State IDはDRのそのリンクのInterface ID
+*/
+
+#include <vector>
+#include "ospf-lsa-header.h"
+
+using namespace ns3;
+
+namespace ns3 {
+namespace ospf {
+
+class OSPFNetworkLSABody {
+private:
+    uint32_t m_options;
+    std::vector<uint32_t> m_attachedRouters;
+
+public:
+    OSPFNetworkLSABody () : m_options(0) {};
+    ~OSPFNetworkLSABody () {};
+
+    uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes);
+    uint32_t GetSerializedSize () const; 
+    void Print (std::ostream &os) const; 
+    void Serialize (Buffer::Iterator &i) const;
+
+    void SetOptions(uint32_t opts) {m_options = opts;}
+    uint32_t GetOptions() const {return m_options;}
+    uint32_t CountAttachedRouters() const {return m_attachedRouters.size();}
+    uint32_t GetAttachedRouter(int idx) const {return m_attachedRouters[idx];}
+    void ClearAttachedRouters() {
+        m_attachedRouters.clear();
+    }
+    void AddAttachedRouter(uint32_t routerId) {
+        m_attachedRouters.push_back(routerId);
+    }
+    bool operator== (const OSPFNetworkLSABody &other) const {
+        return (
+            m_options == other.m_options &&
+            m_attachedRouters == other.m_attachedRouters
+        );
+    }
+};
+
+}
+}
+#endif
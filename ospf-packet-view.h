@@ -0,0 +1,333 @@
+#ifndef OSPF_PACKET_VIEW_H
+#define OSPF_PACKET_VIEW_H
+
+#include "ns3/ipv6-address.h"
+#include "ns3/buffer.h"
+#include "ospf-header.h"
+#include "ospf-lsa.h"
+#include "ospf-lsa-header.h"
+#include "ospf-lsa-identifier.h"
+
+#include <vector>
+
+/*
+    受信したOSPFパケットを連続したバイト列のまま読むための軽量ビュー
+
+    OSPFPacketView::Parse で共通ヘッダを一度だけ読み、Packet Lengthを検証する。
+    各パケット種別のビューはボディ部分へのポインタを持つだけで、
+    フィールドは読み出し時にネットワークバイトオーダから変換する。
+    ビューは元のバイト列を所有しないので、バイト列より長生きさせないこと。
+*/
+
+using namespace ns3;
+
+namespace ns3 {
+namespace ospf {
+
+#define OSPF_HEADER_LENGTH 16
+#define OSPF_LSA_HEADER_LENGTH 20
+#define OSPF_PROTOCOL_NUMBER 89
+
+class OSPFPacketView {
+private:
+    typedef uint32_t RouterId;
+    const uint8_t* m_data;
+    uint32_t m_size; // 検証済みのPacket Length
+    uint32_t m_trailerSize; // Packet Lengthより後ろのバイト数(LLSデータブロックなど)
+
+public:
+    OSPFPacketView () : m_data(0), m_size(0), m_trailerSize(0) {}
+
+    static uint16_t ReadU16 (const uint8_t* p) {
+        return (uint16_t)((p[0] << 8) | p[1]);
+    }
+    static uint32_t ReadU32 (const uint8_t* p) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+    }
+
+    // IPv6疑似ヘッダ(RFC 5340 2.5, RFC 2460 8.1)込みの1の補数和を計算する
+    // 送信時はチェックサム欄を0にして呼び、結果をそのまま書き込む
+    // 受信時はチェックサム欄込みで呼び、0なら正しい
+    static uint16_t CalcChecksum (const uint8_t* data, uint32_t size, const Ipv6Address& src, const Ipv6Address& dst) {
+        uint8_t addr[16];
+        uint32_t sum = 0;
+        src.Serialize(addr);
+        for (int i = 0; i < 16; i += 2) sum += ReadU16(addr + i);
+        dst.Serialize(addr);
+        for (int i = 0; i < 16; i += 2) sum += ReadU16(addr + i);
+        sum += size >> 16;
+        sum += size & 0xffff;
+        sum += OSPF_PROTOCOL_NUMBER;
+        uint32_t i = 0;
+        for (; i + 1 < size; i += 2) sum += ReadU16(data + i);
+        if (i < size) sum += data[i] << 8;
+        while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+        return (uint16_t)~sum;
+    }
+
+    // 共通ヘッダを読み、Packet Lengthがバイト列に収まっているかを検証する
+    bool Parse (const uint8_t* data, uint32_t size) {
+        m_data = 0;
+        m_size = 0;
+        m_trailerSize = 0;
+        if (size < OSPF_HEADER_LENGTH) return false;
+        if (data[0] != 3) return false;
+        uint16_t packetLength = ReadU16(data + 2);
+        if (packetLength < OSPF_HEADER_LENGTH || packetLength > size) return false;
+        m_data = data;
+        m_size = packetLength;
+        m_trailerSize = size - packetLength;
+        return true;
+    }
+
+    bool VerifyChecksum (const Ipv6Address& src, const Ipv6Address& dst) const {
+        return CalcChecksum(m_data, m_size, src, dst) == 0;
+    }
+
+    uint8_t GetVersion () const {return m_data[0];}
+    uint8_t GetType () const {return m_data[1];}
+    uint16_t GetPacketLength () const {return m_size;}
+    RouterId GetRouterId () const {return ReadU32(m_data + 4);}
+    uint32_t GetAreaId () const {return ReadU32(m_data + 8);}
+    uint16_t GetChecksum () const {return ReadU16(m_data + 12);}
+    uint8_t GetInstanceId () const {return m_data[14];}
+
+    const uint8_t* GetBody () const {return m_data + OSPF_HEADER_LENGTH;}
+    uint32_t GetBodySize () const {return m_size - OSPF_HEADER_LENGTH;}
+    const uint8_t* GetTrailer () const {return m_data + m_size;}
+    uint32_t GetTrailerSize () const {return m_trailerSize;}
+
+    // LSAヘッダ(20バイト)を読み出す
+    static void ReadLSAHeader (const uint8_t* p, OSPFLSAHeader& hdr) {
+        hdr.SetAge(ReadU16(p));
+        hdr.SetType(ReadU16(p + 2));
+        hdr.SetId(ReadU32(p + 4));
+        hdr.SetAdvertisingRouter(ReadU32(p + 8));
+        hdr.SetSequenceNumber(ReadU32(p + 12));
+        hdr.SetChecksum(ReadU16(p + 16));
+        hdr.SetLength(ReadU16(p + 18));
+    }
+};
+
+class OSPFHelloView {
+private:
+    typedef uint32_t RouterId;
+    const uint8_t* m_body;
+    uint32_t m_count;
+
+public:
+    static const uint32_t FIXED_LENGTH = 20;
+
+    OSPFHelloView () : m_body(0), m_count(0) {}
+
+    bool Parse (const OSPFPacketView& packet) {
+        if (packet.GetBodySize() < FIXED_LENGTH) return false;
+        m_body = packet.GetBody();
+        m_count = (packet.GetBodySize() - FIXED_LENGTH) / 4;
+        return true;
+    }
+
+    uint32_t GetInterfaceId () const {return OSPFPacketView::ReadU32(m_body);}
+    uint8_t GetRouterPriority () const {return m_body[4];}
+    uint32_t GetOptions () const {return OSPFPacketView::ReadU32(m_body + 4) & 0x00ffffff;}
+    uint16_t GetHelloInterval () const {return OSPFPacketView::ReadU16(m_body + 8);}
+    uint16_t GetRouterDeadInterval () const {return OSPFPacketView::ReadU16(m_body + 10);}
+    RouterId GetDesignatedRouter () const {return OSPFPacketView::ReadU32(m_body + 12);}
+    RouterId GetBackupDesignatedRouter () const {return OSPFPacketView::ReadU32(m_body + 16);}
+    uint32_t CountNeighbors () const {return m_count;}
+    RouterId GetNeighbor (uint32_t idx) const {return OSPFPacketView::ReadU32(m_body + FIXED_LENGTH + idx * 4);}
+};
+
+class OSPFDatabaseDescriptionView {
+private:
+    const uint8_t* m_body;
+    uint32_t m_count;
+
+public:
+    static const uint32_t FIXED_LENGTH = 12;
+
+    OSPFDatabaseDescriptionView () : m_body(0), m_count(0) {}
+
+    bool Parse (const OSPFPacketView& packet) {
+        if (packet.GetBodySize() < FIXED_LENGTH) return false;
+        m_body = packet.GetBody();
+        m_count = (packet.GetBodySize() - FIXED_LENGTH) / OSPF_LSA_HEADER_LENGTH;
+        return true;
+    }
+
+    uint32_t GetOptions () const {return OSPFPacketView::ReadU32(m_body);}
+    uint16_t GetMtu () const {return OSPFPacketView::ReadU16(m_body + 4);}
+    bool GetInitFlag () const {return (m_body[7] >> 2) & 0x1;}
+    bool GetMoreFlag () const {return (m_body[7] >> 1) & 0x1;}
+    bool GetMasterFlag () const {return m_body[7] & 0x1;}
+    uint32_t GetSequenceNumber () const {return OSPFPacketView::ReadU32(m_body + 8);}
+    uint32_t CountLSAHeaders () const {return m_count;}
+    void GetLSAHeader (uint32_t idx, OSPFLSAHeader& hdr) const {
+        OSPFPacketView::ReadLSAHeader(m_body + FIXED_LENGTH + idx * OSPF_LSA_HEADER_LENGTH, hdr);
+    }
+    bool IsNegotiation () const {
+        return GetInitFlag() && GetMoreFlag() && GetMasterFlag() && m_count == 0;
+    }
+};
+
+// RFC 5613 LLSデータブロック
+// OptionsのLビットが立っているパケットで、Packet Lengthの後ろを読む
+class OSPFLLSView {
+private:
+    const uint8_t* m_block;
+    uint32_t m_size;
+
+public:
+    OSPFLLSView () : m_block(0), m_size(0) {}
+
+    // LLS Data Lengthが残りのバイト列に収まっているか、チェックサム(0なら省略)が正しいかを検証する
+    bool Parse (const OSPFPacketView& packet) {
+        m_block = 0;
+        m_size = 0;
+        if (packet.GetTrailerSize() < 4) return false;
+        const uint8_t* p = packet.GetTrailer();
+        uint32_t size = OSPFPacketView::ReadU16(p + 2) * 4;
+        if (size < 4 || size > packet.GetTrailerSize()) return false;
+        if (OSPFPacketView::ReadU16(p) != 0) {
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < size; i += 2) sum += OSPFPacketView::ReadU16(p + i);
+            while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+            if (sum != 0xffff) return false;
+        }
+        m_block = p;
+        m_size = size;
+        return true;
+    }
+
+    // 見つからないか、Lengthがブロックに収まっていなければfalse
+    bool FindTLV (uint16_t type, const uint8_t*& value, uint16_t& length) const {
+        uint32_t offset = 4;
+        while (offset + 4 <= m_size) {
+            uint16_t tlvType = OSPFPacketView::ReadU16(m_block + offset);
+            uint16_t tlvLength = OSPFPacketView::ReadU16(m_block + offset + 2);
+            if (offset + 4 + tlvLength > m_size) return false;
+            if (tlvType == type) {
+                value = m_block + offset + 4;
+                length = tlvLength;
+                return true;
+            }
+            offset += 4 + ((tlvLength + 3) & ~3u);
+        }
+        return false;
+    }
+};
+
+class OSPFLinkStateRequestView {
+private:
+    const uint8_t* m_body;
+    uint32_t m_count;
+
+public:
+    static const uint32_t ENTRY_LENGTH = 12;
+
+    OSPFLinkStateRequestView () : m_body(0), m_count(0) {}
+
+    bool Parse (const OSPFPacketView& packet) {
+        m_body = packet.GetBody();
+        m_count = packet.GetBodySize() / ENTRY_LENGTH;
+        return true;
+    }
+
+    uint32_t CountLinkStateIdentifiers () const {return m_count;}
+    OSPFLinkStateIdentifier GetLinkStateIdentifier (uint32_t idx) const {
+        const uint8_t* p = m_body + idx * ENTRY_LENGTH;
+        return OSPFLinkStateIdentifier(
+            OSPFPacketView::ReadU16(p + 2),
+            OSPFPacketView::ReadU32(p + 4),
+            OSPFPacketView::ReadU32(p + 8)
+        );
+    }
+};
+
+class OSPFLinkStateUpdateView {
+private:
+    const uint8_t* m_body;
+    uint32_t m_bodySize;
+    uint32_t m_count;
+
+public:
+    OSPFLinkStateUpdateView () : m_body(0), m_bodySize(0), m_count(0) {}
+
+    // # LSAsと各LSAのLengthがボディに収まっているかを検証する
+    bool Parse (const OSPFPacketView& packet) {
+        if (packet.GetBodySize() < 4) return false;
+        m_body = packet.GetBody();
+        m_bodySize = packet.GetBodySize();
+        m_count = OSPFPacketView::ReadU32(m_body);
+        uint32_t offset = 4;
+        for (uint32_t i = 0; i < m_count; ++i) {
+            if (offset + OSPF_LSA_HEADER_LENGTH > m_bodySize) return false;
+            uint16_t length = OSPFPacketView::ReadU16(m_body + offset + 18);
+            if (length < OSPF_LSA_HEADER_LENGTH || offset + length > m_bodySize) return false;
+            offset += length;
+        }
+        return true;
+    }
+
+    uint32_t CountLSAs () const {return m_count;}
+
+    // LSDBに保持するためにLSAを実体化する
+    void GetLSAs (std::vector<Ptr<OSPFLSA> >& lsas) const {
+        lsas.reserve(lsas.size() + m_count);
+        uint32_t offset = 4;
+        for (uint32_t i = 0; i < m_count; ++i) {
+            uint16_t length = OSPFPacketView::ReadU16(m_body + offset + 18);
+            Buffer buffer;
+            buffer.AddAtStart(length);
+            buffer.Begin().Write(m_body + offset, length);
+            Buffer::Iterator itr = buffer.Begin();
+            Ptr<OSPFLSA> lsa = Create<OSPFLSA>();
+            lsa->Deserialize(itr);
+            lsas.push_back(lsa);
+            offset += length;
+        }
+    }
+};
+
+class OSPFLivenessProbeView {
+private:
+    const uint8_t* m_body;
+
+public:
+    static const uint32_t FIXED_LENGTH = 4;
+
+    OSPFLivenessProbeView () : m_body(0) {}
+
+    bool Parse (const OSPFPacketView& packet) {
+        if (packet.GetBodySize() < FIXED_LENGTH) return false;
+        m_body = packet.GetBody();
+        return true;
+    }
+
+    uint32_t GetInterfaceId () const {return OSPFPacketView::ReadU32(m_body);}
+};
+
+class OSPFLinkStateAckView {
+private:
+    const uint8_t* m_body;
+    uint32_t m_count;
+
+public:
+    OSPFLinkStateAckView () : m_body(0), m_count(0) {}
+
+    bool Parse (const OSPFPacketView& packet) {
+        m_body = packet.GetBody();
+        m_count = packet.GetBodySize() / OSPF_LSA_HEADER_LENGTH;
+        return true;
+    }
+
+    uint32_t CountLSAHeaders () const {return m_count;}
+    void GetLSAHeader (uint32_t idx, OSPFLSAHeader& hdr) const {
+        OSPFPacketView::ReadLSAHeader(m_body + idx * OSPF_LSA_HEADER_LENGTH, hdr);
+    }
+};
+
+}
+}
+
+#endif
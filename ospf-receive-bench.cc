@@ -0,0 +1,150 @@
+#include "ospf-packet-view.h"
+#include "ospf-database-description.h"
+#include "ospf-link-state-update.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include <chrono>
+#include <iostream>
+using namespace std;
+
+/*
+    受信処理のマイクロベンチマーク
+    従来のPeekHeader + 型付きHeaderのRemoveHeaderと、
+    1回のコピー + OSPFPacketView(チェックサム検証込み)を比較する
+*/
+
+static Ptr<Packet> BuildChecksummedPacket (const ns3::ospf::OSPFHeader& hdr, Ipv6Address src, Ipv6Address dst) {
+    uint32_t size = hdr.GetSerializedSize();
+    Buffer buffer;
+    buffer.AddAtStart(size);
+    hdr.Serialize(buffer.Begin());
+    Buffer::Iterator itr = buffer.Begin();
+    itr.Next(12);
+    itr.WriteHtonU16(ns3::ospf::OSPFPacketView::CalcChecksum(buffer.PeekData(), size, src, dst));
+    return Create<Packet>(buffer.PeekData(), size);
+}
+
+static double ElapsedMicroSeconds (chrono::steady_clock::time_point begin) {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count();
+}
+
+void BenchForOSPFReceivePath () {
+
+    cout << " - BenchForOSPFReceivePath - " << endl;
+    const int iterations = 10000;
+    Ipv6Address src("fe80::1"), dst("ff02::5");
+
+    // 40 Router-LSAs x 4 links
+    ns3::ospf::OSPFLinkStateUpdate lsu;
+    lsu.SetAreaId(1);
+    lsu.SetRouterId(123);
+    for (int i = 0; i < 40; ++i) {
+        Ptr<ns3::ospf::OSPFLSA> lsa = Create<ns3::ospf::OSPFLSA>();
+        lsa->Initialize(OSPF_LSA_TYPE_ROUTER);
+        lsa->GetHeader().SetAge(1);
+        lsa->GetHeader().SetId(i + 1);
+        lsa->GetHeader().SetAdvertisingRouter(i + 1);
+        lsa->GetHeader().InitializeSequenceNumber();
+        for (int j = 0; j < 4; ++j) {
+            lsa->GetBody<ns3::ospf::OSPFRouterLSABody>()->AddNeighbor(1, 10, j + 1, j + 1, i + j + 2);
+        }
+        lsu.AddLSA(lsa);
+    }
+    Ptr<Packet> lsuPacket = BuildChecksummedPacket(lsu, src, dst);
+
+    // 70 LSA headers
+    ns3::ospf::OSPFDatabaseDescription dd;
+    dd.SetAreaId(1);
+    dd.SetRouterId(123);
+    dd.SetMtu(1500);
+    dd.SetMoreFlag(true);
+    dd.SetSequenceNumber(100);
+    vector<ns3::ospf::OSPFLSAHeader> headers(70);
+    for (int i = 0; i < 70; ++i) {
+        ns3::ospf::OSPFLSAHeader& hdr = headers[i];
+        hdr.SetAge(1);
+        hdr.SetType(OSPF_LSA_TYPE_ROUTER);
+        hdr.SetId(i + 1);
+        hdr.SetAdvertisingRouter(i + 1);
+        hdr.InitializeSequenceNumber();
+        hdr.SetChecksum(0);
+        hdr.SetLength(20);
+    }
+    dd.SetLSAHeaders(headers);
+    Ptr<Packet> ddPacket = BuildChecksummedPacket(dd, src, dst);
+
+    vector<uint8_t> rxBuffer;
+    ns3::ospf::OSPFPacketView view;
+
+    // 正しさの確認
+    rxBuffer.resize(lsuPacket->GetSize());
+    lsuPacket->CopyData(rxBuffer.data(), rxBuffer.size());
+    NS_ABORT_MSG_UNLESS(view.Parse(rxBuffer.data(), rxBuffer.size()), "LSU view parse failed");
+    NS_ABORT_MSG_UNLESS(view.VerifyChecksum(src, dst), "LSU checksum mismatch");
+    NS_ABORT_MSG_UNLESS(!view.VerifyChecksum(Ipv6Address("fe80::2"), dst), "checksum ignores pseudo header");
+    ns3::ospf::OSPFLinkStateUpdateView lsuView;
+    NS_ABORT_MSG_UNLESS(lsuView.Parse(view), "LSU body parse failed");
+    NS_ASSERT(lsuView.CountLSAs() == 40);
+    NS_ABORT_MSG_UNLESS(!view.Parse(rxBuffer.data(), 15), "truncated packet was accepted");
+
+    // Link State Update
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        Ptr<Packet> p = lsuPacket->Copy();
+        ns3::ospf::OSPFHeader common;
+        p->PeekHeader(common);
+        ns3::ospf::OSPFLinkStateUpdate typed;
+        p->RemoveHeader(typed);
+    }
+    double legacyLsu = ElapsedMicroSeconds(begin);
+
+    begin = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        uint32_t size = lsuPacket->GetSize();
+        if (rxBuffer.size() < size) rxBuffer.resize(size);
+        lsuPacket->CopyData(rxBuffer.data(), size);
+        view.Parse(rxBuffer.data(), size);
+        view.VerifyChecksum(src, dst);
+        lsuView.Parse(view);
+        vector<Ptr<ns3::ospf::OSPFLSA> > lsas;
+        lsuView.GetLSAs(lsas);
+    }
+    double viewLsu = ElapsedMicroSeconds(begin);
+
+    // Database Description
+    begin = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        Ptr<Packet> p = ddPacket->Copy();
+        ns3::ospf::OSPFHeader common;
+        p->PeekHeader(common);
+        ns3::ospf::OSPFDatabaseDescription typed;
+        p->RemoveHeader(typed);
+    }
+    double legacyDd = ElapsedMicroSeconds(begin);
+
+    begin = chrono::steady_clock::now();
+    ns3::ospf::OSPFDatabaseDescriptionView ddView;
+    ns3::ospf::OSPFLSAHeader lsaHeader;
+    uint32_t seen = 0;
+    for (int i = 0; i < iterations; ++i) {
+        uint32_t size = ddPacket->GetSize();
+        if (rxBuffer.size() < size) rxBuffer.resize(size);
+        ddPacket->CopyData(rxBuffer.data(), size);
+        view.Parse(rxBuffer.data(), size);
+        view.VerifyChecksum(src, dst);
+        ddView.Parse(view);
+        for (uint32_t j = 0, l = ddView.CountLSAHeaders(); j < l; ++j) {
+            ddView.GetLSAHeader(j, lsaHeader);
+            seen += lsaHeader.GetId() != 0;
+        }
+    }
+    double viewDd = ElapsedMicroSeconds(begin);
+    NS_ASSERT(seen == 70u * iterations);
+
+    cout << "   LSU (40 LSAs)       : legacy " << legacyLsu / iterations << " us/pkt, view " << viewLsu / iterations << " us/pkt" << endl;
+    cout << "   DD  (70 LSA headers): legacy " << legacyDd / iterations << " us/pkt, view " << viewDd / iterations << " us/pkt" << endl;
+
+    return;
+}
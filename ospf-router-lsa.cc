@@ -14,18 +14,6 @@ uint32_t m_neighborRouterId;
 */
 
 NS_LOG_COMPONENT_DEFINE("OSPFRouterLSABody");
-NS_OBJECT_ENSURE_REGISTERED(OSPFRouterLSABody);
-
-TypeId OSPFRouterLSABody::GetTypeId () {
-    static TypeId tid = TypeId("ns3::ospf::OSPFRouterLSABody")
-        .SetParent<OSPFLSABody>()
-        .AddConstructor<OSPFRouterLSABody>();
-    return tid;
-}
-
-TypeId OSPFRouterLSABody::GetInstanceId () const {
-    return GetTypeId();
-}
 
 uint32_t OSPFRouterLSABody::GetSerializedSize () const {
     return 4 + 16 * m_types.size();
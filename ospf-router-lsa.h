@@ -42,14 +42,18 @@
 */
 
 #include <vector>
-#include "ospf-lsa-body.h"
+#include "ospf-lsa-header.h"
 
 using namespace ns3;
 
 namespace ns3 {
 namespace ospf {
 
-class OSPFRouterLSABody : public OSPFLSABody {
+// Options欄の上位8ビットはフラグ。BはABR、EはASBR
+#define OSPF_ROUTER_LSA_BIT_B 0x01000000
+#define OSPF_ROUTER_LSA_BIT_E 0x02000000
+
+class OSPFRouterLSABody {
 private:
     uint32_t m_options;
     std::vector<uint8_t> m_types;
@@ -59,40 +63,37 @@ private:
     std::vector<uint32_t> m_neighborRouterIds;
 
 public:
-    OSPFRouterLSABody () : OSPFLSABody() {};
+    OSPFRouterLSABody () : m_options(0) {};
     ~OSPFRouterLSABody () {};
 
-    static TypeId GetTypeId();
-
-    virtual TypeId GetInstanceId () const;
-    virtual uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes);
-    virtual uint32_t GetSerializedSize () const; 
-    virtual void Print (std::ostream &os) const; 
-    virtual void Serialize (Buffer::Iterator &i) const;
+    uint32_t Deserialize (Buffer::Iterator &i, uint32_t remainBytes);
+    uint32_t GetSerializedSize () const; 
+    void Print (std::ostream &os) const; 
+    void Serialize (Buffer::Iterator &i) const;
 
-    virtual uint32_t CountNeighbors() {return m_types.size();}
-    virtual void SetOptions(uint32_t opts) {m_options = opts;}
-    virtual uint32_t GetOptions() {return m_options;}
-    virtual uint8_t GetType(int idx) {return m_types[idx];}
-    virtual uint16_t GetMetric(int idx) {return m_metrics[idx];}
-    virtual uint32_t GetInterfaceId(int idx) {return m_interfaceIds[idx];}
-    virtual uint32_t GetNeighborInterfaceId(int idx) {return m_neighborInterfaceIds[idx];}
-    virtual uint32_t GetNeighborRouterId(int idx) {return m_neighborRouterIds[idx];}
-    virtual void ClearNeighbors() {
+    uint32_t CountNeighbors() const {return m_types.size();}
+    void SetOptions(uint32_t opts) {m_options = opts;}
+    uint32_t GetOptions() const {return m_options;}
+    uint8_t GetType(int idx) const {return m_types[idx];}
+    uint16_t GetMetric(int idx) const {return m_metrics[idx];}
+    uint32_t GetInterfaceId(int idx) const {return m_interfaceIds[idx];}
+    uint32_t GetNeighborInterfaceId(int idx) const {return m_neighborInterfaceIds[idx];}
+    uint32_t GetNeighborRouterId(int idx) const {return m_neighborRouterIds[idx];}
+    void ClearNeighbors() {
         m_types.clear();
         m_metrics.clear();
         m_interfaceIds.clear();
         m_neighborInterfaceIds.clear();
         m_neighborRouterIds.clear();
     }
-    virtual void AddNeighbor(uint8_t type, uint16_t metric, uint32_t ifaceId, uint32_t nghIfaceId, uint32_t ngnRtrId) {
+    void AddNeighbor(uint8_t type, uint16_t metric, uint32_t ifaceId, uint32_t nghIfaceId, uint32_t ngnRtrId) {
         m_types.push_back(type);
         m_metrics.push_back(metric);
         m_interfaceIds.push_back(ifaceId);
         m_neighborInterfaceIds.push_back(nghIfaceId);
         m_neighborRouterIds.push_back(ngnRtrId);
     }
-    virtual bool operator== (const OSPFRouterLSABody &other) const {
+    bool operator== (const OSPFRouterLSABody &other) const {
         return (
             m_options == other.m_options &&
             m_types == other.m_types &&
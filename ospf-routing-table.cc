@@ -1,3 +1,5 @@
+#include <algorithm>
+#include "ns3/hash.h"
 #include "ospf-routing-table.h"
 
 namespace ns3 {
@@ -11,8 +13,8 @@ RoutingTable::RoutingTable() {}
 RoutingTable::~RoutingTable() {
     m_entries.clear();
 }
-bool RoutingTable::LookupRoute(Ipv6Address &dst, Ipv6RoutingTableEntry &ret) {
-    NS_LOG_FUNCTION(this << dst);
+bool RoutingTable::LookupRoute(Ipv6Address &dst, Ipv6RoutingTableEntry &ret, Ipv6Address src) {
+    NS_LOG_FUNCTION(this << dst << src);
 
     if(m_entries.empty()){
         NS_LOG_LOGIC("Route to " << dst << " not found: table is empty");
@@ -22,6 +24,25 @@ bool RoutingTable::LookupRoute(Ipv6Address &dst, Ipv6RoutingTableEntry &ret) {
     for (auto& entry : m_entries) {
         if (entry.GetDestNetworkPrefix().IsMatch(dst, entry.GetDest())) {
             ret = entry;
+            if (!m_multipaths.empty()) {
+                auto multipath = m_multipaths.find(std::make_pair(entry.GetDest(), entry.GetDestNetworkPrefix().GetPrefixLength()));
+                if (multipath != m_multipaths.end()) {
+                    // 同じフローは同じネクストホップを通るように、アドレスの組で重み付きに選ぶ
+                    uint8_t addrs[32];
+                    src.Serialize(addrs);
+                    dst.Serialize(addrs + 16);
+                    uint64_t total = 0;
+                    for (auto& item : multipath->second) total += item.second;
+                    uint64_t point = total ? Hash32((const char*)addrs, sizeof(addrs)) % total : 0;
+                    for (auto& item : multipath->second) {
+                        if (point < item.second) {
+                            ret = item.first;
+                            break;
+                        }
+                        point -= item.second;
+                    }
+                }
+            }
             return true;
         }
     }
@@ -30,13 +51,58 @@ bool RoutingTable::LookupRoute(Ipv6Address &dst, Ipv6RoutingTableEntry &ret) {
     return false;
 }
 
+// LookupRouteは先頭から探すので、プレフィクス長の長い順に並べて最長一致にする
 bool RoutingTable::AddRoute(Ipv6RoutingTableEntry &entry) {
     NS_LOG_FUNCTION(this << entry.GetDest() << entry.GetDestNetworkPrefix());
 
-    m_entries.push_back(entry);
+    uint8_t prefixLength = entry.GetDestNetworkPrefix().GetPrefixLength();
+    auto it = m_entries.begin();
+    while (it != m_entries.end() && it->GetDestNetworkPrefix().GetPrefixLength() >= prefixLength) {
+        ++it;
+    }
+    m_entries.insert(it, entry);
     return true;
 }
 
+void RoutingTable::AddBackupRoute(Ipv6RoutingTableEntry &entry) {
+    NS_LOG_FUNCTION(this << entry.GetDest() << entry.GetDestNetworkPrefix() << entry.GetInterface());
+    m_backups[std::make_pair(entry.GetDest(), entry.GetDestNetworkPrefix().GetPrefixLength())] = entry;
+}
+
+uint32_t RoutingTable::ActivateBackupRoutes(uint32_t ifaceIdx) {
+    NS_LOG_FUNCTION(this << ifaceIdx);
+    uint32_t activated = 0;
+    // マルチパスからも落ちたインターフェイスを外す
+    for (auto it = m_multipaths.begin(); it != m_multipaths.end(); ) {
+        auto& items = it->second;
+        auto removed = std::remove_if(items.begin(), items.end(), [ifaceIdx](const std::pair<Ipv6RoutingTableEntry, uint32_t>& item) {
+            return item.first.GetInterface() == ifaceIdx;
+        });
+        activated += std::distance(removed, items.end());
+        items.erase(removed, items.end());
+        if (items.empty()) {
+            it = m_multipaths.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto& entry : m_entries) {
+        if (entry.GetInterface() != ifaceIdx) continue;
+        auto backup = m_backups.find(std::make_pair(entry.GetDest(), entry.GetDestNetworkPrefix().GetPrefixLength()));
+        if (backup == m_backups.end() || backup->second.GetInterface() == ifaceIdx) continue;
+        NS_LOG_LOGIC("activate backup route: " << backup->second);
+        entry = backup->second;
+        m_backups.erase(backup);
+        activated++;
+    }
+    return activated;
+}
+
+void RoutingTable::AddMultipathRoute(Ipv6RoutingTableEntry &entry, uint32_t weight) {
+    NS_LOG_FUNCTION(this << entry.GetDest() << entry.GetDestNetworkPrefix() << entry.GetInterface() << weight);
+    m_multipaths[std::make_pair(entry.GetDest(), entry.GetDestNetworkPrefix().GetPrefixLength())].push_back(std::make_pair(entry, weight));
+}
+
 std::ostream& operator<< (std::ostream& os, const RoutingTable& table) {
     for (auto& entry : table.m_entries) {
         os << entry << "\n";
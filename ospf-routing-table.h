@@ -7,6 +7,7 @@
 #include "ns3/ipv6-address.h"
 #include "ns3/ipv6-routing-table-entry.h"
 #include <vector>
+#include <map>
 
 // OSPFv2 11 The Routing Table Structure
 // https://tools.ietf.org/html/rfc2328#page-107
@@ -27,10 +28,19 @@ namespace ospf {
         }
         bool AddRoute(Ipv6RoutingTableEntry &entry);
         // bool RemoveRoute(Ipv6Address &dst);
-        bool LookupRoute(Ipv6Address &dst, Ipv6RoutingTableEntry &entry);
+        // 重み付きマルチパスの宛先では、srcとdstのハッシュでネクストホップを1つ選ぶ
+        bool LookupRoute(Ipv6Address &dst, Ipv6RoutingTableEntry &entry, Ipv6Address src = Ipv6Address::GetZero());
         // bool Update(Ipv6RoutingTableEntry &entry);
+        // 同じ宛先の経路の出力インターフェイスが落ちたときに使う代替経路
+        void AddBackupRoute(Ipv6RoutingTableEntry &entry);
+        // ifaceIdxから出ていく経路を代替経路に置き換え、置き換えた数を返す
+        uint32_t ActivateBackupRoutes(uint32_t ifaceIdx);
+        // 同じ宛先の経路に重み付きのネクストホップを加える。AddRouteで登録した経路より優先する
+        void AddMultipathRoute(Ipv6RoutingTableEntry &entry, uint32_t weight);
         void Clear() {
             m_entries.clear();
+            m_backups.clear();
+            m_multipaths.clear();
         }
         std::vector<Ipv6RoutingTableEntry>& GetCollection() {
             return m_entries;
@@ -38,6 +48,8 @@ namespace ospf {
         friend std::ostream& operator<< (std::ostream& os, const RoutingTable& table);
     private:
         std::vector<Ipv6RoutingTableEntry> m_entries;
+        std::map<std::pair<Ipv6Address, uint8_t>, Ipv6RoutingTableEntry> m_backups; // (宛先, プレフィクス長) -> 代替経路
+        std::map<std::pair<Ipv6Address, uint8_t>, std::vector<std::pair<Ipv6RoutingTableEntry, uint32_t> > > m_multipaths; // 重みつき
     };
 }
 }
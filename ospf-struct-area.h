@@ -0,0 +1,173 @@
+#ifndef OSPF_STRUCT_AREA_H
+#define OSPF_STRUCT_AREA_H
+
+#include "ns3/ipv6-address.h"
+#include "ospf-link-state-database.h"
+#include "ospf-lsa-identifier.h"
+#include <vector>
+#include <map>
+#include <set>
+
+// OSPFv2 6. The Area Data Structure
+// https://tools.ietf.org/html/rfc2328#page-61
+
+namespace ns3 {
+namespace ospf {
+
+// ABRがエリア内の経路を1つのinter-area-prefixにまとめるための範囲
+// m_advertiseがfalseなら範囲に含まれる経路は他のエリアに広告しない
+struct AreaRange {
+    Ipv6Address m_prefix;
+    uint8_t m_prefixLength;
+    bool m_advertise;
+
+    bool Contains (const Ipv6Address& addr, uint8_t prefixLength) const {
+        return m_prefixLength <= prefixLength && Ipv6Prefix(m_prefixLength).IsMatch(m_prefix, addr);
+    }
+};
+
+// 重み付きマルチパスのネクストホップ
+struct AreaNextHop {
+    int32_t m_ifaceIdx;
+    Ipv6Address m_gateway;
+    uint32_t m_weight;
+};
+
+// 経路表を作るときの中間結果、プレフィクスごとに最短のものを残す
+struct AreaRoute {
+    uint32_t m_cost;
+    uint32_t m_areaId;
+    int32_t m_ifaceIdx;
+    Ipv6Address m_gateway;
+    // ループフリー代替経路(RFC 5286)、なければ-1
+    int32_t m_backupIfaceIdx;
+    Ipv6Address m_backupGateway;
+    // 最大フローで計算したときの重み付きネクストホップ、空なら最短経路だけを使う
+    std::vector<AreaNextHop> m_multipath;
+
+    AreaRoute () : m_cost(0), m_areaId(0), m_ifaceIdx(-1), m_backupIfaceIdx(-1) {}
+};
+typedef std::pair<Ipv6Address, uint8_t> AreaRoutePrefix;
+typedef std::map<AreaRoutePrefix, AreaRoute> AreaRouteMap;
+
+class AreaData {
+    uint32_t m_areaId;
+    OSPFLSDB m_lsdb;
+    std::vector<AreaRange> m_ranges;
+
+    // 自身がこのエリアに広告しているinter-area-prefixのLink State ID
+    std::map<AreaRoutePrefix, uint32_t> m_summaryLsIds;
+    uint32_t m_nextSummaryLsId;
+
+    // スタブエリアにはAS-external-LSAを流さず、ABRがデフォルト経路を広告する
+    // m_noSummaryならデフォルト経路以外のinter-area-prefixも広告しない(totally stubby)
+    bool m_stub;
+    bool m_noSummary;
+    uint32_t m_stubDefaultCost;
+
+    // 動的フラッディング(RFC 9667相当)のフラッディングトポロジ
+    // Router-LSAが変わったら作り直す。リンクは(小さいルータID, 大きいルータID)
+    std::set<std::pair<uint32_t, uint32_t> > m_floodingLinks;
+    bool m_floodingTopologyValid;
+    bool m_floodingTopologyConnected;
+
+public:
+    std::set<OSPFLinkStateIdentifier> m_routerLSA_set;
+    std::set<OSPFLinkStateIdentifier> m_networkLSA_set;
+    std::set<OSPFLinkStateIdentifier> m_intraAreaPrefixLSA_set;
+    std::set<OSPFLinkStateIdentifier> m_interAreaPrefixLSA_set;
+
+    AreaData () : m_areaId(0), m_nextSummaryLsId(1), m_stub(false), m_noSummary(false), m_stubDefaultCost(1),
+                  m_floodingTopologyValid(false), m_floodingTopologyConnected(false) {}
+    AreaData (uint32_t areaId) : m_areaId(areaId), m_nextSummaryLsId(1), m_stub(false), m_noSummary(false), m_stubDefaultCost(1),
+                                 m_floodingTopologyValid(false), m_floodingTopologyConnected(false) {}
+
+    uint32_t GetAreaId () const {
+        return m_areaId;
+    }
+    bool IsBackbone () const {
+        return m_areaId == g_backboneAreaId;
+    }
+
+    void SetStub (bool noSummary, uint32_t defaultCost) {
+        m_stub = true;
+        m_noSummary = noSummary;
+        m_stubDefaultCost = defaultCost;
+    }
+    bool IsStub () const {
+        return m_stub;
+    }
+    bool IsTotallyStubby () const {
+        return m_stub && m_noSummary;
+    }
+    uint32_t GetStubDefaultCost () const {
+        return m_stubDefaultCost;
+    }
+
+    OSPFLSDB& GetLSDB () {
+        return m_lsdb;
+    }
+
+    void AddRange (Ipv6Address prefix, uint8_t prefixLength, bool advertise) {
+        AreaRange range;
+        range.m_prefix = prefix.CombinePrefix(Ipv6Prefix(prefixLength));
+        range.m_prefixLength = prefixLength;
+        range.m_advertise = advertise;
+        m_ranges.push_back(range);
+    }
+
+    // 最も長い範囲を返す、なければnullptr
+    const AreaRange* FindRange (const Ipv6Address& addr, uint8_t prefixLength) const {
+        const AreaRange* found = nullptr;
+        for (const AreaRange& range : m_ranges) {
+            if (range.Contains(addr, prefixLength) && (!found || found->m_prefixLength < range.m_prefixLength)) {
+                found = &range;
+            }
+        }
+        return found;
+    }
+
+    std::map<AreaRoutePrefix, uint32_t>& GetSummaryLsIds () {
+        return m_summaryLsIds;
+    }
+    uint32_t GetSummaryLsId (const AreaRoutePrefix& prefix) {
+        auto it = m_summaryLsIds.find(prefix);
+        if (it != m_summaryLsIds.end()) {
+            return it->second;
+        }
+        return m_summaryLsIds[prefix] = m_nextSummaryLsId++;
+    }
+    bool HasSummaryLsId (uint32_t lsId) const {
+        for (auto& kv : m_summaryLsIds) {
+            if (kv.second == lsId) return true;
+        }
+        return false;
+    }
+
+    void InvalidateFloodingTopology () {
+        m_floodingTopologyValid = false;
+    }
+    bool IsFloodingTopologyValid () const {
+        return m_floodingTopologyValid;
+    }
+    // connectedでなければ分断しているので、全てのリンクにフラッディングする
+    void SetFloodingTopology (const std::set<std::pair<uint32_t, uint32_t> >& links, bool connected) {
+        m_floodingLinks = links;
+        m_floodingTopologyConnected = connected;
+        m_floodingTopologyValid = true;
+    }
+    bool IsFloodingTopologyConnected () const {
+        return m_floodingTopologyConnected;
+    }
+    bool IsOnFloodingTopology (uint32_t a, uint32_t b) const {
+        return m_floodingLinks.count(a < b ? std::make_pair(a, b) : std::make_pair(b, a));
+    }
+    const std::set<std::pair<uint32_t, uint32_t> >& GetFloodingLinks () const {
+        return m_floodingLinks;
+    }
+};
+
+}
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "ns3/timer.h"
 #include "ns3/callback.h"
+#include "ns3/packet.h"
 #include "ospf-struct-neighbor.h"
 #include "ospf-lsa-header.h"
 #include "ospf-lsa.h"
@@ -70,15 +71,18 @@ class InterfaceData {
     std::set<OSPFLinkStateIdentifier> m_linkLocalLsa_set;
     Timer m_helloTimer; // helloIntervalごと
     Timer m_waitTimer; // WaitingになったらrouterDeadInterval後
+    Timer m_livenessTimer; // 生存確認プローブの送信と、全ネイバーの検出時間超過チェック
     std::map<RouterId, NeighborData> m_neighbors;
     RouterId m_designatedRouterId;
     RouterId m_backupDesignatedRouterId;
-    uint32_t m_ifaceOutputCost;
+    uint32_t m_ifaceOutputCost; // 計算済みのメトリック、0なら未計算
     Time m_rxmtInterval;
     uint16_t m_auType;
     uint8_t m_authenticationKey[8];
     std::map<RouterId, std::vector<Ipv6Address> > m_prefixAddrs;
     std::map<RouterId, std::vector<uint8_t> > m_prefixLengthes;
+    Ptr<Packet> m_helloCache; // チェックサムまで埋めたHello、内容が変わるときに破棄する
+    Ptr<Packet> m_livenessProbeCache;
 
 public:
     InterfaceData () {
@@ -91,31 +95,35 @@ public:
         m_helloInterval = Seconds(10.0);
         m_routerDeadInterval = Seconds(40.0);
         m_ifaceTransDelay = 1;
-        // m_routerPriority;
+        m_routerPriority = 1;
         m_designatedRouterId = 0;
         m_backupDesignatedRouterId = 0;
-        m_ifaceOutputCost = 1;
+        m_ifaceOutputCost = 0;
         m_rxmtInterval = Seconds(5.0);
         m_auType = 0;
         m_helloTimer = Timer(Timer::REMOVE_ON_DESTROY);
         m_helloTimer.SetDelay(m_helloInterval);
         m_waitTimer = Timer(Timer::REMOVE_ON_DESTROY);
         m_waitTimer.SetDelay(m_routerDeadInterval);
+        m_livenessTimer = Timer(Timer::REMOVE_ON_DESTROY);
         std::fill(m_authenticationKey, m_authenticationKey+8, 0);
     }
 
+    // 所属エリアは設定値なので残す(次のInterfaceUpでm_interfaceAreasから再設定される)
     void ResetInstance () {
-        m_areaId = 1;
         m_helloInterval = Seconds(10.0);
         m_routerDeadInterval = Seconds(40.0);
         m_ifaceTransDelay = 1;
         m_designatedRouterId = 0;
         m_backupDesignatedRouterId = 0;
-        m_ifaceOutputCost = 1;
+        m_ifaceOutputCost = 0;
         m_rxmtInterval = Seconds(5.0);
         m_auType = 0;
         m_helloTimer.Cancel();
         m_waitTimer.Cancel();
+        m_livenessTimer.Cancel();
+        InvalidateHelloCache();
+        m_livenessProbeCache = 0;
     }
 
     void SetType(InterfaceType type) {
@@ -156,11 +164,18 @@ public:
         return m_areaId;
     }
 
-    Time& GetHelloInterval () {
+    void SetAreaId (uint32_t areaId) {
+        m_areaId = areaId;
+        InvalidateHelloCache();
+        m_livenessProbeCache = 0;
+    }
+
+    // Helloの中身になるので、変更はキャッシュを無効にする経路からだけ行う
+    const Time& GetHelloInterval () const {
         return m_helloInterval;
     }
 
-    Time& GetRouterDeadInterval () {
+    const Time& GetRouterDeadInterval () const {
         return m_routerDeadInterval;
     }
 
@@ -180,6 +195,13 @@ public:
         return m_routerPriority;
     }
 
+    void SetRouterPriority (uint8_t priority) {
+        if (m_routerPriority != priority) {
+            m_routerPriority = priority;
+            InvalidateHelloCache();
+        }
+    }
+
     void AddLinkLocalLSA(RouterId routerId, Ptr<OSPFLSA> lsa) {
         m_linkLocalLsa_set.insert(lsa->GetIdentifier());
         auto lsBody = lsa->GetBody<OSPFLinkLSABody>();
@@ -228,6 +250,16 @@ public:
         }
         return ret;
     }
+    // LSAの広告に使うので、Graceful Restartのhelper中のネイバーもFULLとして数える
+    uint32_t CountFullNeighbors () const {
+        uint32_t ret = 0;
+        for (auto& kv : m_neighbors) {
+            if (kv.second.IsAdvertisedFull()) {
+                ret++;
+            }
+        }
+        return ret;
+    }
     std::vector<RouterId> GetActiveNeighbors() const {
         std::vector<RouterId> neighs;
         for (auto& kv : m_neighbors) {
@@ -248,10 +280,24 @@ public:
         return m_designatedRouterId;
     }
 
+    void SetDesignatedRouter(RouterId routerId) {
+        if (m_designatedRouterId != routerId) {
+            m_designatedRouterId = routerId;
+            InvalidateHelloCache();
+        }
+    }
+
     RouterId GetBackupDesignatedRouter() const {
         return m_backupDesignatedRouterId;
     }
 
+    void SetBackupDesignatedRouter(RouterId routerId) {
+        if (m_backupDesignatedRouterId != routerId) {
+            m_backupDesignatedRouterId = routerId;
+            InvalidateHelloCache();
+        }
+    }
+
     bool HasExchangingNeighbor () const {
         for (auto& kv : m_neighbors) {
             if (
@@ -308,6 +354,47 @@ public:
         m_helloTimer.Schedule();
     }
 
+    uint32_t GetOutputCost () const {
+        return m_ifaceOutputCost;
+    }
+
+    void SetOutputCost (uint32_t cost) {
+        m_ifaceOutputCost = cost;
+    }
+
+    void InvalidateOutputCost () {
+        m_ifaceOutputCost = 0;
+    }
+
+    // Helloの中身(TWOWAY以上のネイバー, DR/BDR, 各タイマー, 送信元アドレス)が変わったら呼ぶ
+    void InvalidateHelloCache () {
+        m_helloCache = 0;
+    }
+
+    Ptr<Packet> GetHelloCache () const {
+        return m_helloCache;
+    }
+
+    void SetHelloCache (Ptr<Packet> packet) {
+        m_helloCache = packet;
+    }
+
+    Timer& GetLivenessTimer () {
+        return m_livenessTimer;
+    }
+
+    void ScheduleLiveness () {
+        m_livenessTimer.Schedule();
+    }
+
+    Ptr<Packet> GetLivenessProbeCache () const {
+        return m_livenessProbeCache;
+    }
+
+    void SetLivenessProbeCache (Ptr<Packet> packet) {
+        m_livenessProbeCache = packet;
+    }
+
     bool IsActive () {
         return !(
             IsState(InterfaceState::DOWN) ||
@@ -315,12 +402,81 @@ public:
         );
     }
 
-    void CalcDesignatedRouter() {
-        // OSPFv2 9.4 Electioning the Designated Router
-        // https://tools.ietf.org/html/rfc2328#page-75
+    // OSPFv2 9.4 Electioning the Designated Router
+    // https://tools.ietf.org/html/rfc2328#page-75
+    // 結果によってDR, BDR, DR_OTHERをSetStateする
+    // DRかBDRが変わったらtrueを返すので、呼び出し側はTWOWAY以上の全ネイバーにAdjOK?を発行すること
+    bool CalcDesignatedRouter(RouterId selfRouterId) {
+        RouterId oldDr = m_designatedRouterId, oldBdr = m_backupDesignatedRouterId;
+        RouterId dr, bdr;
+        ElectDesignatedRouter(selfRouterId, oldDr, oldBdr, dr, bdr);
+
+        // (4) 自身が新たにDR/BDRになった、あるいはDR/BDRでなくなったなら、自身の宣言を更新してもう一度選ぶ
+        if (
+            (dr == selfRouterId) != (oldDr == selfRouterId) ||
+            (bdr == selfRouterId) != (oldBdr == selfRouterId)
+        ) {
+            ElectDesignatedRouter(selfRouterId, dr, bdr, dr, bdr);
+        }
+
+        SetDesignatedRouter(dr);
+        SetBackupDesignatedRouter(bdr);
+        if (dr == selfRouterId) {
+            SetState(InterfaceState::DR);
+        } else if (bdr == selfRouterId) {
+            SetState(InterfaceState::BACKUP);
+        } else {
+            SetState(InterfaceState::DR_OTHER);
+        }
+        return dr != oldDr || bdr != oldBdr;
+    }
+
+private:
+    // 候補はPriorityが1以上の自身と、TWOWAY以上のネイバー
+    // selfDr, selfBdrは自身の宣言として扱う値
+    void ElectDesignatedRouter(RouterId selfRouterId, RouterId selfDr, RouterId selfBdr, RouterId& dr, RouterId& bdr) {
+        struct Candidate {
+            RouterId id;
+            uint8_t priority;
+            RouterId declaredDr;
+            RouterId declaredBdr;
+            bool IsPreferredTo(const Candidate& other) const {
+                return priority > other.priority || (priority == other.priority && id > other.id);
+            }
+        };
+        std::vector<Candidate> candidates;
+        if (IsEligibleToDR()) {
+            candidates.push_back(Candidate{selfRouterId, m_routerPriority, selfDr, selfBdr});
+        }
+        for (auto& kv : m_neighbors) {
+            NeighborData& neighData = kv.second;
+            if (neighData.GetState() < NeighborState::TWOWAY || !neighData.IsEligibleToDR()) continue;
+            candidates.push_back(Candidate{kv.first, neighData.GetRouterPriority(), neighData.GetDesignatedRouter(), neighData.GetBackupDesignatedRouter()});
+        }
 
-        // XXX: 今の所いらないので使うときに書いてください
-        // 結果によってDR, BDR, DR_OTHERをSetStateして抜けてください
+        // (2) BDR: 自身をDRと宣言していない候補のうち、BDRを宣言しているものを優先する
+        const Candidate* bestBdr = nullptr;
+        bool declaredBdrFound = false;
+        for (const Candidate& c : candidates) {
+            if (c.declaredDr == c.id) continue;
+            bool declared = c.declaredBdr == c.id;
+            if (declaredBdrFound && !declared) continue;
+            if (!bestBdr || (declared && !declaredBdrFound) || c.IsPreferredTo(*bestBdr)) {
+                bestBdr = &c;
+                declaredBdrFound = declared;
+            }
+        }
+        bdr = bestBdr ? bestBdr->id : 0;
+
+        // (3) DR: 自身をDRと宣言している候補から選ぶ。いなければBDRが昇格する
+        const Candidate* bestDr = nullptr;
+        for (const Candidate& c : candidates) {
+            if (c.declaredDr != c.id) continue;
+            if (!bestDr || c.IsPreferredTo(*bestDr)) {
+                bestDr = &c;
+            }
+        }
+        dr = bestDr ? bestDr->id : bdr;
     }
 };
 
@@ -4,13 +4,18 @@
 #include "ns3/timer.h"
 #include "ns3/callback.h"
 #include "ns3/ipv6-address.h"
-#include "ospf-hello.h"
+#include "ns3/event-id.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
 #include "ospf-database-description.h"
+#include "ospf-packet-view.h"
 #include "ospf-lsa.h"
 #include "ospf-lsa-header.h"
+#include "ospf-link-state-database.h"
 #include "ospf-constants.h"
 #include <vector>
 #include <map>
+#include <set>
 #include <algorithm>
 
 namespace ns3 {
@@ -57,9 +62,11 @@ class NeighborData {
     NeighborState m_state;
     Timer m_inactivityTimer; // 初期値はrouterDeadInterval, HelloPacket受信でリセット
     Timer m_lastReceivedDdClearTimer; // 初期値はrouterDeadInterval, HelloPacket受信でリセット
+    bool m_livenessUp; // 生存確認プローブを1度でも受け取ったら監視対象にする
+    Time m_lastLivenessProbe;
     bool m_isMaster; // ExStart時に決定
     int32_t m_ddSeqNum;
-    OSPFDatabaseDescription* m_lastReceivedDd;
+    OSPFDatabaseDescription m_lastReceivedDd; // LSAHeader部は保持しない
     uint32_t m_routerId;
     uint8_t m_routerPriority;
     uint32_t m_routerIfaceId;
@@ -67,8 +74,30 @@ class NeighborData {
     RouterId m_designatedRouterId;
     RouterId m_backupDesignatedRouterId;
     std::vector<Ptr<OSPFLSA> > m_lsRxmtList;
-    std::vector<Ptr<OSPFLSAHeader> > m_lsRequestList;
-    std::vector<Ptr<OSPFLSAHeader> > m_lsdbSummaryList;
+    std::vector<OSPFLSAHeader> m_lsRequestList;
+    std::vector<OSPFLSAHeader> m_lsdbSummaryList;
+
+    // 窓付きDD交換
+    // master: 未確認のDD、slave: 応答済みのDD(重複を受け取ったら再送する)
+    bool m_ddWindowed;
+    std::map<int32_t, Ptr<Packet> > m_ddWindowPackets;
+    bool m_ddPeerMore; // 相手が最後に送ってきたDDのMビット
+    int32_t m_ddPeerMoreSeqNum;
+    EventId m_ddRxmtEvent;
+
+    // 窓付きフラッディング: Rxmt Listの先頭m_rxmtSent個が送信済みで確認応答待ち
+    // 確認応答待ちのLSA数をm_floodWindowまでに抑え、LSAckで広げ、再送タイムアウトで縮める(TCPの輻輳制御と同じ)
+    uint32_t m_rxmtSent;
+    uint32_t m_floodWindow; // 0なら未初期化
+    uint32_t m_floodSsthresh;
+    uint32_t m_floodAckCount; // 輻輳回避中に窓を1広げるまでの確認応答数
+    Time m_floodProgress; // 最後に確認応答を受け取ったか、送信を再開した時刻
+    EventId m_floodEvent;
+
+    // Graceful Restartのhelper(RFC 3623 3)
+    // 猶予期間の間は、状態にかかわらずこのネイバーへの隣接をFULLとして広告し続ける
+    bool m_helpingRestart;
+    EventId m_graceTimer;
 
     bool m_initialized;
 
@@ -77,10 +106,20 @@ public:
         m_state = NeighborState::DOWN;
         m_ddSeqNum = 0;
 
+        m_routerPriority = 0;
         m_designatedRouterId = 0;
         m_backupDesignatedRouterId = 0;
 
         m_initialized = false;
+        m_livenessUp = false;
+        m_ddWindowed = false;
+        m_ddPeerMore = true;
+        m_ddPeerMoreSeqNum = 0;
+        m_helpingRestart = false;
+        m_rxmtSent = 0;
+        m_floodWindow = 0;
+        m_floodSsthresh = 0;
+        m_floodAckCount = 0;
     }
     ~NeighborData () {
         m_lsRxmtList.clear();
@@ -92,14 +131,14 @@ public:
         return m_initialized;
     }
 
-    void MinimalInitialize (Ipv6Address &addr, OSPFHello &hello) {
-        m_routerId = hello.GetRouterId();
+    void MinimalInitialize (Ipv6Address &addr, RouterId routerId, const OSPFHelloView &hello) {
+        m_routerId = routerId;
         m_routerIfaceId = hello.GetInterfaceId();
         m_addr = addr;
     }
 
-    void Initialize (Ipv6Address &addr, OSPFHello &hello) {
-        m_routerId = hello.GetRouterId();
+    void Initialize (Ipv6Address &addr, RouterId routerId, const OSPFHelloView &hello) {
+        m_routerId = routerId;
         m_routerPriority = hello.GetRouterPriority();
         m_routerIfaceId = hello.GetInterfaceId();
         m_addr = addr;
@@ -112,9 +151,16 @@ public:
         return m_routerIfaceId;
     }
 
-    void SetLastReceivedDD(OSPFDatabaseDescription dd) {
-        dd.GetLSAHeaders().clear(); // コピーされているので問題ないはず
-        m_lastReceivedDd = new OSPFDatabaseDescription(dd);
+    // LビットはLLSデータブロックの有無を示すだけなので、Optionsの比較から外す
+    // LSDBダイジェストはLLSを読んだ側で設定する
+    void SetLastReceivedDD(const OSPFDatabaseDescriptionView &dd) {
+        m_lastReceivedDd.SetOptions(dd.GetOptions() & ~OSPF_OPTION_L);
+        m_lastReceivedDd.SetLsdbDigest(std::vector<uint32_t>());
+        m_lastReceivedDd.SetMtu(dd.GetMtu());
+        m_lastReceivedDd.SetInitFlag(dd.GetInitFlag());
+        m_lastReceivedDd.SetMoreFlag(dd.GetMoreFlag());
+        m_lastReceivedDd.SetMasterFlag(dd.GetMasterFlag());
+        m_lastReceivedDd.SetSequenceNumber(dd.GetSequenceNumber());
     }
 
     void SetSequenceNumber(int32_t seqNum) {
@@ -130,17 +176,34 @@ public:
     }
 
     OSPFDatabaseDescription& GetLastPacket() {
-        return *m_lastReceivedDd;
+        return m_lastReceivedDd;
     }
 
     void ClearLastPacket() {
-        m_lastReceivedDd = nullptr;
+        m_lastReceivedDd = OSPFDatabaseDescription();
     }
 
     Timer& GetInactivityTimer () {
         return m_inactivityTimer;
     }
 
+    void ReceiveLivenessProbe (Time now) {
+        m_livenessUp = true;
+        m_lastLivenessProbe = now;
+    }
+
+    bool IsLivenessUp () const {
+        return m_livenessUp;
+    }
+
+    Time GetLastLivenessProbe () const {
+        return m_lastLivenessProbe;
+    }
+
+    void ResetLiveness () {
+        m_livenessUp = false;
+    }
+
     Timer& GetLastPacketClearTimer () {
         return m_lastReceivedDdClearTimer;
     }
@@ -159,6 +222,35 @@ public:
         return m_state == s;
     }
 
+    // Router-LSAやNetwork-LSAに隣接として載せるか
+    bool IsAdvertisedFull() const {
+        return m_state == NeighborState::FULL || m_helpingRestart;
+    }
+
+    // graceTimerは猶予期間の満了でhelperをやめるイベント
+    void SetHelpingRestart(EventId graceTimer) {
+        m_graceTimer.Cancel();
+        m_graceTimer = graceTimer;
+        m_helpingRestart = true;
+    }
+
+    void ClearHelpingRestart() {
+        m_graceTimer.Cancel();
+        m_helpingRestart = false;
+    }
+
+    bool IsHelpingRestart() const {
+        return m_helpingRestart;
+    }
+
+    // RFC 3623 3.1 再送待ちに内容の変わったLSAがあれば、LSDBは一致していない
+    bool HasChangedLSAInRxmtList(const OSPFLSDB& lsdb) const {
+        for (auto& lsa : m_lsRxmtList) {
+            if (!lsa->GetHeader().IsLinkLocalScope() && lsdb.IsChangedInstance(lsa)) return true;
+        }
+        return false;
+    }
+
     uint8_t GetRouterPriority () const {
         return m_routerPriority;
     }
@@ -223,7 +315,7 @@ public:
     bool HasInRxmtList (OSPFLinkStateIdentifier &id) {
         for (auto item : m_lsRxmtList) {
             // ここにあるLSAは中身が入っているはず
-            if (*item->GetHeader() == id) {
+            if (item->GetHeader() == id) {
                 return true;
             }
         }
@@ -233,7 +325,7 @@ public:
     Ptr<OSPFLSA> GetFromRxmtList (OSPFLinkStateIdentifier &id) {
         for (auto item : m_lsRxmtList) {
             // ここにあるLSAは中身が入っているはず
-            if (*item->GetHeader() == id) {
+            if (item->GetHeader() == id) {
                 return item;
             }
         }
@@ -243,40 +335,119 @@ public:
     void RemoveFromRxmtList(OSPFLinkStateIdentifier id) {
         for (auto itr = m_lsRxmtList.begin(); itr != m_lsRxmtList.end(); ) {
             if (**itr == id) {
-                itr = m_lsRxmtList.erase(itr);
+                itr = EraseFromRxmtList(itr);
             } else {
                 itr++;
             }
         }
     }
 
-    std::vector<Ptr<OSPFLSAHeader> >& GetRequestList () {
+    // 同じインスタンスへの確認応答ならRxmt Listから外す
+    bool AckRxmtList(const OSPFLSAHeader& ackedLsaHdr) {
+        for (auto itr = m_lsRxmtList.begin(); itr != m_lsRxmtList.end(); ++itr) {
+            if (ackedLsaHdr.IsSameInstance((*itr)->GetHeader())) {
+                EraseFromRxmtList(itr);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Ptr<OSPFLSA> >::iterator EraseFromRxmtList(std::vector<Ptr<OSPFLSA> >::iterator itr) {
+        if (m_rxmtSent > (uint32_t)(itr - m_lsRxmtList.begin())) {
+            --m_rxmtSent;
+        }
+        return m_lsRxmtList.erase(itr);
+    }
+
+    void InitializeFloodWindow (uint32_t initialWindow) {
+        if (m_floodWindow == 0) {
+            m_floodWindow = initialWindow;
+            m_floodSsthresh = UINT32_MAX;
+            m_floodAckCount = 0;
+        }
+    }
+
+    uint32_t GetFloodWindow () const {
+        return m_floodWindow;
+    }
+
+    uint32_t GetRxmtSentCount () const {
+        return m_rxmtSent;
+    }
+
+    Time GetFloodProgress () const {
+        return m_floodProgress;
+    }
+
+    EventId& GetFloodEvent () {
+        return m_floodEvent;
+    }
+
+    // 未送信のLSAを窓の空きとmaxBytesに収まるだけ取り出し、送信済みにする
+    // 先頭のLSAはmaxBytesより大きくても1つだけで取り出す。そうしないと窓が進まなくなる
+    std::vector<Ptr<OSPFLSA> > TakeUnsentRxmt (int32_t maxBytes) {
+        std::vector<Ptr<OSPFLSA> > ret;
+        if (m_rxmtSent == 0) {
+            m_floodProgress = Simulator::Now();
+        }
+        while (m_rxmtSent < m_lsRxmtList.size() && m_rxmtSent < m_floodWindow) {
+            int32_t size = m_lsRxmtList[m_rxmtSent]->GetSerializedSize();
+            if (!ret.empty() && maxBytes - size < 0) break;
+            maxBytes -= size;
+            ret.push_back(m_lsRxmtList[m_rxmtSent]);
+            ++m_rxmtSent;
+        }
+        return ret;
+    }
+
+    // スロースタートの間は確認応答ごとに1、輻輳回避に入ったら窓1つ分の確認応答ごとに1広げる
+    void OnFloodAcked () {
+        m_floodProgress = Simulator::Now();
+        if (m_floodWindow < m_floodSsthresh) {
+            ++m_floodWindow;
+        } else if (++m_floodAckCount >= m_floodWindow) {
+            m_floodAckCount = 0;
+            ++m_floodWindow;
+        }
+    }
+
+    // 再送タイムアウト: 閾値を半分にして初期窓からやり直し、確認応答待ちのLSAを全て再送対象に戻す
+    void OnFloodTimeout (uint32_t initialWindow) {
+        m_floodSsthresh = std::max(m_floodWindow / 2, initialWindow);
+        m_floodWindow = initialWindow;
+        m_floodAckCount = 0;
+        m_rxmtSent = 0;
+    }
+
+    std::vector<OSPFLSAHeader>& GetRequestList () {
         return m_lsRequestList;
     }
 
-    void AddRequestList (Ptr<OSPFLSAHeader> header) {
+    void AddRequestList (const OSPFLSAHeader& header) {
         m_lsRequestList.push_back(header);
     }
 
     bool HasInRequestList (OSPFLinkStateIdentifier &id) {
-        for (auto item : m_lsRequestList) {
-            if (*item == id) return true;
+        for (auto& item : m_lsRequestList) {
+            if (item == id) return true;
         }
         return false;
     }
 
-    Ptr<OSPFLSAHeader> GetFromRequestList (OSPFLinkStateIdentifier &id) {
-        for (auto item : m_lsRequestList) {
-            if (*item == id) {
-                return item;
+    // 見つからなければnullptr
+    OSPFLSAHeader* GetFromRequestList (OSPFLinkStateIdentifier &id) {
+        for (auto& item : m_lsRequestList) {
+            if (item == id) {
+                return &item;
             }
         }
-        return 0;
+        return nullptr;
     }
 
     void RemoveFromRequestList(OSPFLinkStateIdentifier &id) {
         for (auto itr = m_lsRequestList.begin(); itr != m_lsRequestList.end(); ) {
-            if (**itr == id) {
+            if (*itr == id) {
                 itr = m_lsRequestList.erase(itr);
             } else {
                 itr++;
@@ -284,21 +455,21 @@ public:
         }
     }
 
-    std::vector<Ptr<OSPFLSAHeader> > GetRequestList (uint32_t maxBytes) {
-        std::vector<Ptr<OSPFLSAHeader> > ret;
+    std::vector<OSPFLSAHeader> GetRequestList (uint32_t maxBytes) {
+        std::vector<OSPFLSAHeader> ret;
         for (int i = 0, l = std::min(m_lsRequestList.size(), (unsigned long)(maxBytes / 20)); i < l; ++i) {
             ret.push_back(m_lsRequestList[i]);
         }
         return ret;
     }
 
-    void SetSummaryList (std::vector<Ptr<OSPFLSAHeader> > summary) {
-        m_lsdbSummaryList = summary;
+    void SetSummaryList (std::vector<OSPFLSAHeader>& summary) {
+        m_lsdbSummaryList.swap(summary);
     }
 
     void RemoveFromSummaryList(OSPFLinkStateIdentifier &id) {
         for (auto itr = m_lsdbSummaryList.begin(); itr != m_lsdbSummaryList.end(); ) {
-            if (**itr == id) {
+            if (*itr == id) {
                 itr = m_lsdbSummaryList.erase(itr);
             } else {
                 itr++;
@@ -306,11 +477,22 @@ public:
         }
     }
 
+    // 1つのDDに載っていた分をまとめて外す
+    void RemoveFromSummaryList(const std::set<OSPFLinkStateIdentifier> &ids) {
+        if (ids.empty()) return;
+        m_lsdbSummaryList.erase(
+            std::remove_if(m_lsdbSummaryList.begin(), m_lsdbSummaryList.end(), [&ids](const OSPFLSAHeader& hdr) {
+                return ids.count(hdr.CreateIdentifier()) > 0;
+            }),
+            m_lsdbSummaryList.end()
+        );
+    }
+
     uint32_t GetSummaryListSize () {
         return m_lsdbSummaryList.size();
     }
-    std::vector<Ptr<OSPFLSAHeader> > GetSummaryList (uint32_t maxBytes) {
-        std::vector<Ptr<OSPFLSAHeader> > ret;
+    std::vector<OSPFLSAHeader> GetSummaryList (uint32_t maxBytes) {
+        std::vector<OSPFLSAHeader> ret;
         for (int i = maxBytes / 20; i && !m_lsdbSummaryList.empty(); --i) {
             ret.push_back(m_lsdbSummaryList.back());
             m_lsdbSummaryList.pop_back();
@@ -345,8 +527,82 @@ public:
 
     void ClearList() {
         m_lsRxmtList.clear();
+        m_rxmtSent = 0;
+        m_floodWindow = 0;
+        m_floodEvent.Cancel();
         m_lsRequestList.clear();
         m_lsdbSummaryList.clear();
+        ClearDdWindow();
+    }
+
+    void SetDdWindowed (bool windowed) {
+        m_ddWindowed = windowed;
+        m_ddPeerMore = true;
+        m_ddPeerMoreSeqNum = 0;
+    }
+
+    bool IsDdWindowed () const {
+        return m_ddWindowed;
+    }
+
+    void AddDdWindowPacket (int32_t seqNum, Ptr<Packet> packet) {
+        m_ddWindowPackets[seqNum] = packet;
+    }
+
+    // なければ0
+    Ptr<Packet> GetDdWindowPacket (int32_t seqNum) const {
+        auto itr = m_ddWindowPackets.find(seqNum);
+        return itr == m_ddWindowPackets.end() ? Ptr<Packet>(0) : itr->second;
+    }
+
+    bool RemoveDdWindowPacket (int32_t seqNum) {
+        return m_ddWindowPackets.erase(seqNum);
+    }
+
+    std::map<int32_t, Ptr<Packet> >& GetDdWindowPackets () {
+        return m_ddWindowPackets;
+    }
+
+    uint32_t CountDdWindowPackets () const {
+        return m_ddWindowPackets.size();
+    }
+
+    // 取りこぼしなく受け取れている最大のseq
+    int32_t GetDdContiguousSequenceNumber (int32_t base) const {
+        while (m_ddWindowPackets.count(base + 1)) base++;
+        return base;
+    }
+
+    int32_t GetDdMaxSequenceNumber (int32_t base) const {
+        return m_ddWindowPackets.empty() ? base : std::max(base, m_ddWindowPackets.rbegin()->first);
+    }
+
+    // 順序が入れ替わっても最新のseqのMビットを使う
+    void SetDdPeerMore (int32_t seqNum, bool more) {
+        if (seqNum >= m_ddPeerMoreSeqNum) {
+            m_ddPeerMoreSeqNum = seqNum;
+            m_ddPeerMore = more;
+        }
+    }
+
+    bool IsDdPeerMore () const {
+        return m_ddPeerMore;
+    }
+
+    EventId& GetDdRxmtEvent () {
+        return m_ddRxmtEvent;
+    }
+
+    void ClearDdWindow () {
+        m_ddWindowPackets.clear();
+        m_ddRxmtEvent.Cancel();
+    }
+
+    // slaveが完了後もしばらく保持していた応答を捨てる。新しい交換が始まっていれば何もしない
+    void ReleaseDdWindow () {
+        if (m_state != NeighborState::EXCHANGE) {
+            ClearDdWindow();
+        }
     }
 };
 
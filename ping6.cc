@@ -22,7 +22,7 @@ NS_LOG_COMPONENT_DEFINE ("Ping6Example");
 #if 1
 int main (int argc, char **argv)
 {
-  bool verbose = false, printTable = false, withTraceFile = false;
+  bool verbose = false, printTable = false, withTraceFile = false, controlPriority = false;
   std::string inputFile = "", outputDir = "";
 
   CommandLine cmd;
@@ -31,6 +31,7 @@ int main (int argc, char **argv)
   cmd.AddValue ("inputFile", "input file name", inputFile);
   cmd.AddValue ("outputDir", "input directory name", outputDir);
   cmd.AddValue ("withTraceFile", "enable ascii traceFile", withTraceFile);
+  cmd.AddValue ("controlPriority", "send OSPF packets ahead of data on router links", controlPriority);
   cmd.Parse (argc, argv);
 
   std::cout << "verbose: " << std::boolalpha << verbose << std::noboolalpha << std::endl;
@@ -201,6 +202,11 @@ int main (int argc, char **argv)
   for (int i = 0, l = nodes; i < l; ++i) {
     ns.Get(i)->GetObject<Ipv6>()->SetRoutingProtocol(CreateObject<ospf::Ipv6OspfRouting>());
   }
+  if (controlPriority) {
+    for (int i = 0, l = conns; i < l; ++i) {
+      ipv6RoutingHelper.InstallControlPriorityQueueDisc(devs[i]);
+    }
+  }
   Ipv6StaticRoutingHelper staticRoutingHelper;
   Ptr<Ipv6StaticRouting> rt;
   for (int i = 0, l = hasPings.size(); i < l; ++i) {
@@ -7,6 +7,12 @@ void TestForOSPFDatabaseDescription();
 void TestForOSPFLinkStateRequest();
 void TestForOSPFLinkStateUpdate();
 void TestForOSPFLinkStateAck();
+void TestForOSPFLivenessProbe();
+void TestForOSPFMaxFlow();
+void TestForOSPFControlPriority();
+void TestForOSPFGraceLSA();
+void TestForOSPFLoopFreeAlternate();
+void BenchForOSPFReceivePath();
 
 #if 0
 int main () {
@@ -17,6 +23,12 @@ int main () {
     TestForOSPFLinkStateRequest();
     TestForOSPFLinkStateUpdate();
     TestForOSPFLinkStateAck();
+    TestForOSPFLivenessProbe();
+    TestForOSPFMaxFlow();
+    TestForOSPFControlPriority();
+    TestForOSPFGraceLSA();
+    TestForOSPFLoopFreeAlternate();
+    BenchForOSPFReceivePath();
     cout << "OSPF entrypoint - end" << endl;
 }
 #endif